@@ -254,7 +254,7 @@ void threadFunction1() {
     //bool hasLocked = false;
     //JDObject lockedPerson = nullptr;
 
-    QObject::connect(manager1, &JDManager::databaseFileChanged, [] {manager1->loadObjectsAsync(); });
+    QObject::connect(manager1, &JDManager::databaseFileChanged, [] {manager1->loadObjectsAsync(JsonDatabase::LoadMode::allObjects | JsonDatabase::LoadMode::incremental); });
     QObject::connect(manager1, &JDManager::saveObjectsDone, [](bool success)
         {
             std::cout << "Save Objects success: " << success << "\n";
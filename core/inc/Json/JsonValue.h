@@ -87,6 +87,11 @@ namespace JsonDatabase
 		bool operator==(const JsonValue& other) const;
 		bool operator!=(const JsonValue& other) const;
 
+		// Hash over the content, nested arrays and objects get hashed by their content, not by their pointer
+		unsigned long long getHash() const;
+		static unsigned long long getHash(const JsonArray& array);
+		static unsigned long long getHash(const JsonObject& object);
+
 
 
 		// Type trait to check if T is ObjectA
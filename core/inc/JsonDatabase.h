@@ -17,6 +17,7 @@
 #include "object/JDObjectInterface.h"
 #include "object/value/JDObjectValue.h"
 #include "object/value/IJDObjectValue.h"
+#include "changehistory/ChangeHistoryScope.h"
 #include "manager/JDManager.h"
 #include "utilities/ErrorCodes.h"
 
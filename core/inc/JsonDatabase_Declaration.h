@@ -11,6 +11,18 @@ namespace JsonDatabase
         allObjects = 7,
 
         //overrideChanges = 8,
+
+        // Only loads the objects that are listed in the change journal since the last load.
+        // Falls back to a full load if the journal does not reach back far enough.
+        incremental = 16,
+    };
+
+    // Defines how the assignments to JDObjectValue's get recorded as change transactions
+    enum class ChangeHistoryMode
+    {
+        off,        // Nothing gets recorded, an assignment does not allocate
+        ringBuffer, // Only the last n changes of each value are kept
+        full        // All changes are kept until the object gets saved or loaded
     };
     
     class JDManager;
@@ -50,6 +62,7 @@ namespace JsonDatabase
         class JDManagerObjectManager;
         class JDManagerSignals;
         class JDObjectLocker;
+        class JDChangeJournal;
 
         
         class JDObjectContainer;
@@ -75,6 +88,13 @@ namespace JsonDatabase
             saveSingleObject,
             saveAllObjects
         };
+        // Lane of the async worker pool, lower values get processed first
+        enum class WorkPriority
+        {
+            interactive,
+            normal,
+            bulk
+        };
 
 
 
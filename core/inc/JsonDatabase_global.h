@@ -55,6 +55,8 @@
 #define JDM_UNIQUE_LOCK_P Internal::JDUniqueMutexLock uniqueLock(m_mutex);
 #define JDM_UNIQUE_LOCK_M(MUT) std::unique_lock<std::mutex> lck(MUT);
 #define JDM_UNIQUE_LOCK_P_M(mutex) Internal::JDUniqueMutexLock uniqueLock(mutex);
+#define JDM_SHARED_LOCK_P_M(mutex) Internal::JDSharedMutexLock sharedLock(mutex, false);
+#define JDM_EXCLUSIVE_LOCK_P_M(mutex) Internal::JDSharedMutexLock exclusiveLock(mutex, true);
 /// USER_SECTION_END
 
 // Promote selected MSVC warnings to errors while compiling the library.
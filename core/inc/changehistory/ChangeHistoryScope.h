@@ -0,0 +1,43 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include "JsonDatabase_Declaration.h"
+
+namespace JsonDatabase
+{
+	/**
+	 * @brief
+	 * Overrides the change history mode of the JDManager for the current thread,
+	 * as long as the scope object exists. Scopes can be nested, the innermost one is used.
+	 * Objects which get instantiated inside a scope with ChangeHistoryMode::off
+	 * do not record their instantiation either.
+	 *
+	 * Usecase:
+	 *  {
+	 *      ChangeHistoryScope scope(ChangeHistoryMode::off);
+	 *      for(auto &obj : importedObjects)
+	 *          obj->value = ...; // No change transactions get allocated
+	 *  }
+	 */
+	class JSON_DATABASE_API ChangeHistoryScope
+	{
+	public:
+		ChangeHistoryScope(ChangeHistoryMode mode, size_t ringBufferSize = 16);
+		~ChangeHistoryScope();
+
+		ChangeHistoryScope(const ChangeHistoryScope&) = delete;
+		ChangeHistoryScope& operator=(const ChangeHistoryScope&) = delete;
+
+		/**
+		 * @brief
+		 * Gets the mode of the innermost scope of the current thread
+		 * @return false if the current thread is not inside a scope
+		 */
+		static bool getCurrentMode(ChangeHistoryMode& modeOut, size_t& ringBufferSizeOut);
+
+	private:
+		const ChangeHistoryScope* m_previous;
+		ChangeHistoryMode m_mode;
+		size_t m_ringBufferSize;
+	};
+}
@@ -58,6 +58,14 @@ namespace JsonDatabase
 
 		}
 
+		// Reuses the transaction for a new change of the same value
+		void setValues(const T& oldValue, const T& newValue)
+		{
+			m_oldValue = oldValue;
+			m_newValue = newValue;
+			m_timestamp = QDateTime::currentDateTime();
+		}
+
 		const T& getOldValue() const
 		{
 			return m_oldValue;
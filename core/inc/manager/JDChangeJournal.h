@@ -0,0 +1,142 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include "JsonDatabase_Declaration.h"
+#include "object/JDObjectID.h"
+#include "Json/JsonValue.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Logger.h"
+
+namespace JsonDatabase
+{
+	namespace Internal
+	{
+		/*
+			Bounded list of the latest object changes in the database file.
+			Each save appends one entry per saved or removed object.
+			An upsert entry contains the saved json of the object, so a client that
+			knows the sequence number of its last load can apply the changes since then
+			without reading the database file.
+
+			File format, one record per line:
+			  JDJ2;<epoch>;<first sequence>                                    header
+			  <sequence>;u;<generation>;<size>;<mtime>;<object json>           upsert
+			  <sequence>;r;<generation>;<size>;<mtime>;<object id json>        remove
+			Entries get appended to the end of the file. When the journal grows beyond
+			twice the max entry count, it gets compacted to the latest max entries.
+
+			The epoch changes whenever the journal gets reset, for example after it was found
+			corrupted. A client must not apply entries of another epoch than the one it knows.
+			Each entry stores the FileStamp of the database file after the write.
+			If the current database file does not match the stamp of the latest entry,
+			the file was written without a journal entry and a client must load all objects.
+
+			The journal file has no lock of its own, it is only accessed while
+			the database file is locked:
+			  - append() while the database file is locked for writing
+			  - read() while the database file is locked for reading
+		*/
+		class JSON_DATABASE_API JDChangeJournal
+		{
+		public:
+			enum class Operation
+			{
+				upsert,
+				remove
+			};
+			/*
+				Identifies a version of the database file.
+				The generation only changes on writes through LockedFileAccessor,
+				the size and the modification time also catch other writers.
+			*/
+			struct FileStamp
+			{
+				unsigned long long generation = 0;
+				unsigned long long fileSize = 0;
+				long long modificationTime = 0; // Ticks of the file clock
+
+				bool operator==(const FileStamp& other) const;
+				bool operator!=(const FileStamp& other) const;
+			};
+			struct Entry
+			{
+				int64_t sequence;
+				JDObjectID::IDType objectID;
+				Operation operation;
+				FileStamp fileStamp;
+				JsonObject data; // Saved object, only for Operation::upsert
+			};
+			struct State
+			{
+				std::string epoch;
+				int64_t firstSequence = 1;  // Oldest sequence number that is still in the journal
+				int64_t lastSequence = 0;   // Sequence number of the latest change
+				FileStamp lastFileStamp;    // Database file after the latest change
+			};
+
+			JDChangeJournal(const std::string& filePath, Log::LogObject* logger);
+			~JDChangeJournal();
+
+			const std::string& getFilePath() const;
+
+			/*
+				Appends the changes to the end of the journal.
+				A corrupted journal gets reset with a new epoch.
+				stateOut describes the journal after the append,
+				firstSequenceOut is the sequence number of the first appended entry.
+			*/
+			bool append(const std::vector<const JsonObject*>& upserted,
+						const std::vector<JDObjectID::IDType>& removed,
+						const FileStamp& fileStamp,
+						State& stateOut,
+						int64_t& firstSequenceOut);
+
+			/*
+				Reads the entries with a sequence number greater than afterSequence.
+				The json of older entries does not get parsed.
+				A missing journal file is read as an empty journal without epoch.
+			*/
+			bool read(int64_t afterSequence, std::vector<Entry>& entriesOut, State& stateOut) const;
+
+			/*
+				Reads only the header and the latest entry.
+			*/
+			bool readState(State& stateOut) const;
+
+			/*
+				Reads the generation, the size and the modification time of the database file.
+			*/
+			static bool readFileStamp(const std::string& databaseFilePath, FileStamp& stampOut);
+
+			static void setMaxEntries(size_t count);
+			static size_t getMaxEntries();
+
+		private:
+			static const std::string s_magic;
+
+			// Reads the whole journal as lines, the last line must be complete
+			bool readLines(std::vector<std::string>& linesOut) const;
+			bool parseHeader(const std::string& line, State& stateOut) const;
+			static bool parseEntryPrefix(const std::string& line, int64_t& sequenceOut, Operation& operationOut,
+										 FileStamp& fileStampOut, size_t& jsonPosOut);
+			bool parseEntry(const std::string& line, Entry& entryOut) const;
+			bool readLastLine(std::string& lineOut) const;
+
+			static std::string createEpoch();
+
+			// Replaces the journal file by writing a temporary file and renaming it
+			bool rewrite(const std::string& content) const;
+
+			static const std::string& operationToString(Operation op);
+
+			std::string m_filePath;
+			Log::LogObject* m_logger = nullptr;
+
+			static size_t s_maxEntries;
+		};
+	}
+}
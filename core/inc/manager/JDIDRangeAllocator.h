@@ -0,0 +1,60 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include "JsonDatabase_Declaration.h"
+#include "object/JDObjectID.h"
+
+#include <string>
+
+#include "Logger.h"
+
+namespace JsonDatabase
+{
+	namespace Internal
+	{
+		/*
+			Shared allocator record for object IDs.
+			The record only contains the next free ID of the database.
+			A session reserves a block of IDs by moving the next free ID forward,
+			the IDs of the block can then be handed out locally without checking
+			the database file for collisions.
+
+			The record has its own file lock, it is held only while the record gets
+			read and written. A write replaces the record through a temporary file,
+			so a missing record means that no IDs were reserved yet, while an empty
+			or unreadable record is an error.
+		*/
+		class JSON_DATABASE_API JDIDRangeAllocator
+		{
+		public:
+			JDIDRangeAllocator(const std::string& databasePath, Log::LogObject* logger);
+			~JDIDRangeAllocator();
+
+			/*
+				Reserves count IDs for this session.
+				minFirst is the lowest ID the block may start with, it is used for databases
+				which were created before the allocator record existed.
+				The reserved IDs are [firstOut, lastOut].
+			*/
+			bool reserve(size_t count,
+						 const JDObjectID::IDType& minFirst,
+						 unsigned int timeoutMs,
+						 JDObjectID::IDType& firstOut,
+						 JDObjectID::IDType& lastOut);
+
+			static const std::string s_fileName;
+		private:
+			struct JsonKeys
+			{
+				static const std::string next;
+			};
+
+			bool read(JDObjectID::IDType& nextOut) const;
+			bool write(const JDObjectID::IDType& next) const;
+			std::string getFilePath() const;
+
+			std::string m_databasePath;
+			Log::LogObject* m_logger = nullptr;
+		};
+	}
+}
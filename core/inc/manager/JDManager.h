@@ -6,8 +6,10 @@
 #include "async/JDManagerAsyncWorker.h"
 #include "async/work/JDManagerWorkLoadSingleObject.h"
 #include "async/WorkProgress.h"
+#include "async/JDAsyncHandle.h"
 #include "JDManagerFileSystem.h"
 #include "JDManagerObjectManager.h"
+#include "JDChangeJournal.h"
 
 
 #include "object/JDObjectInterface.h"
@@ -18,7 +20,11 @@
 #include "Logger.h"
 
 #include <string>
+#include <cstdint>
 #include <mutex>
+#include <atomic>
+#include <functional>
+#include <unordered_set>
 
 #include <QObject>
 #include <QTimer>
@@ -52,8 +58,18 @@ class JSON_DATABASE_API JDManager:
         JDManager(const JDManager &other);
         virtual ~JDManager();
 
+        /**
+         * @brief
+         * Sets the interval of the update loop while there is activity.
+         * While idle, the interval doubles on each update without activity,
+         * up to the max idle interval.
+         * File watcher events, async work and new signals wake up the update loop immediately.
+         * @param ms
+         */
         void setUpdateInterval(int ms);
-		int getUpdateInterval() const { return m_updateTimer.interval(); }
+		int getUpdateInterval() const { return m_updateIntervalMs; }
+        void setMaxIdleUpdateInterval(int ms);
+        int getMaxIdleUpdateInterval() const { return m_maxIdleUpdateIntervalMs; }
         bool setup(const std::string& databasePath,
                    const std::string& databaseName);
         bool setup(const std::string& databasePath,
@@ -88,12 +104,15 @@ class JSON_DATABASE_API JDManager:
          * @brief 
 		 * Overrides the data of the object with the data from the database file asynchronously.
 		 * @param obj which should be loaded from the database
+		 * @return handle to wait for, cancel or continue the work
          */
-        void loadObjectAsync(const JDObject &obj);
+        JDAsyncHandle loadObjectAsync(const JDObject &obj);
 
         /**
          * @brief 
 		 * Loads the objects from the database file.
+		 * Add LoadMode::incremental to the mode to only load the objects that
+		 * have changed since the last load, according to the change journal.
 		 * @param mode to define which objects should be loaded
 		 * @return true if the loading was successful, otherwise false
          */
@@ -111,9 +130,12 @@ class JSON_DATABASE_API JDManager:
         /**
          * @brief 
 		 * Loads the objects from the database file asynchronously.
+		 * A deadline or cancellation on the returned handle aborts the load
+		 * after the file got parsed, before the data gets applied to the objects.
 		 * @param mode to define which objects should be loaded
+		 * @return handle to wait for, cancel or continue the work
          */
-        void loadObjectsAsync(int mode = LoadMode::allObjects);
+        JDAsyncHandle loadObjectsAsync(int mode = LoadMode::allObjects);
 
         /**
          * @brief 
@@ -129,8 +151,9 @@ class JSON_DATABASE_API JDManager:
 		 * Tries to save the object to the database file asynchronously.
 		 * The object must be locked by this session.
 		 * @param obj to save to the database
+		 * @return handle to wait for, cancel or continue the work
          */
-        void saveObjectAsync(const JDObject &obj);
+        JDAsyncHandle saveObjectAsync(const JDObject &obj);
 
         /**
          * @brief 
@@ -154,15 +177,16 @@ class JSON_DATABASE_API JDManager:
 		 * Saves all objects which are locked by this user to the database file.
 		 * All objects must be locked by this session.
          */
-        void saveObjectsAsync();
+        JDAsyncHandle saveObjectsAsync();
 
         /**
          * @brief 
          * Saves all objects from the list to the database file asynchronously
          * All objects must be locked by this session.
          * @param objs 
+         * @return handle to wait for, cancel or continue the work
          */
-        void saveObjectsAsync(const std::vector<JDObject>& objs);
+        JDAsyncHandle saveObjectsAsync(const std::vector<JDObject>& objs);
 
         /**
          * @brief 
@@ -175,7 +199,7 @@ class JSON_DATABASE_API JDManager:
          * @brief 
          * Saves all objects that are locked by this session asynchronously
          */
-        void saveLockedObjectsAsync();
+        JDAsyncHandle saveLockedObjectsAsync();
 
 
 
@@ -214,6 +238,9 @@ class JSON_DATABASE_API JDManager:
             void objectAdded(std::vector<JDObject> objs);
 			void objectRemoved(std::vector<JDObject> objs);
             void objectChanged(std::vector<JDObject> objs);
+            // The lease of this session expired and another session locked these objects in the meantime.
+            // They are not locked by this session anymore, their changes can't be saved.
+            void objectLockLost(std::vector<JDObject> objs);
 
     public slots:
                 // Checks for changes in the database file
@@ -228,22 +255,35 @@ class JSON_DATABASE_API JDManager:
         
         bool loadObject_internal(const JDObject &obj, Internal::WorkProgress* progress);
         bool loadObjects_internal(int mode, Internal::WorkProgress* progress);
+        bool loadObjectsIncremental_internal(int mode, Internal::WorkProgress* progress, bool& fullLoadRequiredOut);
         bool saveObject_internal(const JDObject &obj, unsigned int timeoutMillis, Internal::WorkProgress* progress);
         bool saveObjects_internal(unsigned int timeoutMillis, Internal::WorkProgress* progress);
         bool saveObjects_internal(std::vector<JDObject> objList, unsigned int timeoutMillis, Internal::WorkProgress* progress);
 
+        // Must be called while the database file is locked for writing
+        void appendToChangeJournal(const std::vector<const JsonObject*>& upserted, 
+                                   const std::vector<JDObjectID::IDType>& removed, 
+                                   const std::string& databaseFilePath);
+
 
         void onAsyncWorkDone(std::shared_ptr<Internal::JDManagerAysncWork> work);
         void onAsyncWorkError(std::shared_ptr<Internal::JDManagerAysncWork> work);
 
         void onObjectLockerFileChanged();
 
-		void emitSignals();
+        // Thread safe, schedules an update in the thread of this QObject
+        void requestUpdate();
+        void onUpdateRequested();
+
+        // Returns true if any signal was emitted
+		bool emitSignals();
         
 
         Log::LogObject* m_logger = nullptr;
         Utilities::JDUser m_user;
 
+        // Serializes the file I/O of the load and save operations.
+        // The object container has its own reader/writer lock, readers don't wait for this mutex.
         mutable std::mutex m_mutex;
         mutable std::mutex m_updateMutex;
         bool m_useZipFormat;
@@ -251,6 +291,17 @@ class JSON_DATABASE_API JDManager:
         // Prevent multiple updates at the same time
         bool m_signalEntryUpdateLock;
         bool m_setUp = false;
+        int m_updateIntervalMs;
+        int m_maxIdleUpdateIntervalMs;
+        std::atomic<bool> m_updateRequested;
+
+        // Epoch and sequence number of the change journal, up to which the objects are loaded.
+        // The sequence is -1 if unknown.
+        // The file stamp is the one of the database file at that point.
+        std::mutex m_journalMutex;
+        std::string m_journalEpoch;
+        int64_t m_journalSequence;
+        Internal::JDChangeJournal::FileStamp m_journalFileStamp;
         QTimer m_updateTimer;
 
         struct SignalData
@@ -270,6 +321,7 @@ class JSON_DATABASE_API JDManager:
 				objectAdded = other.objectAdded;
 				objectRemoved = other.objectRemoved;
 				objectChanged = other.objectChanged;
+				objectLockLost = other.objectLockLost;
 			}
 			SignalData copyAndClear()
 			{
@@ -284,12 +336,17 @@ class JSON_DATABASE_API JDManager:
                 objectAdded.clear();
                 objectRemoved.clear();
                 objectChanged.clear();
+                objectLockLost.clear();
 				return copy;
 			}
 
-			void setDatabaseFileChanged() { std::lock_guard<std::mutex> lock(m_mutex); m_databaseFileChanged = true; }
-			void setLockedObjectsChanged() { std::lock_guard<std::mutex> lock(m_mutex); m_lockedObjectsChanged = true; }
-			void setDatabaseOutdated() { std::lock_guard<std::mutex> lock(m_mutex); m_databaseOutdated = true; }
+			// Gets called when a signal is added, used to wake up the update loop.
+			// The callback must not access this SignalData, it may be called while m_mutex is locked.
+			void setChangeCallback(const std::function<void()>& callback) { m_changeCallback = callback; }
+
+			void setDatabaseFileChanged() { std::lock_guard<std::mutex> lock(m_mutex); m_databaseFileChanged = true; notifyChange(); }
+			void setLockedObjectsChanged() { std::lock_guard<std::mutex> lock(m_mutex); m_lockedObjectsChanged = true; notifyChange(); }
+			void setDatabaseOutdated() { std::lock_guard<std::mutex> lock(m_mutex); m_databaseOutdated = true; notifyChange(); }
 
 			void addObjectLocked(JDObject obj) {
                 std::lock_guard<std::mutex> lock(m_mutex);
@@ -299,6 +356,7 @@ class JSON_DATABASE_API JDManager:
 						return;
 				}
 				objectLocked.push_back(obj);
+				notifyChange();
             }
 			void addObjectLocked(const std::vector<JDObject>& objs) {
                 std::lock_guard<std::mutex> lock(m_mutex);
@@ -312,6 +370,7 @@ class JSON_DATABASE_API JDManager:
                     objectLocked.push_back(obj);
                     next:;
 				}
+				notifyChange();
 			}
 
 			void addObjectUnlocked(JDObject obj) {
@@ -322,6 +381,7 @@ class JSON_DATABASE_API JDManager:
 						return;
 				}
 				objectUnlocked.push_back(obj);
+				notifyChange();
 			}
 			void addObjectUnlocked(const std::vector<JDObject>& objs) {
                 std::lock_guard<std::mutex> lock(m_mutex);
@@ -335,6 +395,7 @@ class JSON_DATABASE_API JDManager:
                     objectUnlocked.push_back(obj);
                     next:;
 				}
+				notifyChange();
 			}
 
 			void addObjectAdded(JDObject obj) {
@@ -346,19 +407,21 @@ class JSON_DATABASE_API JDManager:
                 }
                 objectAdded.push_back(obj);
 				
+				notifyChange();
 			}
 			void addObjectAdded(const std::vector<JDObject>& objs) {
                 std::lock_guard<std::mutex> lock(m_mutex);
+                std::unordered_set<JDObjectInterface*> existing;
+                existing.reserve(objectAdded.size() + objs.size());
+                for (const JDObject& obj : objectAdded)
+                    existing.insert(obj.get());
+                objectAdded.reserve(objectAdded.size() + objs.size());
 				for (const JDObject& obj : objs)
 				{
-                    for (size_t i = 0; i < objectAdded.size(); ++i)
-                    {
-                        if (objectAdded[i] == obj)
-                            goto next;
-                    }
-                    objectAdded.push_back(obj);
-                    next:;      
+                    if (existing.insert(obj.get()).second)
+                        objectAdded.push_back(obj);
 				}
+				notifyChange();
 			}
 
 			void addObjectRemoved(JDObject obj) {
@@ -369,6 +432,7 @@ class JSON_DATABASE_API JDManager:
 						return;
 				}
 				objectRemoved.push_back(obj);
+				notifyChange();
 			}
 			void addObjectRemoved(const std::vector<JDObject>& objs) {
                 std::lock_guard<std::mutex> lock(m_mutex);
@@ -382,6 +446,7 @@ class JSON_DATABASE_API JDManager:
                     objectRemoved.push_back(obj);
                     next:;
 				}
+				notifyChange();
 			}
 
 			void addObjectChanged(JDObject obj) {
@@ -392,6 +457,7 @@ class JSON_DATABASE_API JDManager:
 						return;
 				}
 				objectChanged.push_back(obj);
+				notifyChange();
 			}
 			void addObjectChanged(const std::vector<JDObject>& objs) {
                 std::lock_guard<std::mutex> lock(m_mutex);
@@ -405,6 +471,22 @@ class JSON_DATABASE_API JDManager:
                     objectChanged.push_back(obj);
                     next:;
 				}
+				notifyChange();
+			}
+
+			void addObjectLockLost(const std::vector<JDObject>& objs) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+				for (const JDObject& obj : objs)
+				{
+                    for (size_t i = 0; i < objectLockLost.size(); ++i)
+                    {
+                        if (objectLockLost[i] == obj)
+                            goto next;
+                    }
+                    objectLockLost.push_back(obj);
+                    next:;
+				}
+				notifyChange();
 			}
 
 			bool databaseFileChanged() const { return m_databaseFileChanged; }
@@ -416,6 +498,7 @@ class JSON_DATABASE_API JDManager:
 			const std::vector<JDObject>& getObjectAdded() const { return objectAdded; }
 			const std::vector<JDObject>& getObjectRemoved() const { return objectRemoved; }
 			const std::vector<JDObject>& getObjectChanged() const { return objectChanged; }
+			const std::vector<JDObject>& getObjectLockLost() const { return objectLockLost; }
 
 
 
@@ -431,8 +514,11 @@ class JSON_DATABASE_API JDManager:
                 objectAdded.clear();
                 objectRemoved.clear();
                 objectChanged.clear();
+                objectLockLost.clear();
             }
             private:
+            void notifyChange() { if (m_changeCallback) m_changeCallback(); }
+
             bool m_databaseFileChanged = false;
             bool m_lockedObjectsChanged = false;
             bool m_databaseOutdated = false;
@@ -442,8 +528,10 @@ class JSON_DATABASE_API JDManager:
             std::vector<JDObject> objectAdded;
             std::vector<JDObject> objectRemoved;
             std::vector<JDObject> objectChanged;
+            std::vector<JDObject> objectLockLost;
 
 			std::mutex m_mutex;
+			std::function<void()> m_changeCallback;
         };
         SignalData m_signalsToEmit;
         static const unsigned int s_fileLockTimeoutMs;
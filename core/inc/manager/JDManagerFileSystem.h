@@ -6,12 +6,14 @@
 #include "utilities/filesystem/FileChangeWatcher.h"
 #include "utilities/filesystem/LockedFileAccessor.h"
 #include "utilities/JDUserRegistration.h"
+#include "utilities/JDLeaseManager.h"
 #include "utilities/JDUser.h"
 
 #include "Logger.h"
 
 #include "Json/JsonValue.h"
 #include <mutex>
+#include <chrono>
 
 namespace JsonDatabase
 {
@@ -41,6 +43,9 @@ namespace JsonDatabase
 			const std::string& getDatabaseChangeHistoryFileName() const;
             std::string getDatabaseChangeHistoryFilePath() const;
 
+            const std::string& getDatabaseChangeJournalFileName() const;
+            std::string getDatabaseChangeJournalFilePath() const;
+
             bool isLoggedOnDatabase() const;
 
             std::vector<Utilities::JDUser> getUsers() const
@@ -50,6 +55,11 @@ namespace JsonDatabase
 
 
             static const std::string& getJsonFileEnding();
+
+            // Stops renewing the lease of this session, the other sessions treat it as dead after the lease timeout.
+            // Used to test sessions that hang.
+            void setLeaseRenewalPaused(bool paused);
+            bool isLeaseRenewalPaused() const;
         protected:
             
             void logOnDatabase();
@@ -65,6 +75,8 @@ namespace JsonDatabase
             // Returns the amount of locks it has deleted
             int tryToClearUnusedFileLocks() const;
 
+            std::string getLeaseDirectoryPath() const;
+
             ManagedFileChangeWatcher& getDatabaseFileWatcher();
             void restartDatabaseFileWatcher();
             class FileWatcherAutoPause
@@ -81,13 +93,32 @@ namespace JsonDatabase
 
             void update();
         private:
+            // The lease of this session expired and the other sessions removed its registration and locks.
+            // Logs on with a new session and restores the locks that don't conflict with locks of other sessions.
+            void restoreSession();
+
             std::string m_databasePath;
             std::string m_databaseName;
             std::string m_databaseFileName;
             std::string m_databaseChangeHistoryFileName;
+            std::string m_databaseChangeJournalFileName;
+
+            // Periodic maintenance task which backs off while nothing changes.
+            // The interval is reset to the min interval after a run that had some effect.
+            struct MaintenanceTask
+            {
+                MaintenanceTask(unsigned int minIntervalMs, unsigned int maxIntervalMs);
+
+                bool isDue(const std::chrono::steady_clock::time_point& now) const;
+                void reschedule(const std::chrono::steady_clock::time_point& now, bool hadActivity);
 
-            size_t m_slowUpdateCounter;
-            size_t m_middleUpdateCounter;
+                unsigned int minIntervalMs;
+                unsigned int maxIntervalMs;
+                unsigned int currentIntervalMs;
+                std::chrono::steady_clock::time_point nextRun;
+            };
+
+            MaintenanceTask m_userCheckTask;
 
             JDManager& m_manager;
             std::mutex& m_mutex;
@@ -97,6 +128,9 @@ namespace JsonDatabase
             mutable ManagedFileChangeWatcher m_fileWatcher;
 
             Utilities::JDUserRegistration m_userRegistration;
+
+            // Heartbeat of this session, detects sessions which died without cleaning up
+            Utilities::JDLeaseManager m_leaseManager;
             // This lock file is used to ckeck if an user is still online or not.
             // If it can be deleted, the user is offline and did not clean up after himself.
             //FileLock *m_databaseLoginFileLock;
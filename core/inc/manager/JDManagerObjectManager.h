@@ -6,10 +6,14 @@
 #include "object/JDObjectContainer.h"
 #include "utilities/JDObjectIDDomain.h"
 #include "utilities/JDUniqueMutexLock.h"
+#include "utilities/JDSharedMutexLock.h"
 #include "JDObjectLocker.h"
 
 #include <vector>
 #include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <atomic>
 
 #include "Logger.h"
 
@@ -55,6 +59,22 @@ namespace JsonDatabase
             template<typename T, typename... Args>
             std::shared_ptr<T> createInstance(Args&&... args);
 
+            /**
+             * @brief
+             * Instantiates count new objects of type T and adds them to the database in one step.
+             * The IDs get reserved once, the database mutex is locked once
+             * and one objectAdded signal gets emitted for all objects.
+             * Use a ChangeHistoryScope with ChangeHistoryMode::off, if the instantiations
+             * do not need to be recorded.
+             * @note This function does lock the database mutex
+             * @tparam T type of the objects
+             * @param count amount of objects to create
+             * @param ...args Arguments to pass to the constructor of each object
+             * @return the objects which were added to the database
+             */
+            template<typename T, typename... Args>
+            std::vector<std::shared_ptr<T>> createInstances(size_t count, const Args&... args);
+
             /**
              * @brief 
 			 * Creates a deep clone of the source object
@@ -94,6 +114,11 @@ namespace JsonDatabase
              * @brief 
 			 * Adds an object to the database
              * @note This function does lock the database mutex
+             * @note The IDs of new objects come from blocks which get reserved in the shared ID allocator
+             *       of the database. If the reserved IDs of this session are used up, the next block gets
+             *       reserved in the calling thread. That needs file I/O and can wait up to 1s per attempt
+             *       for another session. The blocks double in size up to 65536 IDs, so this is rare.
+             *       If no IDs can be reserved, the object is not added.
              * @param obj 
 			 * @return true if the object was added successfully, otherwise false
              */
@@ -103,6 +128,7 @@ namespace JsonDatabase
              * @brief 
 			 * Adds a list of objects to the database
              * @note This function does lock the database mutex
+             * @note See addObject(JDObject) for the reservation of the IDs
              * @param objList 
 			 * @return true if all objects were added successfully, otherwise false
              */
@@ -144,10 +170,12 @@ namespace JsonDatabase
 			 * Counts the number of objects of type T in the database
              * @note This function does lock the database mutex
              * @tparam T 
+             * @param exactType if true, objects of types derived from T are not counted. 
+             *        The count is then read from the bucket of T in O(1)
 			 * @return the number of objects of type T in the database
              */
             template<typename T>
-            size_t getObjectCount() const;
+            size_t getObjectCount(bool exactType = false) const;
 
             /**
              * @brief 
@@ -226,22 +254,54 @@ namespace JsonDatabase
 
             /**
              * @brief 
-             * Gets a list of all objects of the given type T
-             * @note This function does lock the database mutex
+             * Gets a list of all objects of the given type T, in the same order as getObjects()
+             * @note This function only locks the database mutex if the snapshot is outdated
              * @tparam T 
+             * @param exactType if true, objects of types derived from T are not included
 			 * @return list of all objects of type T
              */
             template<typename T>
-            std::vector<std::shared_ptr<T>> getObjects() const;
+            std::vector<std::shared_ptr<T>> getObjects(bool exactType = false) const;
 
             /**
              * @brief 
-			 * Gets a list of all objects in the database
+             * Gets a list of all objects with the given class name
+             * @see JDObjectInterface::className()
              * @note This function does lock the database mutex
+             * @param className of the objects
+             * @return list of all objects of the class
+             */
+            std::vector<JDObject> getObjectsOfClass(const std::string& className) const;
+
+            /**
+             * @brief 
+			 * Gets a list of all objects in the database
+             * @note This function only locks the database mutex if the snapshot is outdated
 			 * @return list of all objects in the database
              */
             std::vector<JDObject> getObjects() const;
 
+            /**
+             * @brief 
+             * Immutable list of all objects at the time it was created.
+             * A snapshot never changes, a change of the database publishes a new one.
+             */
+            struct ObjectSnapshot
+            {
+                std::vector<JDObject> objects;
+                unsigned long long version = 0;
+            };
+            using ObjectSnapshotPtr = std::shared_ptr<const ObjectSnapshot>;
+
+            /**
+             * @brief 
+             * Gets the current snapshot of all objects without copying the list.
+             * Use this for iterations over all objects, for example to refresh a UI.
+             * @note This function only locks the database mutex if the snapshot is outdated
+             * @return the current snapshot, never nullptr
+             */
+            ObjectSnapshotPtr getObjectsSnapshot() const;
+
             /**
              * @brief 
              * Removes all objects from this database
@@ -266,11 +326,25 @@ namespace JsonDatabase
 			 * @brief 
 			 * Try to lock the objects
              * @note This function does lock the database mutex
+			 * All objects are locked with one registry transaction.
 			 * @param objs list of objects to lock
 			 * @param errors list of errors for each object, can be empty when calling the function
+			 * @param allOrNothing if true, no object gets locked if one of them can't be locked.
+			 *        The objects that could have been locked get Error::objectLockBatchAborted
 			 * @return true if all objects were locked successfully, otherwise false in that case check the error list
 			 */
-			bool lockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors);
+			bool lockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors, bool allOrNothing = false);
+
+			/**
+			 * @brief 
+			 * Try to lock the objects with the given IDs
+             * @note This function does lock the database mutex
+			 * @param ids list of object IDs to lock
+			 * @param errors list of errors for each ID, an ID that does not exist gets Error::objIsNullptr
+			 * @param allOrNothing if true, no object gets locked if one of them can't be locked
+			 * @return true if all objects were locked successfully, otherwise false in that case check the error list
+			 */
+			bool lockObjects(const std::vector<JDObjectID::IDType>& ids, std::vector<Error>& errors, bool allOrNothing = false);
 
             /**
              * @brief 
@@ -302,6 +376,16 @@ namespace JsonDatabase
 			 */
 			bool unlockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors);
 
+			/**
+			 * @brief 
+			 * Try to unlock the objects with the given IDs
+             * @note This function does lock the database mutex
+			 * @param ids list of object IDs to unlock
+			 * @param errors list of errors for each ID, an ID that does not exist gets Error::objIsNullptr
+			 * @return true if all objects were unlocked successfully, otherwise false in that case check the error list
+			 */
+			bool unlockObjects(const std::vector<JDObjectID::IDType>& ids, std::vector<Error>& errors);
+
             /**
              * @brief 
 			 * Try to lock all objects in the database
@@ -320,6 +404,61 @@ namespace JsonDatabase
              */
             bool unlockAllObjs(Error& err);
 
+            /**
+             * @brief 
+             * Locks all objects of the class with a single lock entry.
+             * Use this instead of locking each object before bulk edits.
+             * Fails if another session holds a lock on any object of the class.
+             * @note This function does lock the database mutex
+             * @param className of the objects to lock, see JDObjectInterface::className()
+             * @param err to store the error message if the class could not be locked
+             * @return true if the class was locked successfully, otherwise false
+             */
+            bool lockClass(const std::string& className, Error& err);
+
+            /**
+             * @brief 
+             * Releases a lock taken with lockClass()
+             * @note This function does lock the database mutex
+             * @param className of the locked class
+             * @param err to store the error message if the class could not be unlocked
+             * @return true if the class was unlocked successfully, otherwise false
+             */
+            bool unlockClass(const std::string& className, Error& err);
+
+            /**
+             * @brief 
+             * Locks all objects with an ID in [first, last] with a single lock entry.
+             * Fails if another session holds a lock on any object in the range.
+             * @note This function does lock the database mutex
+             * @param first ID of the range
+             * @param last ID of the range, inclusive
+             * @param err to store the error message if the range could not be locked
+             * @return true if the range was locked successfully, otherwise false
+             */
+            bool lockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err);
+
+            /**
+             * @brief 
+             * Releases a lock taken with lockIDRange()
+             * @note This function does lock the database mutex
+             * @param first ID of the range
+             * @param last ID of the range, inclusive
+             * @param err to store the error message if the range could not be unlocked
+             * @return true if the range was unlocked successfully, otherwise false
+             */
+            bool unlockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err);
+
+            /**
+             * @brief 
+             * Gets the LockData of all class and range locks
+             * @note This function does lock the database mutex
+             * @param locksOut list of the class and range locks
+             * @param err to store the error message if the locks could not be read
+             * @return true if the locks could be retrieved successfully, otherwise false
+             */
+            bool getIntentionLocks(std::vector<JDObjectLocker::LockData>& locksOut, Error& err) const;
+
             /**
              * @brief 
 			 * Check if the object is locked
@@ -451,18 +590,64 @@ namespace JsonDatabase
              */
             int removeInactiveObjectLocks() const;
 
+            /**
+             * @brief
+             * Sets how the assignments to the JDObjectValue's of the managed objects get recorded.
+             * Can be overridden for a thread with a ChangeHistoryScope.
+             * @param mode
+             * @param ringBufferSize amount of changes kept per value in ChangeHistoryMode::ringBuffer
+             */
+            void setChangeHistoryMode(ChangeHistoryMode mode, size_t ringBufferSize = 16);
+            ChangeHistoryMode getChangeHistoryMode() const;
+            size_t getChangeHistoryRingBufferSize() const;
+
+            /**
+             * @brief
+             * Sets the amount of threads that load the objects of the database file.
+             * Only has an effect if JD_ENABLE_MULTITHREADING is defined and more than 100 objects get loaded.
+             * @param count 0 uses the amount of hardware threads, 1 loads on the calling thread only
+             */
+            void setLoadThreadCount(unsigned int count);
+            unsigned int getLoadThreadCount() const;
+
 
 
 
         protected:
             void onDatabasePathChange(const std::string& oldPath, const std::string& newPath);
 
+            // Removes the locks of sessions with an expired lease
+            int removeObjectLocksOfSessions(const std::vector<std::string>& sessionIDs);
+            // Writes the locks of this session again after its lease expired, see JDObjectLocker::restoreOwnLocks()
+            bool restoreObjectLocks(const std::string& oldSessionID, std::vector<JDObject>& lostObjectsOut);
+
+            // True if new objects must get IDs from the shared ID allocator of the database
+            bool usesIDAllocator() const;
+
+            /*
+                Makes sure that the ID domain has at least count reserved IDs.
+                Missing IDs get reserved in the shared ID allocator of the database,
+                the reserved block grows with each reservation of the session.
+                m_idReserveMutex must be locked by the caller, m_objsMutex must not be locked exclusively.
+            */
+            bool reserveIDs_internal(size_t count);
+            // First ID a new block may start with. m_objsMutex must be locked by the caller
+            JDObjectID::IDType getIDReserveMinFirst_internal() const;
+            // Reserves a block of at least count IDs. m_idReserveMutex must be locked by the caller
+            bool reserveIDBlock_internal(size_t count, const JDObjectID::IDType& minFirst);
+            /*
+                Returns count IDs for new objects, or none.
+                If the allocator is used, only reserved IDs are handed out.
+                m_idReserveMutex and m_objsMutex (exclusive) must be locked by the caller.
+            */
+            bool getNewIDs_internal(size_t count, std::vector<JDObjectIDptr>& idsOut);
+
             bool objectIDIsValid(const JDObjectIDptr& id) const;
             bool objectIDIsValid(const JDObject& obj) const;
 
             bool packAndAddObject_internal(const JDObject& obj);
             bool packAndAddObject_internal(const JDObject& obj, const JDObjectID::IDType& presetID);
-            bool packAndAddObject_internal(const std::vector<JDObject> &objs);
+            bool packAndAddObject_internal(const std::vector<JDObject> &objs, std::vector<JDObject>& addedObjsOut);
             bool packAndAddObject_internal(const std::vector<JDObjectID::IDType> &ids, const std::vector<JDObject>& objs);
 
             //JDObject replaceObject_internal(const JDObject& obj);
@@ -476,11 +661,18 @@ namespace JsonDatabase
             JDObject getObject_internal(const JDObjectIDptr& id) const;
             JDObject getObject_internal(const JDObjectID::IDType& id) const;
             std::vector<JDObject> getObjects_internal() const;
+            // The container must be locked, at least shared
+            ObjectSnapshotPtr getObjectsSnapshot_internal() const;
             JDObjectManager* getObjectManager_internal(const JDObjectIDptr& id);
             JDObjectManager* getObjectManager_internal(const JDObjectID::IDType& id);
             const std::vector<JDObjectManager*>& getObjectManagers_internal() const;
             void clearObjects_internal();
 
+            // Returns true if the objects of the bucket are of type T or derived from it.
+            // All objects in a bucket have the same type, only the first one has to be checked.
+            template<typename T>
+            static bool typeBucketMatches(const JDObjectContainer::TypeBucket& bucket);
+
             bool getLockedObjects_internal(std::vector<LockedObject>& lockedObjectsOut, Error& err) const;
             bool getLockedObjects_internal(std::vector<JDObject>& lockedObjectsOut, Error& err) const;
             bool getObjectLocksByUser_internal(const Utilities::JDUser& user, std::vector<JDObjectLocker::LockData>& lockedObjectsOut, Error& err) const;
@@ -496,6 +688,8 @@ namespace JsonDatabase
                 std::vector<JDObject>& newObjInstances,
                 std::vector<JDObject>& removedObjs,
                 std::vector<JDObjectPair>& changedPairs);
+            // Deletes the manager of the object.
+            // m_managerLifetimeMutex and m_objsMutex must be locked exclusively by the caller.
             bool unregisterAndRemove(JDObject obj);
 
 
@@ -505,11 +699,30 @@ namespace JsonDatabase
             JDObjectIDDomain m_idDomain;
             std::mutex &m_mutex;
 
-            mutable std::mutex m_objsMutex;
+            // Readers of the object container share the lock, changes to the container are exclusive.
+            // File I/O is never done while this lock is held exclusively.
+            mutable std::shared_mutex m_objsMutex;
+            // Held shared by the load stages, which use object managers after the lookup without m_objsMutex.
+            // Held exclusively while managers get deleted. Always locked before m_objsMutex.
+            mutable std::shared_mutex m_managerLifetimeMutex;
+            // Serializes the access to the object locker, which reads and writes the lock registry
+            mutable std::mutex m_lockerMutex;
             JDObjectContainer m_objs;
+            // Last published snapshot of m_objs, read by getObjectsSnapshot() without locking
+            mutable std::atomic<ObjectSnapshotPtr> m_snapshot;
             
             Internal::JDObjectLocker m_objLocker;
 
+            // Serializes the reservations of IDs in the ID allocator
+            std::mutex m_idReserveMutex;
+            size_t m_idReserveBlockSize;
+            static const size_t s_minIDReserveBlockSize;
+            static const size_t s_maxIDReserveBlockSize;
+
+            std::atomic<ChangeHistoryMode> m_changeHistoryMode;
+            std::atomic<size_t> m_changeHistoryRingBufferSize;
+            std::atomic<unsigned int> m_loadThreadCount;
+
             Log::LogObject* m_logger = nullptr;
         };
 
@@ -527,6 +740,33 @@ namespace JsonDatabase
             return nullptr;
         }
 
+        template<typename T, typename... Args>
+        std::vector<std::shared_ptr<T>> JDManagerObjectManager::createInstances(size_t count, const Args&... args)
+        {
+            // Check if T is a derived type of JDObjectInterface
+            static_assert(std::is_base_of<JDObjectInterface, T>::value, "T must be derived from JDObjectInterface");
+            std::vector<std::shared_ptr<T>> instances;
+            std::vector<JDObject> objs;
+            instances.reserve(count);
+            objs.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::shared_ptr<T> instance(new T(args...));
+                instances.push_back(instance);
+                objs.push_back(instance);
+            }
+            if (addObject(objs))
+                return instances;
+
+            // Only return the objects which were added
+            std::vector<std::shared_ptr<T>> added;
+            added.reserve(instances.size());
+            for (const std::shared_ptr<T>& instance : instances)
+                if (instance->isManaged())
+                    added.push_back(instance);
+            return added;
+        }
+
         template<typename T>
         std::shared_ptr<T> JDManagerObjectManager::createDeepClone(const std::shared_ptr<T>& source)
         {
@@ -563,20 +803,26 @@ namespace JsonDatabase
         bool JDManagerObjectManager::removeObjects()
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            std::vector<T*> toRemove = getObjects<T>();
+            std::vector<std::shared_ptr<T>> typedObjs = getObjects<T>();
+            std::vector<JDObject> toRemove(typedObjs.begin(), typedObjs.end());
 			return removeObjects(toRemove);
         }
 
 
         template<typename T>
-        std::size_t JDManagerObjectManager::getObjectCount() const
+        std::size_t JDManagerObjectManager::getObjectCount(bool exactType) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            if (exactType)
+            {
+                const JDObjectContainer::TypeBucket* bucket = m_objs.getTypeBucket(typeid(T));
+                return bucket ? bucket->objects.size() : 0;
+            }
             size_t c = 0;
-            for (auto& o : m_objs)
+            for (const auto& bucket : m_objs.getTypeBuckets())
             {
-                if (dynamic_cast<T*>(o.get()))
-                    ++c;
+                if (typeBucketMatches<T>(bucket.second))
+                    c += bucket.second.objects.size();
             }
             return c;
         }
@@ -598,18 +844,33 @@ namespace JsonDatabase
         }
 
         template<typename T>
-        std::vector<std::shared_ptr<T>> JDManagerObjectManager::getObjects() const
+        std::vector<std::shared_ptr<T>> JDManagerObjectManager::getObjects(bool exactType) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            // Filtered from the snapshot, so readers don't wait for writers and the order matches getObjects()
+            ObjectSnapshotPtr snapshot = getObjectsSnapshot();
             std::vector<std::shared_ptr<T>> list;
-            list.reserve(m_objs.size());
-            for (auto& p : m_objs)
+            list.reserve(snapshot->objects.size());
+            for (const auto& o : snapshot->objects)
             {
-                std::shared_ptr<T> obj = std::dynamic_pointer_cast<T>(p->getObject());
+                if (exactType)
+                {
+                    if (typeid(*o) == typeid(T))
+                        list.push_back(std::static_pointer_cast<T>(o));
+                    continue;
+                }
+                std::shared_ptr<T> obj = std::dynamic_pointer_cast<T>(o);
                 if (obj)
                     list.push_back(obj);
             }
             return list;
         }
+
+        template<typename T>
+        bool JDManagerObjectManager::typeBucketMatches(const JDObjectContainer::TypeBucket& bucket)
+        {
+            if (bucket.objects.size() == 0)
+                return false;
+            return dynamic_cast<T*>(bucket.objects[0]->getObject().get()) != nullptr;
+        }
     }
 }
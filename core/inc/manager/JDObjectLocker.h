@@ -10,8 +10,11 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include "Json/JsonValue.h"
 #include <mutex>
+#include <atomic>
 
 #include "Logger.h"
 
@@ -56,7 +59,9 @@ namespace JsonDatabase
 			bool isObjectLockedByOther(const JDObject & obj, Error& err) const;*/
 
 			bool lockObject(const JDObject& obj, Error& err);
-			bool lockObjects(const std::vector<JDObject>& objs, std::vector<Error> &errors);
+			// allOrNothing: if one object can't be locked, none gets locked.
+			// The objects that could have been locked get the error Error::objectLockBatchAborted
+			bool lockObjects(const std::vector<JDObject>& objs, std::vector<Error> &errors, bool allOrNothing = false);
 			bool unlockObject(const JDObject& obj, Error& err);
 			bool unlockObject(const JDObjectID::IDType& id, Error& err);
 			bool unlockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors);
@@ -66,27 +71,95 @@ namespace JsonDatabase
 			bool isObjectLocked(const JDObject& obj, Error& err) const;
 			bool isObjectLockedByMe(const JDObject& obj, Error& err) const;
 			bool isObjectLockedByOther(const JDObject& obj, Error& err) const;
+			// Same as isObjectLockedByMe() for each object, the lock cache only gets refreshed once
+			bool areObjectsLockedByMe(const std::vector<JDObject>& objs, std::vector<bool>& lockedByMeOut, Error& err) const;
+
+			/*
+				Intention locks.
+				A class lock covers all objects of the class, a range lock all objects
+				with an ID in [first, last], using a single registry entry.
+				They conflict with the object, class and range locks of other sessions.
+			*/
+			bool lockClass(const std::string& className, Error& err);
+			bool unlockClass(const std::string& className, Error& err);
+			bool lockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err);
+			bool unlockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err);
 
 			
 			struct LockData
 			{
+				enum class Type
+				{
+					object,
+					objectClass,
+					idRange
+				};
+
+				Type type;
 				JDObjectID::IDType objectID;
+				// Locked class for Type::objectClass, class of the object for Type::object.
+				// Can be empty for object locks of older versions
+				std::string className;
+				JDObjectID::IDType rangeFirst;
+				JDObjectID::IDType rangeLast;
 				Utilities::JDUser user;
 				QDate lockDate;
 				QTime lockTime;
 
-				LockData() : objectID(JDObjectID::invalidID) {}
+				LockData() 
+					: type(Type::object)
+					, objectID(JDObjectID::invalidID) 
+					, rangeFirst(JDObjectID::invalidID)
+					, rangeLast(JDObjectID::invalidID)
+				{}
 			};
+			/*
+				Locks of this session at the time of getOwnLocks().
+				Used by work that checks many objects on multiple threads,
+				the check does not need the lock cache of the locker.
+			*/
+			struct OwnLocks
+			{
+				std::unordered_set<JDObjectID::IDType> objectIDs;
+				std::unordered_set<std::string> classNames;
+				std::vector<std::pair<JDObjectID::IDType, JDObjectID::IDType>> ranges;
+
+				// Same result as isObjectLockedByMe() at the time of the snapshot
+				bool covers(const JDObjectID::IDType& id, const std::string& className) const;
+			};
+			bool getOwnLocks(OwnLocks& locksOut, Error& err) const;
+
+			// Returns the object locks only
 			bool getLockedObjects(std::vector<LockData>& lockedObjectsOut, Error& err) const;
+			// Returns the class and range locks
+			bool getIntentionLocks(std::vector<LockData>& locksOut, Error& err) const;
+			// If the object has no own lock, the covering class or range lock is returned
 			bool getLockData(JDObjectID::IDType objID, LockData& lockDataOut, Error& err) const;
 			int removeInactiveObjectLocks() const;
 
+			// Removes all locks held by the given sessions, used for sessions with an expired lease.
+			// Returns the amount of removed locks
+			int removeLocksOfSessions(const std::vector<std::string>& sessionIDs);
+
+			/*
+				Writes the locks of this session again, after another session removed them because
+				the lease of this session expired. The locks itself are still held by this session.
+				Locks that conflict with locks other sessions took in the meantime get released.
+				oldSessionID is the session the locks were written with, the user must already have the new session.
+				lostObjectsOut gets the loaded objects that are no longer covered by a lock of this session.
+			*/
+			bool restoreOwnLocks(const std::string& oldSessionID, std::vector<JDObject>& lostObjectsOut, Error& err);
+
 			struct JsonKeys
 			{
 				static const std::string objectID;
 				static const std::string user;
 				static const std::string lockDate;
 				static const std::string lockTime;
+				static const std::string lockType;
+				static const std::string className;
+				static const std::string rangeFirst;
+				static const std::string rangeLast;
 			};
 
 			void update();
@@ -102,6 +175,7 @@ namespace JsonDatabase
 			public:
 				LockEntryObjectImpl(const std::string& key);
 				LockEntryObjectImpl(const std::string& key, const JDObject& obj, const JDManager& manager);
+				LockEntryObjectImpl(const std::string& key, const LockData& lockData, const JDManager& manager);
 				~LockEntryObjectImpl();
 
 
@@ -119,8 +193,30 @@ namespace JsonDatabase
 			private:
 			};
 
-			bool lockObjects_internal(const std::vector<JDObject>& objs, std::vector<Error>& errors);
+			bool lockObjects_internal(const std::vector<JDObject>& objs, std::vector<Error>& errors, bool allOrNothing);
 			bool unlockObjects_internal(const std::vector<JDObject>& objs, std::vector<Error>& errors);
+			bool lockIntention_internal(const LockData& lock, Error& err);
+			bool unlockIntention_internal(const std::string& key, Error& err);
+
+			static std::string getClassLockKey(const std::string& className);
+			static std::string getRangeLockKey(const JDObjectID::IDType& first, const JDObjectID::IDType& last);
+
+			// The following functions expect m_lockCacheMutex to be locked by the caller.
+			// Returns the class or range lock of this (byOther = false) or another session that covers the object
+			const LockData* findIntentionLock_internal(const JDObjectID::IDType& id, const std::string& className, bool byOther) const;
+			// Returns true if the new lock overlaps with any lock of another session
+			bool conflictsWithOther_internal(const LockData& lock) const;
+			// Returns false only if every ID of the range belongs to a loaded object of another class.
+			// The class of an ID that is not loaded is unknown, it may be of the given class.
+			bool rangeMayContainClass_internal(const JDObjectID::IDType& first, const JDObjectID::IDType& last,
+											   const std::string& className, const std::vector<JDObject>& loadedObjs) const;
+			std::string getClassName_internal(const LockData& objectLock) const;
+
+			// Reloads the lock cache from the registry file if it is marked as outdated
+			// and the generation of the registry file has changed.
+			// m_lockCacheMutex must be locked by the caller.
+			bool refreshLockCache_internal(Error& err) const;
+			void invalidateLockCache() const;
 
 			
 			void onCreateFiles() override;
@@ -137,6 +233,19 @@ namespace JsonDatabase
 			mutable std::string m_specificDatabasePath;
 			
 			mutable ManagedFileChangeWatcher m_lockTableWatcher;
+
+			// In memory copy of the lock table, used by all lock queries.
+			// Marked as outdated by m_lockTableWatcher and by own changes to the lock table.
+			mutable std::mutex m_lockCacheMutex;
+			mutable std::unordered_map<JDObjectID::IDType, LockData> m_lockCache;
+			mutable std::unordered_map<std::string, LockData> m_classLockCache;
+			mutable std::vector<LockData> m_rangeLockCache;
+			mutable bool m_lockCacheValid;
+			mutable std::atomic<bool> m_lockCacheOutdated;
+			mutable unsigned long long m_lockCacheGeneration;
+
+			// Class and range locks of this session, used to restore them after the lease expired
+			std::unordered_map<std::string, LockData> m_ownIntentionLocks;
 		};
 	}
 }
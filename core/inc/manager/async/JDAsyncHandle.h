@@ -0,0 +1,129 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <coroutine>
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        /*
+            State of one async work, shared by the work, its progress and the handles of the caller.
+            Cancellation and the deadline are checked by the worker before the work starts
+            and by the work itself between its phases.
+        */
+        class JSON_DATABASE_API JDAsyncState
+        {
+        public:
+            JDAsyncState();
+            ~JDAsyncState();
+
+            void cancel();
+            bool isCancelled() const;
+
+            void setDeadline(const std::chrono::steady_clock::time_point& deadline);
+            bool isDeadlineExceeded() const;
+
+            // True if the work was cancelled or its deadline is exceeded
+            bool isAbortRequested() const;
+
+            // Gets called by the worker, runs all continuations
+            void complete(bool success);
+            bool isDone() const;
+            bool hasSucceeded() const;
+
+            bool wait() const;
+            bool waitFor(unsigned int timeoutMs) const;
+
+            // Returns false if the work is already done, the continuation does not get added in that case
+            bool addContinuation(const std::function<void(bool)>& continuation);
+
+        private:
+            mutable std::mutex m_mutex;
+            mutable std::condition_variable m_cv;
+            std::atomic<bool> m_cancelled;
+            std::atomic<bool> m_done;
+            std::atomic<bool> m_success;
+            std::atomic<bool> m_hasDeadline;
+            std::chrono::steady_clock::time_point m_deadline;
+            std::vector<std::function<void(bool)>> m_continuations;
+        };
+    }
+
+    /**
+     * @brief
+     * Handle to an async work of the JDManager.
+     * The handle can be copied, all copies refer to the same work.
+     * A default constructed handle refers to no work and behaves like a failed work.
+     *
+     * Continuations added with then() run on the worker thread which completed the work,
+     * new async work can be queued from there without a round trip through the event loop.
+     * The handle can also be awaited in a C++20 coroutine:
+     *   bool success = co_await manager.loadObjectsAsync();
+     * The coroutine gets resumed on the worker thread.
+     */
+    class JSON_DATABASE_API JDAsyncHandle
+    {
+    public:
+        JDAsyncHandle();
+        JDAsyncHandle(const std::shared_ptr<Internal::JDAsyncState>& state);
+
+        bool isValid() const;
+        bool isDone() const;
+        bool hasSucceeded() const;
+
+        /**
+         * @brief
+         * Blocks until the work is done.
+         * Must not be called from the thread which runs the event loop of the manager,
+         * if the work depends on it.
+         * @return true if the work succeeded
+         */
+        bool wait() const;
+
+        /**
+         * @brief
+         * Blocks until the work is done or the timeout is reached.
+         * @return true if the work is done
+         */
+        bool waitFor(unsigned int timeoutMs) const;
+
+        /**
+         * @brief
+         * Cancels the work. Queued work does not get processed anymore,
+         * running work stops at the next point where it can be aborted safely.
+         * Cancelled work completes as failed.
+         */
+        void cancel();
+        bool isCancelled() const;
+
+        /**
+         * @brief
+         * Aborts the work like cancel(), if it is not done after timeoutMs.
+         */
+        void setDeadline(unsigned int timeoutMs);
+        void setDeadline(const std::chrono::steady_clock::time_point& deadline);
+
+        /**
+         * @brief
+         * Adds a continuation which gets called with the result when the work is done.
+         * If the work is already done, the continuation gets called immediately.
+         */
+        const JDAsyncHandle& then(const std::function<void(bool success)>& continuation) const;
+
+        // Coroutine support
+        bool await_ready() const;
+        bool await_suspend(std::coroutine_handle<> handle) const;
+        bool await_resume() const;
+
+    private:
+        std::shared_ptr<Internal::JDAsyncState> m_state;
+    };
+}
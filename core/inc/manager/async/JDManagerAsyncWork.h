@@ -3,7 +3,10 @@
 #include "JsonDatabase_base.h"
 #include "JsonDatabase_Declaration.h"
 #include "manager/async/WorkProgress.h"
+#include "manager/async/JDAsyncHandle.h"
 #include <mutex>
+#include <vector>
+#include <memory>
 
 namespace JsonDatabase
 {
@@ -25,10 +28,34 @@ namespace JsonDatabase
             virtual std::string getErrorMessage() const = 0;
             virtual WorkType getWorkType() const = 0;
 
+            // Lane in which the work gets queued
+            virtual WorkPriority getPriority() const;
+
+            // Read only work only reads the database file and may run concurrently to other read only work.
+            // All other work runs alone and in the order it was added.
+            virtual bool isReadOnly() const;
+
+            // Takes over the job of the pending work other, which got added after this one.
+            // Returns false if the work can't be merged.
+            virtual bool merge(const JDManagerAysncWork& other);
+
+            // Handle for the caller which added the work
+            JDAsyncHandle getHandle() const;
+
         protected:
             JDManager& m_manager;
             std::mutex& m_mutex;
             WorkProgress m_progress;
+            bool m_success;
+
+        private:
+            std::shared_ptr<JDAsyncState> m_state;
+
+            // Work which got merged into this one, it completes with the result of this work
+            std::vector<std::shared_ptr<JDManagerAysncWork>> m_mergedWork;
+
+            // Order in which the work got queued, set by JDManagerAsyncWorker
+            unsigned long long m_queueSequence;
         };
     }
 }
@@ -3,7 +3,10 @@
 #include "JsonDatabase_base.h"
 #include "JsonDatabase_Declaration.h"
 #include "manager/async/WorkProgress.h"
+#include "utilities/JDMPSCQueue.h"
 #include <vector>
+#include <deque>
+#include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
@@ -29,7 +32,8 @@ namespace JsonDatabase
             bool isWorkDone(std::shared_ptr<JDManagerAysncWork> work);
             void removeDoneWork(std::shared_ptr<JDManagerAysncWork> work);
             void clearDoneWork();
-            void process();
+            // Emits startAsyncWork, returns true if work was added since the last call
+            bool process();
             void start();
             void stop();
         public:
@@ -38,24 +42,69 @@ namespace JsonDatabase
             bool isBusy() const;
             WorkType getCurrentWorkType() const;
 
+            /**
+             * @brief setWorkerCount
+             * Sets the number of worker threads. Running workers get restarted.
+             * Read only work, like single object loads, can run on multiple workers at the same time.
+             * @param count at least 1
+             */
+            void setWorkerCount(unsigned int count);
+            unsigned int getWorkerCount() const;
+
+            /**
+             * @brief setWorkerAffinityMask
+             * Pins the worker threads to the CPUs in the mask. 0 disables pinning.
+             * Gets applied when the workers get started.
+             * @param mask
+             */
+            void setWorkerAffinityMask(unsigned long long mask);
+            unsigned long long getWorkerAffinityMask() const;
+
         private:
-            void threadLoop();
-            void processWork(const std::vector<std::shared_ptr<JDManagerAysncWork>>& workList);
+            void threadLoop(unsigned int workerIndex);
+            void drainSubmitQueue_internal();
+            void queueWork_internal(const std::shared_ptr<JDManagerAysncWork>& work);
+            bool mergeWork_internal(const std::shared_ptr<JDManagerAysncWork>& work);
+            static bool canReorder(const JDManagerAysncWork& a, const JDManagerAysncWork& b);
+            // True if exclusive work that was queued before the read only work is still pending
+            bool isBehindExclusiveWork_internal(const JDManagerAysncWork& readOnlyWork) const;
+            std::shared_ptr<JDManagerAysncWork> takeNextWork_internal();
+            // True if queued work did not start yet
+            bool hasPendingWork_internal() const;
             void processWork(std::shared_ptr<JDManagerAysncWork> work);
+            // Removes the work from the running work, before its callers get completed
+            void finishWork(const std::shared_ptr<JDManagerAysncWork>& work);
+
+            static constexpr size_t s_laneCount = (size_t)WorkPriority::bulk + 1;
+            static constexpr size_t s_submitQueueCapacity = 1024;
 
             JDManager& m_manager;
             std::mutex& m_mutex;
 
-            std::thread* m_thread;
-            std::vector<std::shared_ptr<JDManagerAysncWork>> m_workList;
+            std::vector<std::thread*> m_threads;
+            unsigned int m_workerCount;
+            unsigned long long m_affinityMask;
+
+            // Protected by m_mutexInternal
+            std::deque<std::shared_ptr<JDManagerAysncWork>> m_lanes[s_laneCount];
+            std::vector<std::shared_ptr<JDManagerAysncWork>> m_runningWork;
             std::vector<std::shared_ptr<JDManagerAysncWork>> m_workListDone;
-            std::mutex m_mutexInternal;
-            std::mutex m_workListMutex;
+            bool m_exclusiveRunning;
+            // Queued work which is not read only, in the order it was added.
+            // Read only work must not pass exclusive work that was queued before it.
+            std::deque<JDManagerAysncWork*> m_exclusiveOrder;
+            unsigned long long m_nextQueueSequence;
+
+            mutable std::mutex m_mutexInternal;
             std::condition_variable m_cv;
             std::atomic<bool> m_stopFlag;
             std::atomic<bool> m_busy;
+            std::atomic<bool> m_startSignalPending;
+            // Workers which wait for new work, not the ones that wait for blocked work
+            std::atomic<unsigned int> m_idleWorkers;
 
-            std::atomic<std::shared_ptr<JDManagerAysncWork>> m_currentWork;
+            // Added work, the workers move it into the lanes
+            JDMPSCQueue<std::shared_ptr<JDManagerAysncWork>> m_submitQueue;
 
             Log::LogObject* m_logger = nullptr;
             
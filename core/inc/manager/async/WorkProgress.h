@@ -4,15 +4,28 @@
 #include "JsonDatabase_base.h"
 #include <string>
 #include <vector>
+#include <functional>
+#include <atomic>
+#include <memory>
 
 namespace JsonDatabase
 {
     namespace Internal
     {
+        /*
+            Progress of an async work.
+            The setters are only called by the thread which runs the work.
+            The getters may be called from any thread, they read the published values.
+            The progress gets published through atomics once it changed by at least s_publishStep,
+            so polling the progress does not slow down the work.
+        */
         class JSON_DATABASE_API WorkProgress
         {
         public:
             WorkProgress();
+            // Copies the published values, the abort check does not get copied
+            WorkProgress(const WorkProgress& other);
+            WorkProgress& operator=(const WorkProgress& other);
             ~WorkProgress();
 
             void setProgress(double percent);
@@ -27,15 +40,28 @@ namespace JsonDatabase
             double getScalar() const;
 
             double getProgress() const;
-            const std::string& getTaskText() const;
-            const std::string& getComment() const;
+            std::string getTaskText() const;
+            std::string getComment() const;
+
+            // Gets set by the async worker.
+            // Long running work checks it between its phases and stops if the work was cancelled.
+            void setAbortCheck(const std::function<bool()>& abortCheck);
+            bool isAbortRequested() const;
+
+            static constexpr double s_publishStep = 0.005;
 
         protected:
+            void publishProgress(bool force);
+
+            // Only used by the thread which runs the work
             double m_scalar; // 0.0 - 1.0
             double m_subProgress; 
             double m_progress; // Percent value
-            std::string m_taskText;
-            std::string m_comment;
+            std::function<bool()> m_abortCheck;
+
+            std::atomic<double> m_publishedProgress;
+            std::atomic<std::shared_ptr<const std::string>> m_taskText;
+            std::atomic<std::shared_ptr<const std::string>> m_comment;
         };
     }
 }
@@ -21,8 +21,8 @@ namespace JsonDatabase
 			void process() override;
 			std::string getErrorMessage() const override;
 			WorkType getWorkType() const override;
+			bool merge(const JDManagerAysncWork& other) override;
 		private:
-			bool m_success;
 			int m_loadMode;
 		};
 	}
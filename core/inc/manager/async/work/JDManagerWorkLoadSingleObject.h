@@ -21,11 +21,13 @@ namespace JsonDatabase
 			void process() override;
 			std::string getErrorMessage() const override;
 			WorkType getWorkType() const override;
+			bool merge(const JDManagerAysncWork& other) override;
+			WorkPriority getPriority() const override;
+			bool isReadOnly() const override;
 
 
 		private:
 			JDObject m_object;
-			bool m_success;
 		};
 	}
 }
\ No newline at end of file
@@ -24,12 +24,13 @@ namespace JsonDatabase
 			void process() override;
 			std::string getErrorMessage() const override;
 			WorkType getWorkType() const override;
+			bool merge(const JDManagerAysncWork& other) override;
+			WorkPriority getPriority() const override;
 
 
 		private:
 			Log::LogObject* m_logger = nullptr;
 			std::vector<JDObject> m_objects;
-			bool m_success;
 		};
 	}
 }
\ No newline at end of file
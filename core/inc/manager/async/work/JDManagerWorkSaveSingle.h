@@ -21,10 +21,11 @@ namespace JsonDatabase
 			const JDObject& getObject() const;
 			std::string getErrorMessage() const override;
 			WorkType getWorkType() const override;
+			bool merge(const JDManagerAysncWork& other) override;
+			WorkPriority getPriority() const override;
 
 		private:
 			JDObject m_object;
-			bool m_success;
 		};
 	}
 }
\ No newline at end of file
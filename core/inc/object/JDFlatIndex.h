@@ -0,0 +1,176 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include <vector>
+#include <functional>
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        /*
+            Open addressed hash index which maps a key to a slot index.
+            Uses linear probing in a single array, no node gets allocated per entry.
+            Removed entries are closed by shifting the following entries back,
+            so the table never contains tombstones and lookups stay short after many removals.
+        */
+        template<typename Key, typename Hash = std::hash<Key>>
+        class JDFlatIndex
+        {
+        public:
+            static constexpr size_t npos = ~static_cast<size_t>(0);
+
+            JDFlatIndex()
+                : m_mask(0)
+                , m_size(0)
+            {}
+
+            // Makes space for count entries without rehashing
+            void reserve(size_t count)
+            {
+                size_t capacity = 8;
+                while (capacity * 3 < count * 4)
+                    capacity *= 2;
+                if (capacity > m_entries.size())
+                    rehash(capacity);
+            }
+
+            // Returns false if the key already exists
+            bool insert(const Key& key, size_t value)
+            {
+                if ((m_size + 1) * 4 > m_entries.size() * 3)
+                    rehash(m_entries.size() < 8 ? 8 : m_entries.size() * 2);
+                size_t i = getHomeSlot(key);
+                while (m_entries[i].value != npos)
+                {
+                    if (m_entries[i].key == key)
+                        return false;
+                    i = (i + 1) & m_mask;
+                }
+                m_entries[i].key = key;
+                m_entries[i].value = value;
+                ++m_size;
+                return true;
+            }
+
+            // Returns npos if the key does not exist
+            size_t find(const Key& key) const
+            {
+                if (m_size == 0)
+                    return npos;
+                size_t i = getHomeSlot(key);
+                while (m_entries[i].value != npos)
+                {
+                    if (m_entries[i].key == key)
+                        return m_entries[i].value;
+                    i = (i + 1) & m_mask;
+                }
+                return npos;
+            }
+
+            // Changes the value of an existing key
+            bool update(const Key& key, size_t value)
+            {
+                if (m_size == 0)
+                    return false;
+                size_t i = getHomeSlot(key);
+                while (m_entries[i].value != npos)
+                {
+                    if (m_entries[i].key == key)
+                    {
+                        m_entries[i].value = value;
+                        return true;
+                    }
+                    i = (i + 1) & m_mask;
+                }
+                return false;
+            }
+
+            bool erase(const Key& key)
+            {
+                if (m_size == 0)
+                    return false;
+                size_t i = getHomeSlot(key);
+                while (true)
+                {
+                    if (m_entries[i].value == npos)
+                        return false;
+                    if (m_entries[i].key == key)
+                        break;
+                    i = (i + 1) & m_mask;
+                }
+
+                // Backward shift deletion
+                size_t j = i;
+                while (true)
+                {
+                    j = (j + 1) & m_mask;
+                    if (m_entries[j].value == npos)
+                        break;
+                    size_t home = getHomeSlot(m_entries[j].key);
+                    // Move the entry if its home slot is not in the cyclic range (i, j]
+                    bool inRange = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                    if (inRange)
+                        continue;
+                    m_entries[i] = std::move(m_entries[j]);
+                    i = j;
+                }
+                m_entries[i].key = Key();
+                m_entries[i].value = npos;
+                --m_size;
+                return true;
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+            void clear()
+            {
+                m_entries.clear();
+                m_mask = 0;
+                m_size = 0;
+            }
+
+        private:
+            struct Entry
+            {
+                Key key = Key();
+                size_t value = npos; // npos marks an empty entry
+            };
+
+            size_t getHomeSlot(const Key& key) const
+            {
+                // Mix the bits, std::hash is the identity for integers and pointers on some platforms
+                unsigned long long h = static_cast<unsigned long long>(Hash{}(key));
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+                return static_cast<size_t>(h) & m_mask;
+            }
+
+            void rehash(size_t capacity)
+            {
+                std::vector<Entry> old;
+                old.swap(m_entries);
+                m_entries.resize(capacity);
+                m_mask = capacity - 1;
+                m_size = 0;
+                for (Entry& entry : old)
+                {
+                    if (entry.value == npos)
+                        continue;
+                    size_t i = getHomeSlot(entry.key);
+                    while (m_entries[i].value != npos)
+                        i = (i + 1) & m_mask;
+                    m_entries[i] = std::move(entry);
+                    ++m_size;
+                }
+            }
+
+            std::vector<Entry> m_entries;
+            size_t m_mask;
+            size_t m_size;
+        };
+    }
+}
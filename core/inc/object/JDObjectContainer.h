@@ -3,13 +3,23 @@
 #include "JsonDatabase_base.h"
 #include "JDObjectManager.h"
 #include "JDObjectID.h"
+#include "JDFlatIndex.h"
 #include <vector>
 #include <unordered_map>
+#include <atomic>
+#include <string>
+#include <typeindex>
 
 namespace JsonDatabase
 {
     namespace Internal
     {
+        /*
+            All managers are stored in one slot array.
+            The ID and the object pointer are mapped to the slot by open addressed indices.
+            A removed slot is filled with the last one, removing an object is O(1).
+            Iteration runs over the slot array, the order only changes when an object gets removed.
+        */
         class JSON_DATABASE_API JDObjectContainer
         {
         public:
@@ -37,8 +47,6 @@ namespace JsonDatabase
             JDObjectManager* getObjectByID(const JDObjectID::IDType& id) const;
             JDObjectManager* getObjectByPtr(JDObjectInterface* obj) const;
             const std::vector<JDObjectManager*> &getAllObjects() const;
-            const std::unordered_map<JDObjectID::IDType, JDObjectManager*>& getAllObjectsIDMap() const;
-            const std::unordered_map<JDObjectInterface*, JDObjectManager*>& getAllObjectsPtrMap() const;
 
             bool exists(const JDObjectIDptr& id) const;
             bool exists(const JDObject& obj) const;
@@ -47,15 +55,45 @@ namespace JsonDatabase
             size_t size() const;
             void clear();
 
+            /*
+                Objects grouped by their dynamic type.
+                A bucket only exists while it contains objects.
+            */
+            struct TypeBucket
+            {
+                std::string className;
+                std::vector<JDObjectManager*> objects;
+            };
+            const TypeBucket* getTypeBucket(const std::type_index& type) const;
+            const TypeBucket* getClassBucket(const std::string& className) const;
+            const std::unordered_map<std::type_index, TypeBucket>& getTypeBuckets() const;
+
+            // Gets incremented on each change of the container.
+            // Can be read without holding the lock of the container.
+            unsigned long long getVersion() const;
+
+            // Checks that the indices and the type buckets match the slot array
+            bool isConsistent() const;
+
             iterator begin();
             iterator end();
 
             const_iterator begin() const;
             const_iterator end() const;
         private:
+            bool addObject_internal(JDObjectManager* obj);
+            void removeSlot(size_t slot);
+            void addToTypeBucket(size_t slot);
+            void removeFromTypeBucket(size_t slot);
+
             std::vector<JDObjectManager*> m_objectVector;
-            std::unordered_map<JDObjectID::IDType, JDObjectManager*> m_objectMap;
-            std::unordered_map<JDObjectInterface*, JDObjectManager*> m_objectPtrMap;
+            // Position of each slot in its type bucket
+            std::vector<size_t> m_bucketPositions;
+            JDFlatIndex<JDObjectID::IDType> m_idIndex;
+            JDFlatIndex<const JDObjectInterface*> m_ptrIndex;
+            std::unordered_map<std::type_index, TypeBucket> m_typeBuckets;
+            std::unordered_map<std::string, std::type_index> m_classNameToType;
+            std::atomic<unsigned long long> m_version = 0;
         };
     }
 }
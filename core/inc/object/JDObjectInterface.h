@@ -8,6 +8,7 @@
 #include "value/IJDObjectValue.h"
 #include "JDObjectID.h"
 #include <memory>
+#include <atomic>
 
 #include "Json/JsonValue.h"
 #include <string>
@@ -275,6 +276,22 @@ class JSON_DATABASE_API JDObjectInterface: protected Utilities::JDSerializable
          * @return true if parameters are changed since the last save/load
          */
         bool hasChanges() const;
+
+        /**
+         * @brief
+         * Gets the changed values of the object.
+         * Bit i is set if the i-th value added with addValue() changed since the last save/load.
+         * All values after the 63th share the last bit.
+         * @return mask of the changed values, 0 if no value changed
+         */
+        unsigned long long getDirtyMask() const;
+
+        /**
+         * @brief
+         * Gets the change state of a single value
+         * @return true if the value changed since the last save/load
+         */
+        bool isValueDirty(const IJDObjectValue& value) const;
 		
 
         /**
@@ -374,6 +391,12 @@ class JSON_DATABASE_API JDObjectInterface: protected Utilities::JDSerializable
         void setManager(Internal::JDObjectManager* manager);
         Internal::JDObjectManager* getManager() const;
 
+        void recordInstantiation();
+
+        // Called from the IJDObjectValue, keeps the dirty mask in sync with the values
+        void setValueDirty(const IJDObjectValue* value, bool dirty) const;
+        static unsigned long long getDirtyBit(size_t valueIndex);
+
         virtual JDObjectInterface* deepClone_internal() const = 0;
         virtual JDObjectInterface* shallowClone_internal() const = 0;
 
@@ -400,6 +423,7 @@ class JSON_DATABASE_API JDObjectInterface: protected Utilities::JDSerializable
         mutable bool m_marketdForRemoval;
 
 		std::vector<IJDObjectValue*> m_values;
+        mutable std::atomic<unsigned long long> m_dirtyMask;
 
         // Changes about the object itself, not including the value changes
 		std::vector<std::shared_ptr<IChangeTransaction>> m_changeHistory;
@@ -10,7 +10,11 @@
 #include "Json/JsonValue.h"
 
 #include "Logger.h"
+#include <atomic>
 
+// Unit tests which fill a JDObjectContainer without a database manager
+class TST_objectContainer;
+class TST_objectContainerBenchmark;
 
 
 namespace JsonDatabase
@@ -20,6 +24,8 @@ namespace JsonDatabase
 		class JSON_DATABASE_API JDObjectManager
 		{
 			friend JDManagerObjectManager;
+			friend ::TST_objectContainer;
+			friend ::TST_objectContainerBenchmark;
 
 			JDObjectManager(JDManager *manager, const JDObject& obj, const JDObjectIDptr& id, Log::LogObject* parentLogger);
 			~JDObjectManager();
@@ -52,6 +58,20 @@ namespace JsonDatabase
 
 			bool loadFromDatabase();
 			void loadFromDatabaseAsync();
+
+			// Change history mode of the database manager, ChangeHistoryMode::full if there is no manager
+			ChangeHistoryMode getChangeHistoryMode(size_t& ringBufferSizeOut) const;
+
+			/*
+				Hash of the data the object had when it was last loaded or saved.
+				On reload, the hash of the incoming json gets compared to it,
+				if both are equal and the object has no local changes, the object does not get
+				serialized again to compare the data.
+			*/
+			static unsigned long long getContentHash(const JsonObject& json);
+			void setContentHash(unsigned long long hash);
+			void clearContentHash();
+			bool hasContentHash(unsigned long long hash) const;
 			
 		private:
 			enum ManagedLoadStatus
@@ -79,6 +99,8 @@ namespace JsonDatabase
 				*/
 				std::vector<JDObjectID::IDType>& newObjIDs;
 				std::vector<JDObject>& newObjInstances;
+				// Content hash of each new object, set when the manager for the object got created
+				std::vector<unsigned long long>& newObjHashes;
 
 				/*
 					These objects are used in the "objectChangedFromDatabase" signal. 
@@ -104,6 +126,10 @@ namespace JsonDatabase
 				bool removedObjects;
 				bool changedObjects;
 				//bool overridingObjects;
+
+				// Locks of this session, taken once before the load.
+				// If not set, the lock of each object gets looked up
+				const JDObjectLocker::OwnLocks* ownLocks = nullptr;
 			};
 			struct ManagedLoadMisc
 			{
@@ -142,6 +168,8 @@ namespace JsonDatabase
 
 			bool deserializeOverrideFromJsonIfChanged_internal(const JsonObject& json, JDObject obj, bool& hasChangedOut);
 			bool deserializeOverrideFromJson_internal(const JsonObject& json, JDObject obj);
+			bool deserializeOverrideFromJson_internal(const JsonObject& json, JDObject obj, unsigned long long contentHash,
+													  const JDObjectLocker::OwnLocks* ownLocks);
 
 			Log::LogObject* m_logger = nullptr;
 			JDObject m_obj;
@@ -149,6 +177,7 @@ namespace JsonDatabase
 			Lockstate m_lockstate;
 			ChangeState m_changestate;
 			JDManager *m_databaseManager;
+			std::atomic<unsigned long long> m_contentHash; // 0 if no hash is known
 		};
 	}
 }
@@ -21,10 +21,8 @@ namespace JsonDatabase
 			return m_paramName;
 		}
 
-		const std::vector<std::shared_ptr<IChangeTransaction>>& getValueChangeTransactions() const
-		{
-			return m_changeHistory;
-		}
+		// Returns the changes from the oldest to the newest
+		std::vector<std::shared_ptr<IChangeTransaction>> getValueChangeTransactions() const;
 		virtual void clearValueChangeTransactions();
 
 		/**
@@ -41,19 +39,41 @@ namespace JsonDatabase
 		virtual void discardChanges() = 0;
 
 	protected:
-		void onValueChange(std::shared_ptr<IChangeTransaction> change);
+		/**
+		 * @brief
+		 * Gets the change history mode for this value.
+		 * A ChangeHistoryScope of the current thread overrides the mode of the database manager.
+		 * @param historyLimitOut max amount of changes to keep, 0 for no limit
+		 */
+		ChangeHistoryMode getChangeHistoryMode(size_t& historyLimitOut) const;
+
+		// change can be nullptr if the change history is turned off
+		void onValueChange(std::shared_ptr<IChangeTransaction> change, size_t historyLimit = 0);
+
+		/**
+		 * @brief
+		 * Returns the oldest change, if the next change with this history limit overwrites it
+		 * and nobody else holds it. The caller can overwrite its data instead of allocating a new change.
+		 * @return nullptr if no change can be reused
+		 */
+		std::shared_ptr<IChangeTransaction> getRecyclableTransaction(size_t historyLimit) const;
 
 		void setParent(JDObjectInterface* parent)
 		{
 			m_parent = parent;
 		}
 	private:
-
+		// Moves the oldest change to the front of m_changeHistory
+		void linearizeHistory();
 
 
 		const std::string m_paramName;
+		// Ring buffer if a history limit is set, m_historyStart is the position of the oldest change.
+		// Without a limit the changes are in order and m_historyStart is 0.
 		std::vector<std::shared_ptr<IChangeTransaction>> m_changeHistory;
+		size_t m_historyStart = 0;
 		JDObjectInterface* m_parent = nullptr;
+		size_t m_valueIndex = 0; // Position in the value list of the parent, used for the dirty mask
 
 	};
 }
\ No newline at end of file
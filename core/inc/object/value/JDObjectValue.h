@@ -70,20 +70,29 @@ namespace JsonDatabase
 
 		JDObjectValue& operator=(const JDObjectValue& other)
 		{
-			if (m_value == other.m_value)
-				return *this;
-			T old = m_value;
-			m_value = other.m_value;
-			onValueChange(std::make_shared<ValueChangeTransaction>(getParamName(), JsonValue(old), JsonValue(m_value)));
-			return *this;
+			return operator=(other.m_value);
 		}
 		JDObjectValue& operator=(const T& other)
 		{
 			if (m_value == other)
 				return *this;
+			size_t historyLimit = 0;
+			if (getChangeHistoryMode(historyLimit) == ChangeHistoryMode::off)
+			{
+				m_value = other;
+				onValueChange(nullptr);
+				return *this;
+			}
 			T old = m_value;
 			m_value = other;
-			onValueChange(std::make_shared<ValueChangeTransaction>(getParamName(), JsonValue(old), JsonValue(m_value)));
+			// In ring buffer mode the overwritten change gets reused
+			std::shared_ptr<IChangeTransaction> change = getRecyclableTransaction(historyLimit);
+			ValueChangeTransaction* recycled = dynamic_cast<ValueChangeTransaction*>(change.get());
+			if (recycled)
+				recycled->setValues(JsonValue(old), JsonValue(m_value));
+			else
+				change = std::make_shared<ValueChangeTransaction>(getParamName(), JsonValue(old), JsonValue(m_value));
+			onValueChange(std::move(change), historyLimit);
 			return *this;
 		}
 
@@ -16,6 +16,7 @@ namespace JsonDatabase
 		objectLockedByOther,
 		objectNotLocked,
 		objectAlreadyLocked,
+		objectLockBatchAborted,
 
 		unableToCreateOrOpenLockFile,
 		unableToDeleteLockFile,
@@ -26,6 +27,7 @@ namespace JsonDatabase
 		fileAlreadyUnlocked,
 		fileLockTimeout,
 		fileNotLocked,
+		fileLockQueuedBehindWriter,
 
 		cantOpenFileForRead,
 		cantOpenFileForWrite,
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include <map>
+#include <iterator>
+#include <type_traits>
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        /*
+            Set of integral IDs, stored as closed ranges [first, last].
+            IDs which get handed out by an increment end up in a few ranges,
+            so a million used IDs may only need a single entry.
+            Adjacent ranges get merged on insert, a range gets split when an ID in its middle gets erased.
+        */
+        template<typename T>
+        class JDIDRangeSet
+        {
+            static_assert(std::is_integral<T>::value, "T must be an integral type");
+        public:
+            JDIDRangeSet()
+                : m_count(0)
+            {}
+
+            // Returns false if the ID is already in the set
+            bool insert(T id)
+            {
+                auto next = m_ranges.upper_bound(id);
+                if (next != m_ranges.begin())
+                {
+                    auto prev = std::prev(next);
+                    if (id <= prev->second)
+                        return false;
+                    if (prev->second + 1 == id)
+                    {
+                        // Extend the previous range and merge it with the next one if they touch
+                        prev->second = id;
+                        if (next != m_ranges.end() && next->first == id + 1)
+                        {
+                            prev->second = next->second;
+                            m_ranges.erase(next);
+                        }
+                        ++m_count;
+                        return true;
+                    }
+                }
+                if (next != m_ranges.end() && next->first == id + 1)
+                {
+                    T last = next->second;
+                    m_ranges.erase(next);
+                    m_ranges.emplace(id, last);
+                }
+                else
+                    m_ranges.emplace(id, id);
+                ++m_count;
+                return true;
+            }
+
+            // Returns false if the ID is not in the set
+            bool erase(T id)
+            {
+                auto it = m_ranges.upper_bound(id);
+                if (it == m_ranges.begin())
+                    return false;
+                --it;
+                if (id > it->second)
+                    return false;
+                T first = it->first;
+                T last = it->second;
+                m_ranges.erase(it);
+                if (first < id)
+                    m_ranges.emplace(first, id - 1);
+                if (id < last)
+                    m_ranges.emplace(id + 1, last);
+                --m_count;
+                return true;
+            }
+
+            bool contains(T id) const
+            {
+                auto it = m_ranges.upper_bound(id);
+                if (it == m_ranges.begin())
+                    return false;
+                --it;
+                return id <= it->second;
+            }
+
+            // Returns false if the set is empty
+            bool getMax(T& maxOut) const
+            {
+                if (m_ranges.empty())
+                    return false;
+                maxOut = m_ranges.rbegin()->second;
+                return true;
+            }
+
+            // Amount of IDs in the set
+            size_t size() const
+            {
+                return m_count;
+            }
+            // Amount of stored ranges
+            size_t rangeCount() const
+            {
+                return m_ranges.size();
+            }
+
+            void clear()
+            {
+                m_ranges.clear();
+                m_count = 0;
+            }
+
+        private:
+            std::map<T, T> m_ranges; // first -> last
+            size_t m_count;
+        };
+    }
+}
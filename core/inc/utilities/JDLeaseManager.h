@@ -0,0 +1,102 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include "JsonDatabase_Declaration.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "Logger.h"
+
+/*
+	Session liveness by leases.
+	Each session owns a lease file in the lease folder, which it renews on every heartbeat.
+	A background thread renews the own lease and watches the leases of the other sessions.
+	A lease is expired, if its content did not change for the lease timeout, measured with the
+	local clock. Clock differences between the machines therefore have no effect.
+	Expired sessions are collected and can be taken with takeExpiredSessions(),
+	their locks and registrations can then be removed without probing each lock.
+*/
+namespace JsonDatabase
+{
+	namespace Utilities
+	{
+		class JSON_DATABASE_API JDLeaseManager
+		{
+		public:
+			JDLeaseManager();
+			~JDLeaseManager();
+
+			void setParentLogger(Log::LogObject* parentLogger);
+
+			bool start(const std::string& leaseDirectory, const std::string& sessionID);
+			void stop();
+			bool isRunning() const;
+
+			const std::string& getSessionID() const;
+
+			// Returns the sessions that expired since the last call
+			std::vector<std::string> takeExpiredSessions();
+
+			// Returns true once, if the own lease was removed by another session since the last call.
+			// The other sessions treated this session as dead and removed its registration and locks.
+			bool takeLeaseLost();
+
+			// Gets called from the lease thread when sessions expired or the own lease was lost
+			void setExpiredCallback(const std::function<void()>& callback);
+
+			// While paused, the own lease is not renewed and expires for the other sessions.
+			// Simulates a session that hangs, the leases of the other sessions are still watched.
+			void setRenewalPaused(bool paused);
+			bool isRenewalPaused() const;
+
+			static void setHeartbeatInterval(unsigned int ms);
+			static unsigned int getHeartbeatInterval();
+			static void setLeaseTimeout(unsigned int ms);
+			static unsigned int getLeaseTimeout();
+
+			static const std::string s_leaseFileEnding;
+		private:
+			void threadLoop();
+			bool renewLease();
+			void reapExpiredLeases();
+			std::string getLeaseFilePath(const std::string& sessionID) const;
+
+			struct ObservedLease
+			{
+				std::string content;
+				std::chrono::steady_clock::time_point lastChange;
+			};
+
+			Log::LogObject* m_logger = nullptr;
+
+			std::string m_leaseDirectory;
+			std::string m_sessionID;
+			unsigned long long m_heartbeat;
+
+			std::thread* m_thread;
+			std::mutex m_threadMutex;
+			std::condition_variable m_cv;
+			std::atomic<bool> m_stopFlag;
+			std::atomic<bool> m_renewalPaused;
+			std::atomic<bool> m_leaseLost;
+
+			// Only used by the lease thread
+			std::unordered_map<std::string, ObservedLease> m_observedLeases;
+
+			std::mutex m_expiredMutex;
+			std::vector<std::string> m_expiredSessions;
+			std::function<void()> m_expiredCallback;
+
+			static unsigned int s_heartbeatIntervalMs;
+			static unsigned int s_leaseTimeoutMs;
+		};
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include <vector>
+#include <atomic>
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        /*
+            Bounded lock free queue for multiple producers and a single consumer.
+            Each cell carries a sequence number, which tells the producers and the consumer
+            whether the cell is free to be written or ready to be read.
+            Producers claim a cell with a compare exchange on the tail position,
+            the consumer owns the head position.
+            The capacity gets rounded up to a power of 2.
+        */
+        template<typename T>
+        class JDMPSCQueue
+        {
+        public:
+            JDMPSCQueue(size_t capacity)
+                : m_head(0)
+                , m_tail(0)
+            {
+                size_t size = 2;
+                while (size < capacity)
+                    size *= 2;
+                m_mask = size - 1;
+                m_cells = std::vector<Cell>(size);
+                for (size_t i = 0; i < size; ++i)
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            JDMPSCQueue(const JDMPSCQueue&) = delete;
+            JDMPSCQueue& operator=(const JDMPSCQueue&) = delete;
+
+            // Can be called from any thread. Returns false if the queue is full.
+            bool tryPush(const T& value)
+            {
+                size_t pos = m_tail.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    Cell& cell = m_cells[pos & m_mask];
+                    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    if (sequence == pos)
+                    {
+                        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            cell.value = value;
+                            cell.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                        // pos got reloaded by the failed exchange
+                    }
+                    else if (sequence < pos)
+                    {
+                        // The consumer did not free this cell yet
+                        return false;
+                    }
+                    else
+                        pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Only one thread at a time may pop
+            bool tryPop(T& valueOut)
+            {
+                Cell& cell = m_cells[m_head & m_mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                if (sequence != m_head + 1)
+                    return false; // Empty, or the producer did not finish writing the cell yet
+                valueOut = std::move(cell.value);
+                cell.value = T();
+                cell.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+                ++m_head;
+                return true;
+            }
+
+            size_t capacity() const
+            {
+                return m_mask + 1;
+            }
+
+        private:
+            struct Cell
+            {
+                std::atomic<size_t> sequence;
+                T value;
+
+                Cell()
+                    : sequence(0)
+                    , value()
+                {}
+                Cell(const Cell&)
+                    : sequence(0)
+                    , value()
+                {}
+            };
+
+            std::vector<Cell> m_cells;
+            size_t m_mask;
+            size_t m_head; // Owned by the consumer
+            alignas(64) std::atomic<size_t> m_tail;
+        };
+    }
+}
@@ -3,7 +3,10 @@
 #include "JsonDatabase_base.h"
 #include "JsonDatabase_Declaration.h"
 #include "object/JDObjectID.h"
-#include <unordered_map>
+#include "utilities/JDIDRangeSet.h"
+#include <unordered_set>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <memory>
 
@@ -49,9 +52,15 @@ namespace JsonDatabase
 
 		/*
 			Generates a new ID unique to this domain.
+			Reserved IDs are used first, then the local counter.
 		*/
 		JDObjectIDptr getNewID();
 
+		/*
+			Generates count new IDs unique to this domain.
+		*/
+		std::vector<JDObjectIDptr> getNewIDs(size_t count);
+
 		/*
 			Checks if the given ID is unique to this domain.
 			If it is, success is set to true and the ID is returned.
@@ -59,25 +68,54 @@ namespace JsonDatabase
 		*/
 		JDObjectIDptr getPredefinedID(const JDObjectID::IDType &existing, bool &success);
 		std::vector<JDObjectIDptr> getPredefinedIDs(const std::vector<JDObjectID::IDType> &existingIDs, bool &allSuccess);
-		
-		JDObjectIDptr getExistingID(const JDObjectID::IDType &existing) const;
-		
 
 		bool idExists(const JDObjectID::IDType &id) const;
 		bool idExists(const JDObjectIDptr &id) const;
 
+		/*
+			Removes the ID from the used IDs.
+			Only the version with the JDObjectIDptr invalidates the ID object.
+		*/
 		bool unregisterID(const JDObjectID::IDType &id);
 		bool unregisterID(JDObjectIDptr id);
 
+		/*
+			Reserved IDs are handed out by getNewID() before the local counter is used.
+			The ranges get reserved by the manager in the shared ID allocator of the database,
+			so sessions do not create the same ID for different objects.
+			Can be called from any thread.
+		*/
+		void addReservedRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last);
+		/*
+			Hands out count reserved IDs, or none if there are not enough reserved IDs left.
+			The local counter is never used, for domains that share their IDs with other sessions.
+		*/
+		bool getReservedIDs(size_t count, std::vector<JDObjectIDptr>& idsOut);
+		size_t getReservedIDCount() const;
+		void clearReservedRanges();
+
+		// Returns false if no ID is used
+		bool getHighestUsedID(JDObjectID::IDType& idOut) const;
+
 	private:
 
 		void generateNextID(unsigned int increment = 1);
+		// m_reserveMutex must be locked by the caller
+		bool takeReservedID_internal(JDObjectID::IDType& idOut);
 
 		std::string m_name;
 		std::shared_ptr<JDObjectIDDomainInterface> m_interface;
 
 		static const JDObjectID::IDType s_startID;
 		JDObjectID::IDType m_nextID;
-		std::unordered_map<JDObjectID::IDType, JDObjectIDptr> m_usedIDs;
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+		Internal::JDIDRangeSet<JDObjectID::IDType> m_usedIDs;
+#else
+		std::unordered_set<JDObjectID::IDType> m_usedIDs;
+#endif
+
+		mutable std::mutex m_reserveMutex;
+		std::deque<std::pair<JDObjectID::IDType, JDObjectID::IDType>> m_reservedRanges;
+		size_t m_reservedCount;
 	};
 }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include <shared_mutex>
+
+namespace JsonDatabase
+{
+	namespace Internal
+	{
+		// Scoped lock for a std::shared_mutex.
+		// Many shared owners can hold the lock at the same time, an exclusive owner is alone.
+		class JSON_DATABASE_API JDSharedMutexLock
+		{
+		public:
+			JDSharedMutexLock(std::shared_mutex& mutex, bool exclusive);
+			~JDSharedMutexLock();
+		private:
+			std::shared_mutex& m_mutex;
+			bool m_exclusive;
+		};
+	}
+}
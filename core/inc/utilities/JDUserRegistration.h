@@ -34,6 +34,9 @@ namespace JsonDatabase
 			std::vector<JDUser> getRegisteredUsers() const;
 			int unregisterInactiveUsers() const;
 
+			// Removes the registration of sessions which are known to be dead, for example by an expired lease
+			int unregisterSessions(const std::vector<std::string>& sessionIDs);
+
 			bool checkForUserChange(std::vector<JDUser>& loggedOnUsers, std::vector<JDUser>& loggedOffUsers) const;
 
 		private:
@@ -3,7 +3,9 @@
 #include "JsonDatabase_base.h"
 #include "StringUtilities.h"
 #include <string>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include "Logger.h"
 
 
@@ -11,7 +13,9 @@ namespace JsonDatabase
 {
 	namespace Utilities
 	{
+#ifdef _WIN32
 		std::string JSON_DATABASE_API getLastErrorString(DWORD error);
+#endif
 		std::string JSON_DATABASE_API calculateMD5Hash(const std::string& filePath, Log::LogObject *logger, bool &success);
 		
 
@@ -3,6 +3,7 @@
 #include "JsonDatabase_base.h"
 #include "JsonDatabase_Declaration.h"
 #include "utilities/filesystem/LockedFileAccessor.h"
+#include "utilities/filesystem/FileRangeLock.h"
 #include "utilities/JDSerializable.h"
 #include "json/JsonValue.h"
 
@@ -15,9 +16,46 @@ namespace JsonDatabase
 		class JSON_DATABASE_API AbstractRegistry
 		{
 		public:
+			/*
+				Defines how the liveness of a registry entry is proven.
+				lockFilePerObject:
+					Each entry owns a lock file in the locks folder.
+					Compatible with older versions of this library. This is the default.
+				rangeLockFile:
+					Each entry owns a byte range in a single lock file.
+					Does not create any files per entry, which makes bulk operations much faster.
+					Older versions of this library don't see these locks, so it has to be
+					enabled explicitly with setDefaultLockMode() or setLockMode().
+				All users of a database must use the same mode.
+			*/
+			enum class LockMode
+			{
+				lockFilePerObject,
+				rangeLockFile
+			};
+
 			AbstractRegistry();
 			virtual ~AbstractRegistry();
 
+			// The mode can only be changed while this registry does not own any entries
+			bool setLockMode(LockMode mode);
+			LockMode getLockMode() const;
+
+			static void setDefaultLockMode(LockMode mode);
+			static LockMode getDefaultLockMode();
+
+			/*
+				Added and removed entries are appended to a log file next to the registry file.
+				Once the log is larger than the registry file and at least this size in bytes,
+				the log is merged into the registry file.
+				Older versions of this library don't read the log. In LockMode::lockFilePerObject
+				the log is therefore always merged before the registry file gets unlocked, so the
+				registry file stays complete for them. LockMode::rangeLockFile is not compatible
+				with older versions anyway, there the log stays until it reaches the size above.
+			*/
+			static void setMinCompactionLogSize(size_t bytes);
+			static size_t getMinCompactionLogSize();
+
 			void setParentLogger(Log::LogObject* parentLogger, const std::string &registryName);
 
 			void setDatabasePath(const std::string& path);
@@ -80,6 +118,9 @@ namespace JsonDatabase
 			std::string getLocksPath() const;
 			std::string getLockFilePath(const std::string& key) const;
 
+			// Returns the name of the range lock file used in LockMode::rangeLockFile
+			std::string getRangeLockFileName() const;
+
 			bool openRegistryFile() const;
 			bool openRegistryFile(unsigned int timeoutMillis) const;
 
@@ -89,8 +130,22 @@ namespace JsonDatabase
 
 			// Returns the amount of objects that are saved successfully
 			int addObjects(const std::vector<std::shared_ptr<LockEntryObject>> & objects);
+			// If allOrNothing is set and one object can't be added, nothing gets added and 0 is returned
+			int addObjects(const std::vector<std::shared_ptr<LockEntryObject>>& objects, std::vector<bool>& addedOut, bool allOrNothing = false);
 			int removeObjects(const std::vector<std::shared_ptr<LockEntryObject>> & objects);
 			int removeObjects(const std::vector<std::string> & keys);
+
+			// Removes entries owned by other registries, for example of expired sessions.
+			// Self owned entries are skipped.
+			int removeForeignObjects(const std::vector<std::string>& keys);
+
+			// Writes the entries again, after another registry removed them while this registry still owned their locks.
+			// Only entries with a self owned lock are written, with one registry write.
+			// Returns the amount of restored entries, 0 if the write failed.
+			int restoreObjects(const std::vector<std::shared_ptr<LockEntryObject>>& objects);
+			// Releases self owned locks without writing to the registry, their entries were already removed by another registry.
+			// Returns the amount of released locks
+			int releaseObjects(const std::vector<std::string>& keys);
 			bool isObjectActive(const std::string& key) const;
 
 
@@ -118,8 +173,23 @@ namespace JsonDatabase
 		private:
 			bool createSelfOwnedLock(const std::string& key);
 			bool removeSelfOwnedLock(const std::string& key);
+
+			// Returns the opened range lock, creates it if needed
+			Internal::FileRangeLock* getRangeLock() const;
+			void closeRangeLock();
+			// Writes the full registry file and clears the log
 			int saveObjects_internal(const JsonArray& jsons) const;
+
+			// Reads the registry file and applies the log
 			bool readObjects_internal(JsonArray& jsons) const;
+
+			std::string getRegistryLogFilePath() const;
+			bool appendRecords_internal(const std::vector<JsonObject>& records) const;
+			bool replayLog_internal(JsonArray& jsons) const;
+			bool clearLog_internal() const;
+			bool compactIfNeeded_internal() const;
+			// Merges the log into the registry file
+			bool compact_internal() const;
 			bool readObjects_internal(const JsonArray& jsons, std::vector<JDSerializable*>& objects) const;
 
 			
@@ -134,6 +204,17 @@ namespace JsonDatabase
 
 			mutable Internal::LockedFileAccessor* m_registryFile;
 			std::unordered_map<std::string, Internal::FileLock*> m_fileLocks;
+			mutable Internal::FileRangeLock* m_rangeLock;
+			LockMode m_lockMode;
+
+			static LockMode s_defaultLockMode;
+			static size_t s_minCompactionLogSize;
+
+			struct LogKeys
+			{
+				static const std::string add;
+				static const std::string remove;
+			};
 
 			bool m_nameSet;
 			bool m_databasePathSet;
@@ -4,13 +4,16 @@
 #include "Signal.h"
 #include "JsonDatabase_Declaration.h"
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <iostream>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <filesystem>
+#include <functional>
 
 #include "Logger.h"
 
@@ -27,12 +30,18 @@ namespace JsonDatabase
             enum Mode
             {
                 polling,  // checks for a file change when asked
-                winApi    // Uses the "FindFirstChangeNotification" function to monitor file changes (does not work on network drives)
+                winApi,   // Windows only, uses the "FindFirstChangeNotification" function to monitor file changes (does not work on network drives)
+                inotify   // Linux only, uses inotify (IN_CLOSE_WRITE / IN_MOVED_TO) on the database directory, no cost while idle
             };
+#ifdef _WIN32
+            typedef DWORD SetupError;
+#else
+            typedef unsigned long SetupError;
+#endif
             FileChangeWatcher(const std::string& filePath);
             ~FileChangeWatcher();
             bool setup(Log::LogObject* parentLogger);
-            DWORD getSetupError() const;
+            SetupError getSetupError() const;
 
             bool startWatching(Mode watchMode);
             bool startWatching();
@@ -45,9 +54,25 @@ namespace JsonDatabase
             void unpause();
             bool isPaused() const;
 
+            /*
+                The callback gets called from the watcher thread when a change is detected.
+                Only used by Mode::winApi and Mode::inotify, Mode::polling detects changes
+                in hasFileChanged() only.
+            */
+            void setChangeCallback(const std::function<void()>& callback);
+
             static void setDefaultWatchMode(Mode mode);
             static Mode getDefaultWatchMode();
 
+            /*
+                Mode::polling compares the file size, modification time, file id and the
+                generation counter written by LockedFileAccessor.
+                If enabled, the md5 hash of the whole file is compared additionally.
+                This costs a full read of the file on each check.
+            */
+            static void setPollingContentHashEnabled(bool enable);
+            static bool isPollingContentHashEnabled();
+
         private:
             std::string getFullPath(const std::string& relativePath);
             
@@ -56,17 +81,38 @@ namespace JsonDatabase
             Log::LogObject* m_logger = nullptr;
             std::string m_filePath;
 
+            std::thread* m_watchThread = nullptr;
+
             // Mode::winApi
             void monitorFileChanges();
-            std::thread* m_watchThread = nullptr;
+#ifdef _WIN32
             std::atomic<HANDLE> m_eventHandle;
+#endif
+
+            // Mode::inotify
+            void monitorFileChangesInotify();
+            // Reads the queued events, they mark a change as pending if the watcher is not paused.
+            // m_inotifyMutex must be locked by the caller
+            void readInotifyEvents_internal();
+            // Protected by m_inotifyMutex
+            int m_inotifyFd = -1;
+            std::string m_inotifyFileName;
+            bool m_inotifyPending = false;
+            std::mutex m_inotifyMutex;
+            static const unsigned int s_inotifyDebounceMs;
 
             // Mode::polling
             void checkFileChanges();
             std::string m_md5Hash;
+            bool m_pollInitialized = false;
+            uintmax_t m_pollFileSize = 0;
+            std::filesystem::file_time_type m_pollModificationTime;
+            unsigned long long m_pollFileID = 0;
+            unsigned long long m_pollGeneration = 0;
+            static bool s_pollingContentHash;
 
             Mode m_watchMode;
-            DWORD m_setupError;
+            SetupError m_setupError;
 
             
             std::mutex m_mutex;
@@ -76,6 +122,7 @@ namespace JsonDatabase
             std::atomic<bool> m_stopFlag;
             std::atomic<bool> m_fileChanged;
             std::atomic<bool> m_paused;
+            std::function<void()> m_changeCallback;
 
             static Mode s_defaultWatchMode;
         };
@@ -86,6 +133,7 @@ namespace JsonDatabase
             friend JDManagerFileSystem;
             friend JDObjectLocker;
             bool setup(const std::string& targetFile, Log::LogObject* parentLogger);
+            void setChangeCallback(const std::function<void()>& callback);
             ManagedFileChangeWatcher();
             ~ManagedFileChangeWatcher();
         public:
@@ -104,6 +152,7 @@ namespace JsonDatabase
             
             Log::LogObject* m_logger = nullptr;
             FileChangeWatcher* m_databaseFileWatcher;
+            std::function<void()> m_changeCallback;
         };
     }
 }
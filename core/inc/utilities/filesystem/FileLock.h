@@ -6,8 +6,11 @@
 #include <string>
 #include <vector>
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <mutex>
+#include <filesystem>
 
 #include "Logger.h"
 
@@ -75,7 +78,11 @@ namespace JsonDatabase
 
             std::string m_lockFilePathName;
 
+#ifdef _WIN32
             HANDLE m_fileHandle;
+#else
+            int m_fileHandle;
+#endif
 
 
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "JsonDatabase_base.h"
+#include "utilities/ErrorCodes.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <windows.h>
+#include <mutex>
+
+#include "Logger.h"
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        /*
+            Lock table in a single file.
+            Each key is mapped to a one byte range in the file, which is locked with an
+            OS advisory range lock. The OS releases the range when the owning process dies,
+            so a range that can be locked by someone else is not used anymore.
+            The file itself never gets any content, the ranges are locked beyond its end.
+
+            The owner of a slot locks two ranges: the slot range, which lock attempts
+            compete for, and a presence range, which is only used by isSlotInUse().
+            The probe of isSlotInUse() never touches the slot range, so it can't make
+            the lock attempt of another session fail.
+        */
+        class JSON_DATABASE_API FileRangeLock
+        {
+        public:
+            FileRangeLock(const std::string& filePath, const std::string& fileName, Log::LogObject* logger);
+            ~FileRangeLock();
+
+            const std::string& getFilePath() const;
+            const std::string& getFileName() const;
+            std::string getFullFilePath() const;
+
+            bool open(Error& err);
+            void close();
+            bool isOpen() const;
+
+            bool lockSlot(const std::string& key, Error& err);
+            bool unlockSlot(const std::string& key, Error& err);
+            void unlockAll();
+
+            // Returns true if the slot is locked by this instance
+            bool isSlotOwned(const std::string& key) const;
+
+            // Returns true if the slot is locked by any process, including this one
+            bool isSlotInUse(const std::string& key) const;
+
+            std::vector<std::string> getOwnedKeys() const;
+            size_t getOwnedCount() const;
+
+            static unsigned long long getSlotOffset(const std::string& key);
+
+            static const std::string s_fileEnding;
+        private:
+            // Offset of the presence range of the slot at the given offset
+            static unsigned long long getPresenceOffset(unsigned long long slotOffset);
+
+            bool lockRange(unsigned long long offset, bool failImmediately = true) const;
+            bool unlockRange(unsigned long long offset) const;
+
+            Log::LogObject* m_logger = nullptr;
+
+            std::string m_directory;
+            std::string m_fileName;
+
+            HANDLE m_fileHandle;
+
+            // Key -> offset of the locked range
+            std::unordered_map<std::string, unsigned long long> m_ownedSlots;
+
+            mutable std::mutex m_mutex;
+        };
+    }
+}
@@ -6,8 +6,9 @@
 #include <string>
 #include <vector>
 
-#include <windows.h>
 #include <mutex>
+#include <map>
+#include <chrono>
 
 #include "Logger.h"
 
@@ -28,6 +29,21 @@ namespace JsonDatabase
 				readWrite = 3,
 			};
 
+			/*
+				Wait time statistics of all FileReadWriteLock instances in this process.
+				Only lock calls with a timeout are measured.
+			*/
+			struct WaitStatistics
+			{
+				size_t lockCount = 0;		// Number of successful lock calls
+				size_t timeoutCount = 0;	// Number of lock calls that did not get the lock
+				double totalWaitMs = 0;
+				double maxWaitMs = 0;
+				double lastWaitMs = 0;
+
+				double getAverageWaitMs() const;
+			};
+
 			FileReadWriteLock(const std::string& filePath, const std::string& fileName, Log::LogObject *logger);
 			~FileReadWriteLock();
 
@@ -49,11 +65,49 @@ namespace JsonDatabase
 			static Access stringToAccessType(const std::string& accessStr);
 			static std::string getRandomString(size_t length);
 
+			/*
+				Returns the wait statistics for readers (Access::read) or
+				writers (Access::write and Access::readWrite).
+			*/
+			static WaitStatistics getWaitStatistics(Access direction);
+			static void resetWaitStatistics();
+
+			/*
+				A writer ticket which blocks this instance for longer than the lease
+				is treated as stale (hung writer) and gets ignored.
+				Default: s_defaultWriterTicketLeaseMs
+			*/
+			void setWriterTicketLease(unsigned int leaseMs);
+			unsigned int getWriterTicketLease() const;
+
+			static const unsigned int s_defaultWriterTicketLeaseMs;
+
 
 		private:
 			Error lock_internal(Access direction, bool& wasLockedByOtherUserOut);
 			Error lockFile(Access direction, bool& wasLockedByOtherUserOut);
 
+			/*
+				State of the lock directory for m_fileName, read in a single scan.
+				Stale lock and ticket files of crashed sessions get deleted during the scan.
+			*/
+			struct DirectoryState
+			{
+				Access access = Access::unknown;
+				size_t readerCount = 0;
+				std::vector<unsigned long long> tickets; // Writer queue tickets
+			};
+			void scanDirectory(DirectoryState& stateOut) const;
+
+			// Writer queue, a writer holds a ticket file while it waits for the lock.
+			// Must be called while the meta lock of m_fileName is held.
+			bool enqueueWriter(const DirectoryState& state, Error& err);
+			void dequeueWriter();
+			bool hasQueuedWriterBefore(const DirectoryState& state, unsigned long long ticket) const;
+			static std::string ticketToString(unsigned long long ticket);
+
+			static void addWaitStatistics(Access direction, double waitMs, bool success);
+
 
 			Log::LogObject *m_logger = nullptr;
 			//std::string m_filePath;
@@ -66,8 +120,20 @@ namespace JsonDatabase
 			Access m_access;
 
 			FileLock* m_lock;
+			FileLock* m_queueLock;
+			unsigned long long m_queueTicket; // 0 if not queued
+			unsigned int m_writerTicketLeaseMs;
 
 			static const unsigned int s_tryLockTimeoutMs;
+			static const std::string s_writerQueueTag;
+
+			// Time when a ticket was first seen by this process, used for the lease
+			static std::mutex s_ticketMutex;
+			static std::map<std::string, std::chrono::steady_clock::time_point> s_ticketFirstSeen;
+
+			static std::mutex s_statisticsMutex;
+			static WaitStatistics s_readStatistics;
+			static WaitStatistics s_writeStatistics;
 		};
 	}
 }
@@ -85,11 +85,27 @@ namespace JsonDatabase
 			Error readFile(QByteArray& fileDataOut) const;
 			Error writeFile(const QByteArray& fileData) const;
 
+			/*
+				Every successful write increments a generation counter, which is stored
+				in a small sidecar file next to the written file (<file>.gen).
+				File watchers can read this counter instead of hashing the whole file.
+			*/
+			static std::string getGenerationFilePath(const std::string& fullFilePath);
+			static bool readGeneration(const std::string& fullFilePath, unsigned long long& generationOut);
+
+			/*
+				Signals a change that was not written through this accessor, for example to a sidecar file.
+				Increments the generation and updates the modification time of the file,
+				so file watchers detect the change.
+			*/
+			Error markAsChanged() const;
+
 
 
 		private:
 			Error readFile_internal(QByteArray& fileDataOut) const;
 			Error writeFile_internal(const QByteArray& fileData) const;
+			bool incrementGeneration() const;
 
 			Log::LogObject* m_logger = nullptr;
 
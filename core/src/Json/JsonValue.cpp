@@ -314,6 +314,83 @@ namespace JsonDatabase
         return !(*this == other);
     }
 
+    // FNV-1a over the raw bytes, the type index gets mixed in first so that "1" and 1 differ
+    static constexpr unsigned long long s_hashOffset = 14695981039346656037ull;
+    static constexpr unsigned long long s_hashPrime = 1099511628211ull;
+    static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= s_hashPrime;
+        }
+        return hash;
+    }
+    static unsigned long long hashCombine(unsigned long long hash, unsigned long long value)
+    {
+        return hashBytes(hash, &value, sizeof(value));
+    }
+
+    unsigned long long JsonValue::getHash() const
+    {
+        unsigned long long hash = hashCombine(s_hashOffset, m_value.index());
+        switch (m_value.index())
+        {
+            case 1:
+            {
+                const std::string& str = std::get<std::string>(m_value);
+                return hashBytes(hash, str.data(), str.size());
+            }
+            case 2:
+            {
+                long value = std::get<long>(m_value);
+                return hashBytes(hash, &value, sizeof(value));
+            }
+            case 3:
+            {
+                double value = std::get<double>(m_value);
+                if (value == 0.0)
+                    value = 0.0; // -0.0 and 0.0 compare equal
+                return hashBytes(hash, &value, sizeof(value));
+            }
+            case 4:
+            {
+                unsigned char value = std::get<bool>(m_value) ? 1 : 0;
+                return hashBytes(hash, &value, sizeof(value));
+            }
+            case 5:
+            {
+                const std::shared_ptr<JsonArray>& array = std::get<std::shared_ptr<JsonArray>>(m_value);
+                return hashCombine(hash, array ? getHash(*array) : 0);
+            }
+            case 6:
+            {
+                const std::shared_ptr<JsonObject>& object = std::get<std::shared_ptr<JsonObject>>(m_value);
+                return hashCombine(hash, object ? getHash(*object) : 0);
+            }
+        }
+        return hash;
+    }
+    unsigned long long JsonValue::getHash(const JsonArray& array)
+    {
+        unsigned long long hash = hashCombine(s_hashOffset, array.size());
+        for (const JsonValue& value : array)
+            hash = hashCombine(hash, value.getHash());
+        return hash;
+    }
+    unsigned long long JsonValue::getHash(const JsonObject& object)
+    {
+        // The map is ordered, equal objects get iterated in the same order
+        unsigned long long hash = hashCombine(s_hashOffset, object.size());
+        for (const auto& pair : object)
+        {
+            hash = hashBytes(hash, pair.first.data(), pair.first.size());
+            hash = hashCombine(hash, pair.second.getHash());
+        }
+        return hash;
+    }
+
 
 
         // Convert value to string representation
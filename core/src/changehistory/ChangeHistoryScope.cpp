@@ -0,0 +1,30 @@
+#include "changehistory/ChangeHistoryScope.h"
+
+namespace JsonDatabase
+{
+	// Innermost scope of the current thread
+	static thread_local const ChangeHistoryScope* s_currentScope = nullptr;
+
+	ChangeHistoryScope::ChangeHistoryScope(ChangeHistoryMode mode, size_t ringBufferSize)
+		: m_previous(s_currentScope)
+		, m_mode(mode)
+		, m_ringBufferSize(ringBufferSize)
+	{
+		if (m_ringBufferSize == 0)
+			m_ringBufferSize = 1;
+		s_currentScope = this;
+	}
+	ChangeHistoryScope::~ChangeHistoryScope()
+	{
+		s_currentScope = m_previous;
+	}
+
+	bool ChangeHistoryScope::getCurrentMode(ChangeHistoryMode& modeOut, size_t& ringBufferSizeOut)
+	{
+		if (!s_currentScope)
+			return false;
+		modeOut = s_currentScope->m_mode;
+		ringBufferSizeOut = s_currentScope->m_ringBufferSize;
+		return true;
+	}
+}
@@ -0,0 +1,423 @@
+#include "manager/JDChangeJournal.h"
+#include "object/JDObjectInterface.h"
+#include "utilities/filesystem/LockedFileAccessor.h"
+
+#include "Json/JsonValue.h"
+#include "Json/JsonDeserializer.h"
+#include "Json/JsonSerializer.h"
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <mutex>
+#include <iomanip>
+
+namespace JsonDatabase
+{
+	namespace Internal
+	{
+		const std::string JDChangeJournal::s_magic = "JDJ2";
+
+		size_t JDChangeJournal::s_maxEntries = 1000;
+
+		bool JDChangeJournal::FileStamp::operator==(const FileStamp& other) const
+		{
+			return generation == other.generation &&
+				fileSize == other.fileSize &&
+				modificationTime == other.modificationTime;
+		}
+		bool JDChangeJournal::FileStamp::operator!=(const FileStamp& other) const
+		{
+			return !(*this == other);
+		}
+
+		JDChangeJournal::JDChangeJournal(const std::string& filePath, Log::LogObject* logger)
+			: m_filePath(filePath)
+			, m_logger(logger)
+		{
+
+		}
+		JDChangeJournal::~JDChangeJournal()
+		{
+
+		}
+
+		const std::string& JDChangeJournal::getFilePath() const
+		{
+			return m_filePath;
+		}
+
+		bool JDChangeJournal::append(const std::vector<const JsonObject*>& upserted,
+									 const std::vector<JDObjectID::IDType>& removed,
+									 const FileStamp& fileStamp,
+									 State& stateOut,
+									 int64_t& firstSequenceOut)
+		{
+			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
+			State state;
+			bool rewriteRequired = false;
+			if (!readState(state))
+			{
+				// Start a new journal, clients of the old epoch will fall back to a full load
+				if (m_logger)m_logger->logWarning("Can't read the change journal, it will be reset: " + m_filePath);
+				state = State();
+				rewriteRequired = true;
+			}
+			if (state.epoch.size() == 0)
+			{
+				state.epoch = createEpoch();
+				rewriteRequired = true;
+			}
+
+			JsonSerializer serializer;
+			serializer.enableTabs(false);
+			serializer.enableNewLinesInObjects(false);
+			serializer.enableNewLineAfterObject(false);
+			serializer.enableSpaces(false);
+
+			std::string prefixEnd = ";" + std::to_string(fileStamp.generation) +
+									";" + std::to_string(fileStamp.fileSize) +
+									";" + std::to_string(fileStamp.modificationTime) + ";";
+			std::vector<std::string> newLines;
+			newLines.reserve(upserted.size() + removed.size());
+			firstSequenceOut = state.lastSequence + 1;
+			for (const JsonObject* obj : upserted)
+			{
+				if (!obj)
+					continue;
+				newLines.push_back(std::to_string(++state.lastSequence) + ";" + operationToString(Operation::upsert) +
+								   prefixEnd + serializer.serializeObject(*obj) + "\n");
+			}
+			for (const JDObjectID::IDType& id : removed)
+			{
+				newLines.push_back(std::to_string(++state.lastSequence) + ";" + operationToString(Operation::remove) +
+								   prefixEnd + serializer.serializeValue(JsonValue(id)) + "\n");
+			}
+			state.lastFileStamp = fileStamp;
+
+			size_t entryCount = static_cast<size_t>(state.lastSequence - state.firstSequence + 1);
+			if (!rewriteRequired && entryCount <= 2 * s_maxEntries)
+			{
+				std::ofstream file(m_filePath, std::ios::binary | std::ios::app);
+				if (!file.is_open())
+				{
+					if (m_logger)m_logger->logError("Can't open the change journal for writing: " + m_filePath);
+					return false;
+				}
+				for (const std::string& line : newLines)
+					file << line;
+				file.close();
+				if (file.fail())
+					return false;
+				stateOut = state;
+				return true;
+			}
+
+			// Compact the journal to the latest entries
+			std::vector<std::string> entryLines;
+			if (!rewriteRequired)
+			{
+				std::vector<std::string> lines;
+				if (readLines(lines) && lines.size() > 0)
+				{
+					entryLines.reserve(lines.size() - 1 + newLines.size());
+					for (size_t i = 1; i < lines.size(); ++i)
+						entryLines.push_back(lines[i] + "\n");
+				}
+			}
+			entryLines.insert(entryLines.end(), newLines.begin(), newLines.end());
+			size_t keep = std::min(entryLines.size(), s_maxEntries);
+			state.firstSequence = state.lastSequence - static_cast<int64_t>(keep) + 1;
+
+			std::string content = s_magic + ";" + state.epoch + ";" + std::to_string(state.firstSequence) + "\n";
+			for (size_t i = entryLines.size() - keep; i < entryLines.size(); ++i)
+				content += entryLines[i];
+			if (!rewrite(content))
+				return false;
+			stateOut = state;
+			return true;
+		}
+
+		bool JDChangeJournal::read(int64_t afterSequence, std::vector<Entry>& entriesOut, State& stateOut) const
+		{
+			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
+			entriesOut.clear();
+			stateOut = State();
+
+			std::vector<std::string> lines;
+			if (!readLines(lines))
+				return false;
+			if (lines.size() == 0)
+				return true; // No changes recorded yet
+			if (!parseHeader(lines[0], stateOut))
+				return false;
+
+			int64_t expectedSequence = stateOut.firstSequence;
+			for (size_t i = 1; i < lines.size(); ++i)
+			{
+				int64_t sequence;
+				Operation operation;
+				FileStamp fileStamp;
+				size_t jsonPos;
+				if (!parseEntryPrefix(lines[i], sequence, operation, fileStamp, jsonPos) ||
+					sequence != expectedSequence)
+					return false;
+				++expectedSequence;
+				stateOut.lastSequence = sequence;
+				stateOut.lastFileStamp = fileStamp;
+				if (sequence <= afterSequence)
+					continue;
+
+				Entry entry;
+				if (!parseEntry(lines[i], entry))
+					return false;
+				entriesOut.push_back(std::move(entry));
+			}
+			return true;
+		}
+		bool JDChangeJournal::readState(State& stateOut) const
+		{
+			stateOut = State();
+			std::ifstream file(m_filePath, std::ios::binary);
+			if (!file.is_open())
+				return true; // No changes recorded yet
+			std::string header;
+			if (!std::getline(file, header))
+				return true; // Empty file
+			file.close();
+			if (!parseHeader(header, stateOut))
+				return false;
+
+			std::string lastLine;
+			if (!readLastLine(lastLine))
+				return false;
+			if (lastLine.compare(0, s_magic.size(), s_magic) == 0)
+				return true; // Only the header, no entries
+
+			Operation operation;
+			size_t jsonPos;
+			return parseEntryPrefix(lastLine, stateOut.lastSequence, operation, stateOut.lastFileStamp, jsonPos) &&
+				stateOut.lastSequence >= stateOut.firstSequence;
+		}
+
+		bool JDChangeJournal::readFileStamp(const std::string& databaseFilePath, FileStamp& stampOut)
+		{
+			stampOut = FileStamp();
+			LockedFileAccessor::readGeneration(databaseFilePath, stampOut.generation);
+			std::error_code ec;
+			stampOut.fileSize = std::filesystem::file_size(databaseFilePath, ec);
+			if (ec)
+				return false;
+			stampOut.modificationTime = std::filesystem::last_write_time(databaseFilePath, ec).time_since_epoch().count();
+			return !ec;
+		}
+
+		void JDChangeJournal::setMaxEntries(size_t count)
+		{
+			s_maxEntries = count;
+		}
+		size_t JDChangeJournal::getMaxEntries()
+		{
+			return s_maxEntries;
+		}
+
+		bool JDChangeJournal::readLines(std::vector<std::string>& linesOut) const
+		{
+			linesOut.clear();
+			std::ifstream file(m_filePath, std::ios::binary);
+			if (!file.is_open())
+				return true;
+			std::stringstream buffer;
+			buffer << file.rdbuf();
+			std::string content = buffer.str();
+			if (content.size() == 0)
+				return true;
+			if (content.back() != '\n')
+				return false; // Incomplete write
+
+			size_t start = 0;
+			while (start < content.size())
+			{
+				size_t end = content.find('\n', start);
+				linesOut.push_back(content.substr(start, end - start));
+				start = end + 1;
+			}
+			return true;
+		}
+		bool JDChangeJournal::parseHeader(const std::string& line, State& stateOut) const
+		{
+			// JDJ1;<epoch>;<first sequence>
+			size_t pos1 = line.find(';');
+			size_t pos2 = line.find(';', pos1 + 1);
+			if (pos1 == std::string::npos || pos2 == std::string::npos ||
+				line.substr(0, pos1) != s_magic)
+				return false;
+			stateOut.epoch = line.substr(pos1 + 1, pos2 - pos1 - 1);
+			char* end = nullptr;
+			stateOut.firstSequence = std::strtoll(line.c_str() + pos2 + 1, &end, 10);
+			if (stateOut.epoch.size() == 0 || !end || *end != '\0' || stateOut.firstSequence < 1)
+				return false;
+			stateOut.lastSequence = stateOut.firstSequence - 1;
+			return true;
+		}
+		bool JDChangeJournal::parseEntryPrefix(const std::string& line, int64_t& sequenceOut, Operation& operationOut,
+											   FileStamp& fileStampOut, size_t& jsonPosOut)
+		{
+			// <sequence>;<operation>;<generation>;<size>;<mtime>;<json>
+			size_t pos1 = line.find(';');
+			size_t pos2 = line.find(';', pos1 + 1);
+			size_t pos3 = line.find(';', pos2 + 1);
+			size_t pos4 = line.find(';', pos3 + 1);
+			size_t pos5 = line.find(';', pos4 + 1);
+			if (pos1 == std::string::npos || pos2 == std::string::npos || pos3 == std::string::npos ||
+				pos4 == std::string::npos || pos5 == std::string::npos)
+				return false;
+			char* end = nullptr;
+			sequenceOut = std::strtoll(line.c_str(), &end, 10);
+			if (end != line.c_str() + pos1)
+				return false;
+			std::string operation = line.substr(pos1 + 1, pos2 - pos1 - 1);
+			if (operation == operationToString(Operation::upsert))
+				operationOut = Operation::upsert;
+			else if (operation == operationToString(Operation::remove))
+				operationOut = Operation::remove;
+			else
+				return false;
+			fileStampOut.generation = std::strtoull(line.c_str() + pos2 + 1, &end, 10);
+			if (end != line.c_str() + pos3)
+				return false;
+			fileStampOut.fileSize = std::strtoull(line.c_str() + pos3 + 1, &end, 10);
+			if (end != line.c_str() + pos4)
+				return false;
+			fileStampOut.modificationTime = std::strtoll(line.c_str() + pos4 + 1, &end, 10);
+			if (end != line.c_str() + pos5)
+				return false;
+			jsonPosOut = pos5 + 1;
+			return true;
+		}
+		bool JDChangeJournal::parseEntry(const std::string& line, Entry& entryOut) const
+		{
+			size_t jsonPos;
+			if (!parseEntryPrefix(line, entryOut.sequence, entryOut.operation, entryOut.fileStamp, jsonPos))
+				return false;
+			JsonDeserializer deserializer;
+			std::string json = line.substr(jsonPos);
+			if (entryOut.operation == Operation::upsert)
+			{
+				if (!deserializer.deserializeObject(json, entryOut.data))
+					return false;
+				entryOut.objectID = JDObjectInterface::getIDFromJson(entryOut.data);
+			}
+			else
+			{
+				JsonValue id;
+				if (!deserializer.deserializeValue(json, id))
+					return false;
+				entryOut.objectID = JDObjectInterface::getIDFromJson(id);
+			}
+			return true;
+		}
+		bool JDChangeJournal::readLastLine(std::string& lineOut) const
+		{
+			lineOut.clear();
+			std::ifstream file(m_filePath, std::ios::binary);
+			if (!file.is_open())
+				return false;
+			file.seekg(0, std::ios::end);
+			std::streamoff size = file.tellg();
+			if (size <= 0)
+				return false;
+
+			char last;
+			file.seekg(size - 1);
+			file.get(last);
+			if (last != '\n')
+				return false; // Incomplete write
+
+			// Search the newline in front of the last line, chunk by chunk from the end
+			const std::streamoff chunkSize = 4096;
+			std::string tail;
+			std::streamoff end = size - 1;
+			while (end > 0)
+			{
+				std::streamoff start = end > chunkSize ? end - chunkSize : 0;
+				std::string chunk(static_cast<size_t>(end - start), '\0');
+				file.seekg(start);
+				file.read(&chunk[0], end - start);
+				if (file.fail())
+					return false;
+				tail = chunk + tail;
+				size_t pos = chunk.find_last_of('\n');
+				if (pos != std::string::npos)
+				{
+					lineOut = tail.substr(pos + 1);
+					return true;
+				}
+				end = start;
+			}
+			lineOut = tail;
+			return true;
+		}
+
+		std::string JDChangeJournal::createEpoch()
+		{
+			// Time and random number, so that two resets never get the same epoch
+			static std::mutex mutex;
+			static std::mt19937_64 generator(std::random_device{}());
+			unsigned long long random;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				random = generator();
+			}
+			long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+			std::stringstream ss;
+			ss << std::hex << now << std::setw(16) << std::setfill('0') << random;
+			return ss.str();
+		}
+
+		bool JDChangeJournal::rewrite(const std::string& content) const
+		{
+			std::string tmpFilePath = m_filePath + ".tmp";
+			{
+				std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					if (m_logger)m_logger->logError("Can't open the change journal for writing: " + tmpFilePath);
+					return false;
+				}
+				file << content;
+				file.close();
+				if (file.fail())
+					return false;
+			}
+			std::error_code ec;
+			for (int attempt = 0; attempt < 10; ++attempt)
+			{
+				std::filesystem::rename(tmpFilePath, m_filePath, ec);
+				if (!ec)
+					return true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			if (m_logger)m_logger->logError("Can't replace the change journal: " + m_filePath + " " + ec.message());
+			std::filesystem::remove(tmpFilePath, ec);
+			return false;
+		}
+
+		const std::string& JDChangeJournal::operationToString(Operation op)
+		{
+			switch (op)
+			{
+			case Operation::upsert: { static const std::string msg = "u"; return msg; }
+			case Operation::remove: { static const std::string msg = "r"; return msg; }
+			}
+			static const std::string unknown = "";
+			return unknown;
+		}
+	}
+}
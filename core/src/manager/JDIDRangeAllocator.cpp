@@ -0,0 +1,168 @@
+#include "manager/JDIDRangeAllocator.h"
+#include "manager/JDManagerFileSystem.h"
+#include "utilities/filesystem/FileLock.h"
+
+#include "Json/JsonValue.h"
+#include "Json/JsonDeserializer.h"
+#include "Json/JsonSerializer.h"
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+
+namespace JsonDatabase
+{
+	namespace Internal
+	{
+		const std::string JDIDRangeAllocator::s_fileName = "idAllocator";
+		const std::string JDIDRangeAllocator::JsonKeys::next = "next";
+
+		JDIDRangeAllocator::JDIDRangeAllocator(const std::string& databasePath, Log::LogObject* logger)
+			: m_databasePath(databasePath)
+			, m_logger(logger)
+		{
+
+		}
+		JDIDRangeAllocator::~JDIDRangeAllocator()
+		{
+
+		}
+
+		bool JDIDRangeAllocator::reserve(size_t count,
+										 const JDObjectID::IDType& minFirst,
+										 unsigned int timeoutMs,
+										 JDObjectID::IDType& firstOut,
+										 JDObjectID::IDType& lastOut)
+		{
+			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+			if (count == 0)
+				return false;
+			FileLock lock(m_databasePath, s_fileName, m_logger);
+			Error err;
+			if (!lock.lock(timeoutMs, err))
+			{
+				if (m_logger)m_logger->logError(std::string("Can't lock the ID allocator: ") + errorToString(err));
+				return false;
+			}
+
+			JDObjectID::IDType next = JDObjectID::defaultID;
+			if (!read(next))
+			{
+				if (m_logger)m_logger->logError("Can't read the ID allocator: " + getFilePath());
+				return false;
+			}
+			if (next < minFirst)
+				next = minFirst;
+
+			JDObjectID::IDType maxCount = std::numeric_limits<JDObjectID::IDType>::max() - next;
+			if (maxCount <= 0)
+			{
+				if (m_logger)m_logger->logError("The ID allocator has no free IDs left");
+				return false;
+			}
+			if (count > static_cast<size_t>(maxCount))
+				count = static_cast<size_t>(maxCount);
+
+			firstOut = next;
+			lastOut = next + static_cast<JDObjectID::IDType>(count) - 1;
+			if (!write(lastOut + 1))
+				return false;
+			lock.unlock(err);
+			return true;
+#else
+			JD_UNUSED(count);
+			JD_UNUSED(minFirst);
+			JD_UNUSED(timeoutMs);
+			JD_UNUSED(firstOut);
+			JD_UNUSED(lastOut);
+			return false; // IDs which are not numbers can't be reserved as a range
+#endif
+		}
+
+		bool JDIDRangeAllocator::read(JDObjectID::IDType& nextOut) const
+		{
+			std::error_code ec;
+			if (!std::filesystem::exists(getFilePath(), ec) && !ec)
+				return true; // No IDs reserved yet
+
+			std::ifstream file(getFilePath(), std::ios::binary);
+			if (!file.is_open())
+			{
+				if (m_logger)m_logger->logError("Can't open the ID allocator for reading: " + getFilePath());
+				return false;
+			}
+			std::stringstream buffer;
+			buffer << file.rdbuf();
+			std::string content = buffer.str();
+
+			// The record gets replaced as a whole, an empty or broken record is never written.
+			// Starting from the default ID again would hand out IDs of other sessions.
+			JsonDeserializer deserializer;
+			JsonObject obj;
+			const JDObjectID::IDType* next = nullptr;
+			if (content.size() > 0 && deserializer.deserializeObject(content, obj))
+			{
+				auto it = obj.find(JsonKeys::next);
+				if (it != obj.end())
+					next = it->second.get_if<JDObjectID::IDType>();
+			}
+			if (!next || *next < JDObjectID::defaultID)
+			{
+				if (m_logger)m_logger->logError("The ID allocator is corrupted: " + getFilePath() + " content: \"" + content + "\"");
+				return false;
+			}
+			nextOut = *next;
+			return true;
+		}
+		bool JDIDRangeAllocator::write(const JDObjectID::IDType& next) const
+		{
+			JsonObject obj;
+			obj[JsonKeys::next] = next;
+
+			JsonSerializer serializer;
+			serializer.enableTabs(false);
+			serializer.enableNewLinesInObjects(false);
+			serializer.enableSpaces(false);
+			std::string data = serializer.serializeObject(obj);
+
+			// A crash while writing must not leave a truncated record behind,
+			// the record gets written to a temporary file which then replaces it
+			std::string filePath = getFilePath();
+			std::string tmpFilePath = filePath + ".tmp";
+			{
+				std::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					if (m_logger)m_logger->logError("Can't open the ID allocator for writing: " + tmpFilePath);
+					return false;
+				}
+				file << data;
+				file.close();
+				if (file.fail())
+				{
+					if (m_logger)m_logger->logError("Can't write the ID allocator: " + tmpFilePath);
+					return false;
+				}
+			}
+			std::error_code ec;
+			for (int attempt = 0; attempt < 10; ++attempt)
+			{
+				std::filesystem::rename(tmpFilePath, filePath, ec);
+				if (!ec)
+					return true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			if (m_logger)m_logger->logError("Can't replace the ID allocator: " + filePath + " " + ec.message());
+			std::filesystem::remove(tmpFilePath, ec);
+			return false;
+		}
+		std::string JDIDRangeAllocator::getFilePath() const
+		{
+			return m_databasePath + "\\" + s_fileName + JDManagerFileSystem::getJsonFileEnding();
+		}
+	}
+}
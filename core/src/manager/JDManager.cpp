@@ -1,4 +1,5 @@
 #include "manager/JDManager.h"
+#include "manager/JDChangeJournal.h"
 #include "object/JDObjectInterface.h"
 #include "object/JDObjectRegistry.h"
 #include "utilities/JDUniqueMutexLock.h"
@@ -12,6 +13,9 @@
 #include "manager/async/work/JDManagerWorkLoadSingleObject.h"
 #include "manager/async/work/JDManagerWorkSaveList.h"
 #include "manager/async/work/JDManagerWorkSaveSingle.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 
 
@@ -30,6 +34,10 @@ namespace JsonDatabase
         , JDManagerAsyncWorker(*this, m_mutex)
         , m_useZipFormat(false)
         , m_signalEntryUpdateLock(false)
+        , m_updateIntervalMs(100)
+        , m_maxIdleUpdateIntervalMs(2000)
+        , m_updateRequested(false)
+        , m_journalSequence(-1)
     {
         qRegisterMetaType<std::vector<JDObject>>();
         qRegisterMetaType<JDObject>();
@@ -43,7 +51,8 @@ namespace JsonDatabase
         JDManagerObjectManager::setDomainName(m_user.getSessionID());
 
 		connect(&m_updateTimer, &QTimer::timeout, this, &JDManager::update);
-        m_updateTimer.setInterval(100);
+        m_updateTimer.setInterval(m_updateIntervalMs);
+        m_signalsToEmit.setChangeCallback([this] { requestUpdate(); });
     }
     JDManager::JDManager(const JDManager &other)
         : JDManagerObjectManager(*this, m_mutex)
@@ -52,6 +61,10 @@ namespace JsonDatabase
         , m_user(other.m_user)
         , m_useZipFormat(other.m_useZipFormat)
         , m_signalEntryUpdateLock(false)
+        , m_updateIntervalMs(other.m_updateIntervalMs)
+        , m_maxIdleUpdateIntervalMs(other.m_maxIdleUpdateIntervalMs)
+        , m_updateRequested(false)
+        , m_journalSequence(-1)
     {
         if (other.m_logger)
         {
@@ -65,7 +78,8 @@ namespace JsonDatabase
         m_user = Utilities::JDUser::generateUser(m_user.getName());
         JDManagerObjectManager::setDomainName(m_user.getSessionID());
         connect(&m_updateTimer, &QTimer::timeout, this, &JDManager::update);
-        m_updateTimer.setInterval(other.m_updateTimer.interval());
+        m_updateTimer.setInterval(m_updateIntervalMs);
+        m_signalsToEmit.setChangeCallback([this] { requestUpdate(); });
     }
 JDManager::~JDManager()
 {
@@ -75,8 +89,13 @@ JDManager::~JDManager()
 
 void JDManager::setUpdateInterval(int ms)
 {
+    m_updateIntervalMs = ms;
 	m_updateTimer.setInterval(ms);
 }
+void JDManager::setMaxIdleUpdateInterval(int ms)
+{
+    m_maxIdleUpdateIntervalMs = ms;
+}
 bool JDManager::setup(const std::string& databasePath,
                       const std::string& databaseName)
 {
@@ -152,9 +171,11 @@ bool JDManager::loadObject(const JDObject &obj)
     JDM_UNIQUE_LOCK_P;
     return loadObject_internal(obj, nullptr);
 }
-void JDManager::loadObjectAsync(const JDObject &obj)
+JDAsyncHandle JDManager::loadObjectAsync(const JDObject &obj)
 {
-    JDManagerAsyncWorker::addWork(std::make_shared<Internal::JDManagerAysncWorkLoadSingleObject>(*this, m_mutex, obj));
+    std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkLoadSingleObject>(*this, m_mutex, obj);
+    JDManagerAsyncWorker::addWork(work);
+    return work->getHandle();
 }
 bool JDManager::loadObjects(int mode)
 {
@@ -165,9 +186,11 @@ bool JDManager::loadObjects(int mode, Internal::WorkProgress* progress)
 	JDM_UNIQUE_LOCK_P;
 	return loadObjects_internal(mode, progress);
 }
-void JDManager::loadObjectsAsync(int mode)
+JDAsyncHandle JDManager::loadObjectsAsync(int mode)
 {
-    JDManagerAsyncWorker::addWork(std::make_shared < Internal::JDManagerAysncWorkLoadAllObjects>(*this, m_mutex, mode));
+    std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkLoadAllObjects>(*this, m_mutex, mode);
+    JDManagerAsyncWorker::addWork(work);
+    return work->getHandle();
 }
 bool JDManager::saveObject(const JDObject &obj)
 {
@@ -180,15 +203,17 @@ bool JDManager::saveObject(const JDObject &obj)
     }
     return saveObject_internal(obj, s_fileLockTimeoutMs, nullptr);
 }
-void JDManager::saveObjectAsync(const JDObject &obj)
+JDAsyncHandle JDManager::saveObjectAsync(const JDObject &obj)
 {
     if (!JDManagerObjectManager::exists(obj))
     {
         if (m_logger)
             m_logger->logError("Can't save object with ID: " + JDObjectID::toString(obj->getShallowObjectID()) + " which does not exist in the database.");
-        return;
+        return JDAsyncHandle();
     }
-    JDManagerAsyncWorker::addWork(std::make_shared < Internal::JDManagerAysncWorkSaveSingle>(*this, m_mutex, obj));
+    std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkSaveSingle>(*this, m_mutex, obj);
+    JDManagerAsyncWorker::addWork(work);
+    return work->getHandle();
 }
 bool JDManager::saveObjects()
 {
@@ -216,12 +241,14 @@ bool JDManager::saveObjects(const std::vector<JDObject>& objs)
     }
     return saveObjects_internal(objs, s_fileLockTimeoutMs, nullptr);
 }
-void JDManager::saveObjectsAsync()
+JDAsyncHandle JDManager::saveObjectsAsync()
 {
     std::vector<JDObject> objs = JDManagerObjectManager::getObjects();
-    JDManagerAsyncWorker::addWork(std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, objs, m_logger));
+    std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, objs, m_logger);
+    JDManagerAsyncWorker::addWork(work);
+    return work->getHandle();
 }
-void JDManager::saveObjectsAsync(const std::vector<JDObject>& objs)
+JDAsyncHandle JDManager::saveObjectsAsync(const std::vector<JDObject>& objs)
 {
     if (!JDManagerObjectManager::exists(objs))
     {
@@ -236,10 +263,13 @@ void JDManager::saveObjectsAsync(const std::vector<JDObject>& objs)
                     m_logger->logError("Can't save object with ID: " + objs[i]->getObjectID()->toString() + " which does not exist in the database.");
             }
         }
-        JDManagerAsyncWorker::addWork(std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, tmp, m_logger));
-        return;
+        std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, tmp, m_logger);
+        JDManagerAsyncWorker::addWork(work);
+        return work->getHandle();
     }
-    JDManagerAsyncWorker::addWork(std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, objs, m_logger));
+    std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, objs, m_logger);
+    JDManagerAsyncWorker::addWork(work);
+    return work->getHandle();
 }
 bool JDManager::saveLockedObjects()
 {
@@ -262,7 +292,7 @@ bool JDManager::saveLockedObjects()
     return false;
 }
 
-void JDManager::saveLockedObjectsAsync()
+JDAsyncHandle JDManager::saveLockedObjectsAsync()
 {
     std::vector<JDObjectLocker::LockData> lockedObjectsOut;
     Error err;
@@ -276,8 +306,11 @@ void JDManager::saveLockedObjectsAsync()
             if (obj)
                 objs.push_back(obj);
         }
-        JDManagerAsyncWorker::addWork(std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, objs, m_logger));
+        std::shared_ptr<Internal::JDManagerAysncWork> work = std::make_shared<Internal::JDManagerAysncWorkSaveList>(*this, m_mutex, objs, m_logger);
+        JDManagerAsyncWorker::addWork(work);
+        return work->getHandle();
     }
+    return JDAsyncHandle();
 }
 void JDManager::setDefaultFileWatchMode(Internal::FileChangeWatcher::Mode mode)
 {
@@ -291,7 +324,7 @@ Internal::FileChangeWatcher::Mode JDManager::getDefaultFileWatchMode()
 bool JDManager::loadObject_internal(const JDObject& obj, Internal::WorkProgress* progress)
 {
     JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-    if (!JDManagerObjectManager::exists_internal(obj))
+    if (!JDManagerObjectManager::exists(obj))
         return false;
     if (m_logger)
         m_logger->log("Loading object with ID: " + obj->getObjectID()->toString(), Log::Level::info);
@@ -327,6 +360,11 @@ bool JDManager::loadObject_internal(const JDObject& obj, Internal::WorkProgress*
         if (m_logger)m_logger->logError(std::string("bool JDManager::loadObject_internal(JDObject): Error: ") + errorToString(fileError));
 		return false;
 	}
+    if (progress && progress->isAbortRequested())
+    {
+        if (m_logger)m_logger->logInfo("Loading object with ID: " + obj->getObjectID()->toString() + " aborted");
+        return false;
+    }
 
 
     size_t index = JDObjectInterface::getJsonIndexByID(jsons, id->get());
@@ -363,6 +401,16 @@ bool JDManager::loadObjects_internal(int mode, Internal::WorkProgress* progress)
     JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
     if(m_logger)
         m_logger->log("Loading objects with mode: " + getLoadModeStr(mode), Log::Level::info);
+    if (mode & (int)LoadMode::incremental)
+    {
+        bool fullLoadRequired = false;
+        bool incrementalSuccess = loadObjectsIncremental_internal(mode, progress, fullLoadRequired);
+        if (!fullLoadRequired)
+            return incrementalSuccess;
+        if (m_logger)
+            m_logger->logInfo("Change journal does not cover the last load, loading all objects");
+        mode &= ~(int)LoadMode::incremental;
+    }
     double progressScalar = 0;
     if (progress)
     {
@@ -396,7 +444,26 @@ bool JDManager::loadObjects_internal(int mode, Internal::WorkProgress* progress)
         if (m_logger)m_logger->logError(std::string("bool JDManager::loadObject_internal(JDObject): Error: ") + errorToString(fileError) + "\n");
         return false;
     }
+    if (progress && progress->isAbortRequested())
+    {
+        // Stale load, the parsed data does not get applied
+        if (m_logger)m_logger->logInfo("Loading objects aborted");
+        return false;
+    }
 
+    if ((mode & (int)LoadMode::allObjects) == (int)LoadMode::allObjects)
+    {
+        // After a full load, the objects are up to date with the latest journal entry
+        JDChangeJournal journal(getDatabaseChangeJournalFilePath(), m_logger);
+        JDChangeJournal::State state;
+        JDChangeJournal::FileStamp fileStamp;
+        bool journalValid = journal.readState(state) && state.epoch.size() != 0 &&
+                            JDChangeJournal::readFileStamp(fileAccessor.getFullFilePath(), fileStamp);
+        JDM_UNIQUE_LOCK_M(m_journalMutex);
+        m_journalEpoch = state.epoch;
+        m_journalSequence = journalValid ? state.lastSequence : -1;
+        m_journalFileStamp = fileStamp;
+    }
 
     //bool modeNewObjects = (mode & (int)LoadMode::newObjects);
     //bool modeChangedObjects = (mode & (int)LoadMode::changedObjects);
@@ -548,11 +615,15 @@ bool JDManager::saveObject_internal(const JDObject &obj, unsigned int timeoutMil
             jsons.erase(jsons.begin() + index);
         }
     }
-    else
+    unsigned long long contentHash = 0;
+    const JsonObject* savedData = nullptr;
+    if (!obj->markedForRemoval())
     {
         if (progress) progress->setComment("Serializing object");
         std::shared_ptr<JsonObject> data = std::make_shared<JsonObject>();
+        savedData = data.get();
         success &= obj->saveInternal(*data);
+        contentHash = Internal::JDObjectManager::getContentHash(*data);
         if (index == std::string::npos)
         {
             jsons.push_back(std::move(data));
@@ -575,6 +646,13 @@ bool JDManager::saveObject_internal(const JDObject &obj, unsigned int timeoutMil
         if (m_logger)m_logger->logError(std::string("bool JDManager::saveObject_internal(JDObject, unsigned int timeoutMs): Error: ") + errorToString(fileError));
         success = false;
     }
+    else
+    {
+        if (obj->markedForRemoval())
+            appendToChangeJournal({}, { ID->get() }, fileAccessor.getFullFilePath());
+        else
+            appendToChangeJournal({ savedData }, {}, fileAccessor.getFullFilePath());
+    }
     if(m_logger)
         if(success)
             m_logger->log("Object (id="+ ID.get()->toString() + ") saved successfully", Log::Level::info, Log::Colors::green);
@@ -588,6 +666,8 @@ bool JDManager::saveObject_internal(const JDObject &obj, unsigned int timeoutMil
     {
 		//obj->markAsUnchanged();
         obj->clearChangeTransactions();
+        if (contentHash && obj->getManager())
+            obj->getManager()->setContentHash(contentHash);
     }
     return success;
 }
@@ -602,82 +682,60 @@ bool JDManager::saveObjects_internal(std::vector<JDObject> objList, unsigned int
     bool success = true;
     if(objList.size() == 0)
 		return true;
-    if(m_logger)
-		m_logger->log("Saving " + std::to_string(objList.size()) + " objects", Log::Level::info);
     double progressScalar = 0;
     if(progress)
         progressScalar = progress->getScalar();
 
-    std::vector<JDObjectLocker::LockData> lockedObjects;
+    // Only dirty objects get serialized and written, checking the dirty state is cheap
+    // compared to the lock checks and the file access.
+    std::vector<JDObject> dirtyObjs;
+    dirtyObjs.reserve(objList.size());
+    for (size_t i = 0; i < objList.size(); ++i)
+    {
+        if (objList[i]->hasChanges())
+            dirtyObjs.push_back(objList[i]);
+    }
+    if (m_logger && dirtyObjs.size() != objList.size())
+        m_logger->logInfo(std::to_string(objList.size() - dirtyObjs.size()) + " objects have no changes. They will not be saved");
+    objList = std::move(dirtyObjs);
+    if (objList.size() == 0)
+        return true;
+    if(m_logger)
+		m_logger->log("Saving " + std::to_string(objList.size()) + " objects", Log::Level::info);
+
+    // Object locks and the class and range locks of this session
+    std::vector<bool> lockedByMe;
     Error lockerError;
-    if (!m_objLocker.getLockedObjects(lockedObjects, lockerError))
+    if (!m_objLocker.areObjectsLockedByMe(objList, lockedByMe, lockerError))
     {
         if (m_logger)
 			m_logger->logError(std::string("bool JDManager::saveObjects_internal(const std::vector<JDObject>& objList, unsigned int timeoutMillis): Error: ") + errorToString(lockerError));
 		return false;
     }
 
-    bool notAllSaved = false;
-    int removedFromListCount = 0;
+    std::vector<JDObject> saveableObjs;
+    saveableObjs.reserve(objList.size());
     for (size_t i = 0; i < objList.size(); ++i)
     {
-		bool found = false;
-        for (size_t j = 0; j < lockedObjects.size(); ++j)
+        if (!lockedByMe[i])
         {
-            if (objList[i]->getShallowObjectID() == lockedObjects[j].objectID)
-            {
-				found = true;
-                if (lockedObjects[j].user.getSessionID() != m_user.getSessionID())
-                {
-                    if(m_logger)
-						m_logger->logWarning("Object (id=" + std::to_string(objList[i]->getShallowObjectID()) + ") is locked by another user. It will not be saved");
-                    objList.erase(objList.begin() + i);
-                    notAllSaved = true;
-                    success = false;
-                    ++removedFromListCount;
-                    --i;
-                }
-				break;
-			}
-		}
-        if (found)
-        {
-            if (objList[i]->hasWrongData())
-            {
-                if (m_logger)
-                    m_logger->logWarning("Object (id=" + std::to_string(objList[i]->getShallowObjectID()) + ") has wrong data. It will not be saved");
-                objList.erase(objList.begin() + i);
-                ++removedFromListCount;
-                notAllSaved = true;
-                success = false;
-                --i;
-                continue;
-            }
-            if (!objList[i]->hasChanges())
-            {
-                if (m_logger)
-                    m_logger->logInfo("Object (id=" + std::to_string(objList[i]->getShallowObjectID()) + ") has no changes. It will not be saved");
-                objList.erase(objList.begin() + i);
-                ++removedFromListCount;
-                notAllSaved = true;
-                --i;
-                continue;
-            }
+            if (m_logger)
+                m_logger->logWarning("Object (id=" + objList[i]->getObjectID()->toString() + ") is not locked by this user. It will not be saved");
+            success = false;
+            continue;
         }
-        else
+        if (objList[i]->hasWrongData())
         {
-			if (m_logger)
-				m_logger->logWarning("Object (id=" + std::to_string(objList[i]->getShallowObjectID()) + ") is not locked by this user. It will not be saved");
-			objList.erase(objList.begin() + i);
-            ++removedFromListCount;
+            if (m_logger)
+                m_logger->logWarning("Object (id=" + std::to_string(objList[i]->getShallowObjectID()) + ") has wrong data. It will not be saved");
             success = false;
-            notAllSaved = true;
-			--i;
-		}
-
-	}
-   
-
+            continue;
+        }
+        saveableObjs.push_back(objList[i]);
+    }
+    objList = std::move(saveableObjs);
+    if (objList.size() == 0)
+        return success;
 
     LockedFileAccessor fileAccessor(getDatabasePath(), getDatabaseFileName(), getJsonFileEnding(), m_logger);
     fileAccessor.setProgress(progress);
@@ -721,18 +779,16 @@ bool JDManager::saveObjects_internal(std::vector<JDObject> objList, unsigned int
             --j;
         }
     }
-    for (size_t i = 0; i < origJsonData.size(); ++i)
+    if (removedObjs.size())
     {
-        JDObjectID::IDType id = JDObjectInterface::getIDFromJson(origJsonData[i].get<JsonObject>());
+        std::unordered_set<JDObjectID::IDType> removedIDs;
+        removedIDs.reserve(removedObjs.size());
         for (size_t j = 0; j < removedObjs.size(); ++j)
-        {
-            if (id == removedObjs[j]->getShallowObjectID())
+            removedIDs.insert(removedObjs[j]->getShallowObjectID());
+        origJsonData.erase(std::remove_if(origJsonData.begin(), origJsonData.end(), [&removedIDs](const JsonValue& value)
             {
-                origJsonData.erase(origJsonData.begin() + i);
-                --i;
-                break;
-            }
-        }
+                return removedIDs.find(JDObjectInterface::getIDFromJson(value.get<JsonObject>())) != removedIDs.end();
+            }), origJsonData.end());
     }
     
     std::vector<bool> successList;
@@ -746,36 +802,36 @@ bool JDManager::saveObjects_internal(std::vector<JDObject> objList, unsigned int
     {
         successList = Internal::JDObjectManager::getJsonArray(objList, *jsonData);
     }
+    // The dirty state and the hashes get applied after the file was written
+    std::vector<unsigned long long> contentHashes(objList.size(), 0);
+    std::unordered_map<JDObjectID::IDType, size_t> serializedIndex;
+    serializedIndex.reserve(objList.size());
     for (size_t i = 0; i < objList.size(); ++i)
     {
         if (successList[i])
         {
-            //objList[i]->markAsUnchanged();
-            objList[i]->clearChangeTransactions();
-            if (m_logger)
-            {
-				m_logger->log("Object (id=" + objList[i]->getObjectID()->toString() + ") saved successfully", Log::Level::info, Log::Colors::green);
-            }
+            const JsonObject& objData = (*jsonData)[i].get<JsonObject>();
+            contentHashes[i] = Internal::JDObjectManager::getContentHash(objData);
+            serializedIndex[JDObjectInterface::getIDFromJson(objData)] = i;
         }
         success &= successList[i];
     }
 
+    // Replace the existing entries, the objects which are not in the file yet get appended
+    std::vector<bool> merged(jsonData->size(), false);
     for (size_t i = 0; i < origJsonData.size(); ++i)
     {
         const JsonObject& objData = origJsonData[i].get<JsonObject>();
-        size_t index = JDObjectInterface::getJsonIndexByID(*jsonData, JDObjectInterface::getIDFromJson(objData));
-        if (index == std::string::npos)
+        auto it = serializedIndex.find(JDObjectInterface::getIDFromJson(objData));
+        if (it == serializedIndex.end())
             continue;
-        origJsonData[i] = (*jsonData)[index];
-        jsonData->erase(jsonData->begin() + index);
-        //  ++replacedCount;
+        origJsonData[i] = (*jsonData)[it->second];
+        merged[it->second] = true;
     }
-    if (jsonData->size())
+    for (size_t i = 0; i < jsonData->size(); ++i)
     {
-        for (size_t i = 0; i < jsonData->size(); ++i)
-        {
+        if (successList[i] && !merged[i])
             origJsonData.push_back((*jsonData)[i]);
-        }
     }
     
     
@@ -788,6 +844,28 @@ bool JDManager::saveObjects_internal(std::vector<JDObject> objList, unsigned int
         if (m_logger)m_logger->logError(std::string("bool JDManager::saveObject_internal(const std::vector<JDObject>& objList, unsigned int timeoutMillis): Error: ") + errorToString(fileError));
 		success = false;
     }
+    else
+    {
+        std::vector<const JsonObject*> upsertedData;
+        std::vector<JDObjectID::IDType> removedIDs;
+        upsertedData.reserve(objList.size());
+        removedIDs.reserve(removedObjs.size());
+        for (size_t i = 0; i < objList.size(); ++i)
+            if (successList[i])
+            {
+                upsertedData.push_back(&(*jsonData)[i].get<JsonObject>());
+                // The save is committed, the object is clean again
+                //objList[i]->markAsUnchanged();
+                objList[i]->clearChangeTransactions();
+                if (objList[i]->getManager())
+                    objList[i]->getManager()->setContentHash(contentHashes[i]);
+                if (m_logger)
+                    m_logger->log("Object (id=" + objList[i]->getObjectID()->toString() + ") saved successfully", Log::Level::info, Log::Colors::green);
+            }
+        for (size_t i = 0; i < removedObjs.size(); ++i)
+            removedIDs.push_back(removedObjs[i]->getShallowObjectID());
+        appendToChangeJournal(upsertedData, removedIDs, fileAccessor.getFullFilePath());
+    }
     if (m_logger)
         if (success)
         {
@@ -802,15 +880,183 @@ bool JDManager::saveObjects_internal(std::vector<JDObject> objList, unsigned int
     // Free the locks of the removed objects
     std::vector<Error> errs;
     success &= m_objLocker.unlockObjects(removedObjs, errs);
-    for (size_t i = 0; i < removedObjs.size(); ++i)
+    if (removedObjs.size())
     {
-		unregisterAndRemove(removedObjs[i]);
+        Internal::JDSharedMutexLock lifetimeLock(m_managerLifetimeMutex, true);
+        JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
+        for (size_t i = 0; i < removedObjs.size(); ++i)
+            unregisterAndRemove(removedObjs[i]);
     }
     
 
     return success;
 }
 
+bool JDManager::loadObjectsIncremental_internal(int mode, Internal::WorkProgress* progress, bool& fullLoadRequiredOut)
+{
+    JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
+    fullLoadRequiredOut = false;
+    std::string knownEpoch;
+    int64_t knownSequence;
+    JDChangeJournal::FileStamp knownFileStamp;
+    {
+        JDM_UNIQUE_LOCK_M(m_journalMutex);
+        knownEpoch = m_journalEpoch;
+        knownSequence = m_journalSequence;
+        knownFileStamp = m_journalFileStamp;
+    }
+    if (knownSequence < 0)
+    {
+        fullLoadRequiredOut = true;
+        return false;
+    }
+    double progressScalar = 0;
+    if (progress)
+    {
+        progressScalar = progress->getScalar();
+    }
+
+    // The database file only gets locked, so that no writer changes the journal while it is read.
+    // The changed objects are read from the journal, the database file itself does not get read.
+    LockedFileAccessor fileAccessor(getDatabasePath(), getDatabaseFileName(), getJsonFileEnding(), m_logger);
+    fileAccessor.setProgress(progress);
+    fileAccessor.useZipFormat(m_useZipFormat);
+    Error fileError = fileAccessor.lock(LockedFileAccessor::AccessMode::read, s_fileLockTimeoutMs);
+    if (fileError != Error::none)
+    {
+        if (m_logger)m_logger->logError(std::string("bool JDManager::loadObjectsIncremental_internal(mode): Error: ") + errorToString(fileError));
+        return false;
+    }
+
+    if (progress)
+    {
+        progress->setComment("Reading change journal");
+        progress->startNewSubProgress(progressScalar * 0.5);
+    }
+    JDChangeJournal journal(getDatabaseChangeJournalFilePath(), m_logger);
+    std::vector<JDChangeJournal::Entry> entries;
+    JDChangeJournal::State state;
+    JDChangeJournal::FileStamp fileStamp;
+    if (!JDChangeJournal::readFileStamp(fileAccessor.getFullFilePath(), fileStamp) ||
+        !journal.read(knownSequence, entries, state) ||
+        state.epoch != knownEpoch ||
+        knownSequence + 1 < state.firstSequence ||
+        knownSequence > state.lastSequence ||
+        fileStamp != (knownSequence == state.lastSequence ? knownFileStamp : state.lastFileStamp))
+    {
+        // The journal was truncated or reset since the last load,
+        // or the database file was written without a journal entry
+        fullLoadRequiredOut = true;
+        return false;
+    }
+    fileAccessor.unlock();
+    if (knownSequence == state.lastSequence)
+        return true; // Nothing changed
+    if (progress && progress->isAbortRequested())
+    {
+        if (m_logger)m_logger->logInfo("Loading changed objects aborted");
+        return false;
+    }
+
+    // Only the latest operation of each object is relevant.
+    // The changes are applied in journal order, so the signals keep the order of the saves.
+    std::unordered_map<JDObjectID::IDType, const JDChangeJournal::Entry*> latestEntries;
+    for (const JDChangeJournal::Entry& entry : entries)
+        latestEntries[entry.objectID] = &entry;
+
+    std::vector<const JDChangeJournal::Entry*> changes;
+    changes.reserve(latestEntries.size());
+    JsonArray changedJsons;
+    changedJsons.reserve(latestEntries.size());
+    for (const JDChangeJournal::Entry& entry : entries)
+    {
+        if (latestEntries[entry.objectID] != &entry)
+            continue;
+        changes.push_back(&entry);
+        if (entry.operation == JDChangeJournal::Operation::upsert)
+            changedJsons.push_back(entry.data);
+    }
+
+    std::vector<JDObjectID::IDType> newObjIDs;
+    std::vector<JDObjectPair> pairsForSignal;
+    std::vector<JDObject> overridingObjs;
+    std::vector<JDObject> newObjInstances;
+    std::vector<JDObject> removedObjs;
+
+    if (progress)
+    {
+        progress->startNewSubProgress(progressScalar * 0.5);
+    }
+    // Removed objects are taken from the journal, the partial json array does not contain them
+    bool success = JDManagerObjectManager::loadObjectsFromJson_internal(changedJsons, mode & ~(int)LoadMode::removedObjects, progress,
+        overridingObjs,
+        newObjIDs,
+        newObjInstances,
+        removedObjs,
+        pairsForSignal);
+
+    if (mode & (int)LoadMode::removedObjects)
+    {
+        Internal::JDSharedMutexLock lifetimeLock(m_managerLifetimeMutex, true);
+        JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
+        for (const JDChangeJournal::Entry* change : changes)
+        {
+            if (change->operation != JDChangeJournal::Operation::remove)
+                continue;
+            JDObject obj = JDManagerObjectManager::getObject_internal(change->objectID);
+            if (obj)
+                success &= JDManagerObjectManager::unregisterAndRemove(obj);
+        }
+    }
+
+    if (success)
+    {
+        JDM_UNIQUE_LOCK_M(m_journalMutex);
+        if (m_journalEpoch == knownEpoch && m_journalSequence == knownSequence)
+        {
+            m_journalSequence = state.lastSequence;
+            m_journalFileStamp = fileStamp;
+        }
+    }
+
+    if (m_logger)
+        if (success)
+            m_logger->log("Loaded " + std::to_string(changes.size()) + " changes from the change journal", Log::Level::info, Log::Colors::green);
+        else
+            m_logger->logError("Changed objects can't be loaded");
+    UI::JDObjectListWidget::updateUI();
+    return success;
+}
+
+void JDManager::appendToChangeJournal(const std::vector<const JsonObject*>& upserted, 
+                                      const std::vector<JDObjectID::IDType>& removed, 
+                                      const std::string& databaseFilePath)
+{
+    if (upserted.size() == 0 && removed.size() == 0)
+        return;
+    // Readers compare the stamp with the database file, a failed read only leads to a full load on their side
+    JDChangeJournal::FileStamp fileStamp;
+    if (!JDChangeJournal::readFileStamp(databaseFilePath, fileStamp))
+    {
+        if (m_logger)m_logger->logWarning("Can't read the size and modification time of: " + databaseFilePath);
+    }
+    JDChangeJournal journal(getDatabaseChangeJournalFilePath(), m_logger);
+    JDChangeJournal::State state;
+    int64_t firstSequence;
+    if (!journal.append(upserted, removed, fileStamp, state, firstSequence))
+    {
+        if (m_logger)m_logger->logError("Can't append to the change journal: " + journal.getFilePath());
+        return;
+    }
+    // Our own changes are already loaded, as long as no other change is in between
+    JDM_UNIQUE_LOCK_M(m_journalMutex);
+    if (m_journalEpoch == state.epoch && m_journalSequence == firstSequence - 1)
+    {
+        m_journalSequence = state.lastSequence;
+        m_journalFileStamp = fileStamp;
+    }
+}
+
 void JDManager::onAsyncWorkDone(std::shared_ptr<Internal::JDManagerAysncWork> work)
 {
     if(!work)
@@ -858,7 +1104,21 @@ void JDManager::onObjectLockerFileChanged()
 {
 
 }
-void JDManager::emitSignals()
+void JDManager::requestUpdate()
+{
+    // Only one pending request at a time
+    if (m_updateRequested.exchange(true))
+        return;
+    QMetaObject::invokeMethod(this, [this] { onUpdateRequested(); }, Qt::QueuedConnection);
+}
+void JDManager::onUpdateRequested()
+{
+    m_updateRequested.store(false);
+    if (!m_setUp)
+        return;
+    update();
+}
+bool JDManager::emitSignals()
 {
     SignalData signalsToEmit = m_signalsToEmit.copyAndClear();
     if(signalsToEmit.getObjectLocked().size() > 0)
@@ -876,6 +1136,9 @@ void JDManager::emitSignals()
 	if (signalsToEmit.getObjectChanged().size() > 0)
 		emit objectChanged(signalsToEmit.getObjectChanged());
 
+	if (signalsToEmit.getObjectLockLost().size() > 0)
+		emit objectLockLost(signalsToEmit.getObjectLockLost());
+
     /*
     for (size_t i = 0; i < signalsToEmit.getObjectLocked().size(); ++i)
 		emit objectLocked(signalsToEmit.getObjectLocked()[i]);
@@ -895,6 +1158,15 @@ void JDManager::emitSignals()
 	if (signalsToEmit.lockedObjectsChanged())
 		emit lockedObjectsChanged();
 
+    return signalsToEmit.getObjectLocked().size() > 0 ||
+        signalsToEmit.getObjectUnlocked().size() > 0 ||
+        signalsToEmit.getObjectAdded().size() > 0 ||
+        signalsToEmit.getObjectRemoved().size() > 0 ||
+        signalsToEmit.getObjectChanged().size() > 0 ||
+        signalsToEmit.getObjectLockLost().size() > 0 ||
+        signalsToEmit.databaseFileChanged() ||
+        signalsToEmit.databaseOutdated() ||
+        signalsToEmit.lockedObjectsChanged();
 }
 
 
@@ -941,6 +1213,12 @@ const std::string& JDManager::getLoadModeStr(int mode) const
             str += "removedObjects";
         }
     }
+    if (mode & (int)LoadMode::incremental)
+    {
+        if (str.size())
+            str += " + ";
+        str += "incremental";
+    }
     /*if (mode & (int)LoadMode::overrideChanges)
     {
         if (str.size())
@@ -960,14 +1238,23 @@ void JDManager::update()
         return;
     m_signalEntryUpdateLock = true;
 
-    JDManagerAsyncWorker::process();
+    bool activity = JDManagerAsyncWorker::process();
     
     JDManagerFileSystem::update();
     JDManagerObjectManager::update();
     
     //m_signals.emitIfNotEmpty();
     //m_signals.emitQueue();
-	emitSignals();
+	activity |= emitSignals();
+    activity |= JDManagerAsyncWorker::isBusy();
+
+    // Back off while idle, events wake up the loop through requestUpdate()
+    int interval = m_updateIntervalMs;
+    if (!activity)
+        interval = std::max(std::min(m_updateTimer.interval() * 2, m_maxIdleUpdateIntervalMs), m_updateIntervalMs);
+    if (interval != m_updateTimer.interval())
+        m_updateTimer.setInterval(interval);
+
     m_signalEntryUpdateLock = false;
     m_updateMutex.unlock();
 
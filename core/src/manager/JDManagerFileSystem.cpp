@@ -16,6 +16,7 @@
 #include <QFile>
 #include <QDir>
 #include <QtEndian>
+#include <algorithm>
 #include <string>
 
 namespace JsonDatabase
@@ -30,15 +31,17 @@ namespace JsonDatabase
 			: m_logger(nullptr)
             , m_databaseFileName("data")
             , m_databaseChangeHistoryFileName("changeHistory")
+            , m_databaseChangeJournalFileName("changeJournal")
             , m_manager(manager)
             , m_mutex(mtx)
             , m_fileLock(nullptr)
-            , m_slowUpdateCounter(-1) // -1 to trigger first update
-            , m_middleUpdateCounter(-1) // -1 to trigger first update
+            , m_userCheckTask(1000, 30000)
             , m_userRegistration()
            // , m_databaseLoginFileLock(nullptr)
 		{
-
+            // Wake up the manager as soon as the database file changes
+            m_fileWatcher.setChangeCallback([this] { m_manager.requestUpdate(); });
+            m_leaseManager.setExpiredCallback([this] { m_manager.requestUpdate(); });
         }
         JDManagerFileSystem::~JDManagerFileSystem()
         {
@@ -54,6 +57,7 @@ namespace JsonDatabase
                     delete m_logger;
                 m_logger = new Log::LogObject(*parentLogger,"Filesystem manager");
                 m_userRegistration.setParentLogger(m_logger, "User registration");
+                m_leaseManager.setParentLogger(m_logger);
             }
         }
 
@@ -130,6 +134,14 @@ namespace JsonDatabase
         {
             return  getDatabasePath() + "\\" + m_databaseChangeHistoryFileName + Internal::JDManagerFileSystem::getJsonFileEnding();
         }
+        const std::string& JDManagerFileSystem::getDatabaseChangeJournalFileName() const
+        {
+            return m_databaseChangeJournalFileName;
+        }
+        std::string JDManagerFileSystem::getDatabaseChangeJournalFilePath() const
+        {
+            return  getDatabasePath() + "\\" + m_databaseChangeJournalFileName + Internal::JDManagerFileSystem::getJsonFileEnding();
+        }
         bool JDManagerFileSystem::isLoggedOnDatabase() const
         {
             return m_userRegistration.isUserRegistered();
@@ -145,17 +157,28 @@ namespace JsonDatabase
         {
             Utilities::JDUser &user = m_manager.m_user;
             std::string sessionID;
-            m_userRegistration.registerUser(user, sessionID);
+            if (m_userRegistration.registerUser(user, sessionID))
+                m_leaseManager.start(getLeaseDirectoryPath(), sessionID);
             user.setSessionID(sessionID);            
         }
         void JDManagerFileSystem::logOffDatabase()
         {
+            m_leaseManager.stop();
             m_userRegistration.unregisterUser();
         }
 
 
 
 
+        void JDManagerFileSystem::setLeaseRenewalPaused(bool paused)
+        {
+            m_leaseManager.setRenewalPaused(paused);
+        }
+        bool JDManagerFileSystem::isLeaseRenewalPaused() const
+        {
+            return m_leaseManager.isRenewalPaused();
+        }
+
         bool JDManagerFileSystem::makeDatabaseDirs() const
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
@@ -237,6 +260,10 @@ namespace JsonDatabase
         {
             return m_userRegistration.unregisterInactiveUsers();
         }
+        std::string JDManagerFileSystem::getLeaseDirectoryPath() const
+        {
+            return getDatabasePath() + "\\leases";
+        }
 
         ManagedFileChangeWatcher& JDManagerFileSystem::getDatabaseFileWatcher()
         {
@@ -249,27 +276,72 @@ namespace JsonDatabase
         
         void JDManagerFileSystem::update()
         {
-            if(m_slowUpdateCounter >= 100)
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            // The lease manager finds dead sessions in the background,
+            // only their registrations and locks have to be removed here
+            std::vector<std::string> expiredSessions = m_leaseManager.takeExpiredSessions();
+            if (expiredSessions.size() > 0)
 			{
-				m_slowUpdateCounter = 0;
-				tryToClearUnusedFileLocks();
+                m_userRegistration.unregisterSessions(expiredSessions);
+                m_manager.removeObjectLocksOfSessions(expiredSessions);
 			}
-            if (m_middleUpdateCounter >= 10)
+            if (m_leaseManager.takeLeaseLost())
+                restoreSession();
+            if (m_userCheckTask.isDue(now))
             {
-				m_middleUpdateCounter = 0;
                 std::vector<Utilities::JDUser> loggedOnUsers;
                 std::vector<Utilities::JDUser> loggedOffUsers;
                 m_userRegistration.checkForUserChange(loggedOnUsers, loggedOffUsers);
+                m_userCheckTask.reschedule(now, loggedOnUsers.size() > 0 || loggedOffUsers.size() > 0);
             }
 
-            ++m_slowUpdateCounter;
-            ++m_middleUpdateCounter;
-
             if (m_fileWatcher.hasFileChanged())
             {
                 m_manager.m_signalsToEmit.setDatabaseFileChanged();
                 m_fileWatcher.clearHasFileChanged();
             }
         }
+
+        void JDManagerFileSystem::restoreSession()
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
+            std::vector<JDObject> lostObjects;
+            {
+                JDM_UNIQUE_LOCK_P;
+                std::string oldSessionID = m_manager.getUser().getSessionID();
+                if (m_logger)m_logger->logWarning("The lease of session: " + oldSessionID + " expired, logging on again");
+                logOffDatabase();
+                logOnDatabase();
+                if (!m_manager.restoreObjectLocks(oldSessionID, lostObjects))
+                {
+                    if (m_logger)m_logger->logError("Can't restore all locks of session: " + oldSessionID);
+                }
+            }
+            // Saves of the lost objects get refused, they are not locked by this session anymore
+            if (lostObjects.size() > 0)
+                m_manager.m_signalsToEmit.addObjectLockLost(lostObjects);
+            m_manager.m_signalsToEmit.setLockedObjectsChanged();
+        }
+
+        JDManagerFileSystem::MaintenanceTask::MaintenanceTask(unsigned int minIntervalMs, unsigned int maxIntervalMs)
+            : minIntervalMs(minIntervalMs)
+            , maxIntervalMs(maxIntervalMs)
+            , currentIntervalMs(minIntervalMs)
+            , nextRun() // Epoch, to trigger the first update
+        {
+
+        }
+        bool JDManagerFileSystem::MaintenanceTask::isDue(const std::chrono::steady_clock::time_point& now) const
+        {
+            return now >= nextRun;
+        }
+        void JDManagerFileSystem::MaintenanceTask::reschedule(const std::chrono::steady_clock::time_point& now, bool hadActivity)
+        {
+            if (hadActivity)
+                currentIntervalMs = minIntervalMs;
+            else
+                currentIntervalMs = std::min(currentIntervalMs * 2, maxIntervalMs);
+            nextRun = now + std::chrono::milliseconds(currentIntervalMs);
+        }
     }
 }
\ No newline at end of file
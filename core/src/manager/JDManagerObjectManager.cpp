@@ -1,17 +1,27 @@
 #include "manager/JDManagerObjectManager.h"
 #include "manager/JDManager.h"
+#include "manager/JDIDRangeAllocator.h"
 #include "object/JDObjectInterface.h"
 #include "manager/async/WorkProgress.h"
 #include "utilities/JsonUtilities.h"
+#include <thread>
+#include <unordered_set>
 
 namespace JsonDatabase
 {
     namespace Internal
     {
+        const size_t JDManagerObjectManager::s_minIDReserveBlockSize = 256;
+        const size_t JDManagerObjectManager::s_maxIDReserveBlockSize = 65536;
+
         JDManagerObjectManager::JDManagerObjectManager(JDManager& manager, std::mutex& mtx)
             : m_manager(manager)
             , m_mutex(mtx)
             , m_objLocker(manager)
+            , m_idReserveBlockSize(s_minIDReserveBlockSize)
+            , m_changeHistoryMode(ChangeHistoryMode::full)
+            , m_changeHistoryRingBufferSize(16)
+            , m_loadThreadCount(0)
         {   }
         JDManagerObjectManager::~JDManagerObjectManager()
         {
@@ -56,7 +66,10 @@ namespace JsonDatabase
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
 			bool success = false;
 			{
-				JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+                // Held until the ID is taken, no other add can use the reserved IDs in between
+                JDM_UNIQUE_LOCK_P_M(m_idReserveMutex);
+                reserveIDs_internal(1);
+				JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
 				success = packAndAddObject_internal(obj);
 			}
             if (success)
@@ -78,17 +91,11 @@ namespace JsonDatabase
             addedObjs.reserve(objList.size());
             bool success = true;
             {
-                JDM_UNIQUE_LOCK_P_M(m_objsMutex);
-                for (size_t i = 0; i < objList.size(); ++i)
-                {
-                    const JDObject &obj = objList[i];
-                    bool added = packAndAddObject_internal(obj);
-					success &= added;
-					if (added)
-					{
-						addedObjs.push_back(obj);
-					}
-                }
+                // Held until the IDs are taken, no other add can use the reserved IDs in between
+                JDM_UNIQUE_LOCK_P_M(m_idReserveMutex);
+                reserveIDs_internal(objList.size());
+                JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
+                success = packAndAddObject_internal(objList, addedObjs);
             }
 
             if (addedObjs.size() > 0)
@@ -104,7 +111,8 @@ namespace JsonDatabase
         bool JDManagerObjectManager::removeObject(JDObject obj)
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-			JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+			JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+			JDM_SHARED_LOCK_P_M(m_objsMutex);
             return removeObject_internal(obj);
         }
         
@@ -112,7 +120,8 @@ namespace JsonDatabase
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
             bool success = true;
-			JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+			JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+			JDM_SHARED_LOCK_P_M(m_objsMutex);
 			for (size_t i = 0; i < objList.size(); ++i)
 			{
                 success &= removeObject_internal(objList[i]);
@@ -121,49 +130,72 @@ namespace JsonDatabase
         }
         std::size_t JDManagerObjectManager::getObjectCount() const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return m_objs.size();
         }
         bool JDManagerObjectManager::exists(JDObject obj) const
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return exists_internal(obj);
         }
         bool JDManagerObjectManager::exists(const std::vector<JDObject>& objs) const
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return exists_internal(objs);
         }
         bool JDManagerObjectManager::exists(const JDObjectIDptr &id) const
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return exists_internal(id);
         }
         JDObject JDManagerObjectManager::getObject(const JDObjectIDptr &id)
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return getObject_internal(id);
         }
         JDObject JDManagerObjectManager::getObject(const JDObjectID::IDType& id)
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return getObject_internal(id);
         }
         std::vector<JDObject> JDManagerObjectManager::getObjects() const
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
-            return getObjects_internal();
+            return getObjectsSnapshot()->objects;
+        }
+        std::vector<JDObject> JDManagerObjectManager::getObjectsOfClass(const std::string& className) const
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            std::vector<JDObject> objs;
+            const JDObjectContainer::TypeBucket* bucket = m_objs.getClassBucket(className);
+            if (!bucket)
+                return objs;
+            objs.reserve(bucket->objects.size());
+            for (JDObjectManager* manager : bucket->objects)
+                objs.push_back(manager->getObject());
+            return objs;
+        }
+        JDManagerObjectManager::ObjectSnapshotPtr JDManagerObjectManager::getObjectsSnapshot() const
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
+            ObjectSnapshotPtr snapshot = m_snapshot.load();
+            if (snapshot && snapshot->version == m_objs.getVersion())
+                return snapshot;
+
+            // The container has changed since the snapshot was published
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return getObjectsSnapshot_internal();
         }
 
         void JDManagerObjectManager::clearObjects()
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
             clearObjects_internal();
         }
 
@@ -171,16 +203,18 @@ namespace JsonDatabase
 
         bool JDManagerObjectManager::lockObject(const JDObject& obj, Error& err)
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			bool ret = m_objLocker.lockObject(obj, err);
             if (ret)
                 m_manager.m_signalsToEmit.addObjectLocked(obj);
             return ret;
         }
-        bool JDManagerObjectManager::lockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors)
+        bool JDManagerObjectManager::lockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors, bool allOrNothing)
         {
-			JDM_UNIQUE_LOCK_P_M(m_objsMutex);
-			bool ret = m_objLocker.lockObjects(objs, errors);
+			JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+			JDM_SHARED_LOCK_P_M(m_objsMutex);
+			bool ret = m_objLocker.lockObjects(objs, errors, allOrNothing);
             for (size_t i = 0; i < errors.size(); ++i)
             {
                 if (errors[i] == Error::none)
@@ -188,9 +222,26 @@ namespace JsonDatabase
             }
 			return ret;
         }
+        bool JDManagerObjectManager::lockObjects(const std::vector<JDObjectID::IDType>& ids, std::vector<Error>& errors, bool allOrNothing)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            std::vector<JDObject> objs;
+            objs.reserve(ids.size());
+            for (const auto& id : ids)
+                objs.push_back(getObject_internal(id));
+            bool ret = m_objLocker.lockObjects(objs, errors, allOrNothing);
+            for (size_t i = 0; i < errors.size(); ++i)
+            {
+                if (errors[i] == Error::none)
+                    m_manager.m_signalsToEmit.addObjectLocked(objs[i]);
+            }
+            return ret;
+        }
         bool JDManagerObjectManager::unlockObject(const JDObject& obj, Error& err)
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			bool ret = m_objLocker.unlockObject(obj, err);
             if(ret)
 				m_manager.m_signalsToEmit.addObjectUnlocked(obj);
@@ -198,7 +249,8 @@ namespace JsonDatabase
         }
         bool JDManagerObjectManager::unlockObject(const JDObjectID::IDType& id, Error& err)
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             JDObject obj = m_manager.getObject_internal(id);
             bool ret = m_objLocker.unlockObject(obj, err);
             if (ret)
@@ -207,7 +259,24 @@ namespace JsonDatabase
 		}
         bool JDManagerObjectManager::unlockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors)
         {
-			JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+			JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+			JDM_SHARED_LOCK_P_M(m_objsMutex);
+            bool ret = m_objLocker.unlockObjects(objs, errors);
+            for (size_t i = 0; i < errors.size(); ++i)
+            {
+                if (errors[i] == Error::none)
+                    m_manager.m_signalsToEmit.addObjectUnlocked(objs[i]);
+            }
+            return ret;
+        }
+        bool JDManagerObjectManager::unlockObjects(const std::vector<JDObjectID::IDType>& ids, std::vector<Error>& errors)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            std::vector<JDObject> objs;
+            objs.reserve(ids.size());
+            for (const auto& id : ids)
+                objs.push_back(getObject_internal(id));
             bool ret = m_objLocker.unlockObjects(objs, errors);
             for (size_t i = 0; i < errors.size(); ++i)
             {
@@ -220,7 +289,7 @@ namespace JsonDatabase
         {
             std::vector<Error> errs;
             err = Error::none;
-			bool ret = lockObjects(getObjects_internal(), errs);
+			bool ret = lockObjects(getObjects(), errs);
             if (!ret)
                 err = Error::unableToLockObject;
             return ret;
@@ -229,29 +298,63 @@ namespace JsonDatabase
         {
             std::vector<Error> errs;
             err = Error::none;
-			bool ret = unlockObjects(getObjects_internal(), errs);
+			bool ret = unlockObjects(getObjects(), errs);
             if(!ret)
 				err = Error::unableToUnlockObject;
             return ret;
         }
+        bool JDManagerObjectManager::lockClass(const std::string& className, Error& err)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return m_objLocker.lockClass(className, err);
+        }
+        bool JDManagerObjectManager::unlockClass(const std::string& className, Error& err)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return m_objLocker.unlockClass(className, err);
+        }
+        bool JDManagerObjectManager::lockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return m_objLocker.lockIDRange(first, last, err);
+        }
+        bool JDManagerObjectManager::unlockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return m_objLocker.unlockIDRange(first, last, err);
+        }
+        bool JDManagerObjectManager::getIntentionLocks(std::vector<JDObjectLocker::LockData>& locksOut, Error& err) const
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return m_objLocker.getIntentionLocks(locksOut, err);
+        }
         bool JDManagerObjectManager::isObjectLocked(const JDObject& obj, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return m_objLocker.isObjectLocked(obj, err);
         }
         bool JDManagerObjectManager::isObjectLockedByMe(const JDObject& obj, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return m_objLocker.isObjectLockedByMe(obj, err);
         }
         bool JDManagerObjectManager::isObjectLockedByOther(const JDObject& obj, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return m_objLocker.isObjectLockedByOther(obj, err);
         }
         bool JDManagerObjectManager::getObjectLocks(std::vector<JDObjectLocker::LockData>& lockedObjectsOut, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return m_objLocker.getLockedObjects(lockedObjectsOut, err);
         }
         bool JDManagerObjectManager::getObjectLocksByUser(
@@ -259,40 +362,84 @@ namespace JsonDatabase
             std::vector<JDObjectLocker::LockData>& lockedObjectsOut, 
             Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			return getObjectLocksByUser_internal(user, lockedObjectsOut, err);
         }
    
         bool JDManagerObjectManager::getLockedObjects(std::vector<LockedObject>& lockedObjectsOut, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			return getLockedObjects_internal(lockedObjectsOut, err);
         }
         bool JDManagerObjectManager::getLockedObjects(std::vector<JDObject>& lockedObjectsOut, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return getLockedObjects_internal(lockedObjectsOut, err);
         }
         bool JDManagerObjectManager::getLockedObjects(const Utilities::JDUser& user, std::vector<JDObject>& lockedObjectsOut, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			return getLockedObjects_internal(user, lockedObjectsOut, err);
         }
         bool JDManagerObjectManager::getLockOwner(const JDObject& obj, Utilities::JDUser& userOut, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			return getLockOwner_internal(obj, userOut, err);
         }
         bool JDManagerObjectManager::getLockData(const JDObject& obj, JDObjectLocker::LockData& lockDataOut, Error& err) const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
 			return getLockData_internal(obj, lockDataOut, err);
         }
         int JDManagerObjectManager::removeInactiveObjectLocks() const
         {
-            JDM_UNIQUE_LOCK_P_M(m_objsMutex);
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
             return m_objLocker.removeInactiveObjectLocks();
         }
+        int JDManagerObjectManager::removeObjectLocksOfSessions(const std::vector<std::string>& sessionIDs)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            return m_objLocker.removeLocksOfSessions(sessionIDs);
+        }
+        bool JDManagerObjectManager::restoreObjectLocks(const std::string& oldSessionID, std::vector<JDObject>& lostObjectsOut)
+        {
+            JDM_UNIQUE_LOCK_P_M(m_lockerMutex);
+            JDM_SHARED_LOCK_P_M(m_objsMutex);
+            Error err;
+            return m_objLocker.restoreOwnLocks(oldSessionID, lostObjectsOut, err);
+        }
+
+        void JDManagerObjectManager::setChangeHistoryMode(ChangeHistoryMode mode, size_t ringBufferSize)
+        {
+            if (ringBufferSize == 0)
+                ringBufferSize = 1;
+            m_changeHistoryRingBufferSize.store(ringBufferSize);
+            m_changeHistoryMode.store(mode);
+        }
+        ChangeHistoryMode JDManagerObjectManager::getChangeHistoryMode() const
+        {
+            return m_changeHistoryMode.load();
+        }
+        size_t JDManagerObjectManager::getChangeHistoryRingBufferSize() const
+        {
+            return m_changeHistoryRingBufferSize.load();
+        }
+        void JDManagerObjectManager::setLoadThreadCount(unsigned int count)
+        {
+            m_loadThreadCount.store(count);
+        }
+        unsigned int JDManagerObjectManager::getLoadThreadCount() const
+        {
+            return m_loadThreadCount.load();
+        }
 
         /*
           -----------------------------------------------------------------------------------------------
@@ -303,6 +450,93 @@ namespace JsonDatabase
         {
             JD_UNUSED(oldPath);
             m_objLocker.setDatabasePath(newPath+ "\\"+m_manager.getDatabaseName());
+            // The reserved IDs belong to the allocator of the old database
+            JDM_UNIQUE_LOCK_P_M(m_idReserveMutex);
+            m_idDomain.clearReservedRanges();
+            m_idReserveBlockSize = s_minIDReserveBlockSize;
+        }
+
+        bool JDManagerObjectManager::usesIDAllocator() const
+        {
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+            return m_manager.isLoggedOnDatabase();
+#else
+            return false;
+#endif
+        }
+        bool JDManagerObjectManager::reserveIDs_internal(size_t count)
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
+            if (count == 0 || !usesIDAllocator())
+                return false;
+            size_t available = m_idDomain.getReservedIDCount();
+            if (available >= count)
+                return true;
+
+            // The block must not overlap with the IDs this session already knows,
+            // for databases which were created without the allocator
+            JDObjectID::IDType minFirst;
+            {
+                JDM_SHARED_LOCK_P_M(m_objsMutex);
+                minFirst = getIDReserveMinFirst_internal();
+            }
+            return reserveIDBlock_internal(count - available, minFirst);
+        }
+        JDObjectID::IDType JDManagerObjectManager::getIDReserveMinFirst_internal() const
+        {
+            JDObjectID::IDType minFirst = JDObjectID::defaultID;
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+            JDObjectID::IDType highest;
+            if (m_idDomain.getHighestUsedID(highest) && highest >= minFirst)
+                minFirst = highest + 1;
+#endif
+            return minFirst;
+        }
+        bool JDManagerObjectManager::reserveIDBlock_internal(size_t count, const JDObjectID::IDType& minFirst)
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+            size_t blockSize = m_idReserveBlockSize;
+            if (blockSize < count)
+                blockSize = count;
+            m_idReserveBlockSize *= 2;
+            if (m_idReserveBlockSize > s_maxIDReserveBlockSize)
+                m_idReserveBlockSize = s_maxIDReserveBlockSize;
+
+            JDObjectID::IDType first;
+            JDObjectID::IDType last;
+            JDIDRangeAllocator allocator(m_manager.getDatabasePath(), m_logger);
+            if (!allocator.reserve(blockSize, minFirst, 1000, first, last))
+            {
+                if (m_logger)m_logger->logWarning("Can't reserve " + std::to_string(blockSize) + " object IDs");
+                return false;
+            }
+            m_idDomain.addReservedRange(first, last);
+            return true;
+#else
+            // IDs which are not numbers can't be reserved as a range
+            JD_UNUSED(count);
+            JD_UNUSED(minFirst);
+            return false;
+#endif
+        }
+        bool JDManagerObjectManager::getNewIDs_internal(size_t count, std::vector<JDObjectIDptr>& idsOut)
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
+            if (!usesIDAllocator())
+            {
+                idsOut = m_idDomain.getNewIDs(count);
+                return true;
+            }
+            // An ID of the local counter may be taken by another session.
+            // If the reserved IDs are used up, for example by loaded objects, the reservation gets retried once.
+            if (m_idDomain.getReservedIDs(count, idsOut))
+                return true;
+            if (reserveIDBlock_internal(count, getIDReserveMinFirst_internal()) &&
+                m_idDomain.getReservedIDs(count, idsOut))
+                return true;
+            if (m_logger)m_logger->logError("Can't add " + std::to_string(count) + " objects, no object IDs could be reserved");
+            return false;
         }
 
         bool JDManagerObjectManager::objectIDIsValid(const JDObjectIDptr& id) const
@@ -341,7 +575,10 @@ namespace JsonDatabase
             if (obj->isManaged())
                 return false; // Object already managed
 			
-            JDObjectIDptr id = m_idDomain.getNewID();
+            std::vector<JDObjectIDptr> newIDs;
+            if (!getNewIDs_internal(1, newIDs))
+                return false;
+            JDObjectIDptr id = newIDs[0];
            /* for (size_t i = 0; i< m_removedObjectIDs.size(); ++i)
             {
                 if (m_removedObjectIDs[i] == id->get())
@@ -360,7 +597,9 @@ namespace JsonDatabase
 				return true;
 			}
             if(m_logger)
-                m_logger->logWarning("Failed to add object with ID: " + obj->getObjectID().get()->toString());
+                m_logger->logWarning("Failed to add object with ID: " + id->toString());
+            m_idDomain.unregisterID(id);
+            delete manager;
             return false;
 			//return addObject_internal(manager);
         }
@@ -376,7 +615,7 @@ namespace JsonDatabase
             if(!success)
             {
 #ifdef JD_DEBUG
-                if (m_idDomain.getExistingID(presetID))
+                if (m_idDomain.idExists(presetID))
                 {
                     if(m_logger)m_logger->logError("Failed to add object with preset ID: " + std::to_string(presetID) + " ID already exists");
                 }
@@ -401,16 +640,67 @@ namespace JsonDatabase
                 m_manager.m_signalsToEmit.addObjectAdded(obj);
             return success;
         }
-        bool JDManagerObjectManager::packAndAddObject_internal(const std::vector<JDObject>& objs)
+        bool JDManagerObjectManager::packAndAddObject_internal(const std::vector<JDObject>& objs, std::vector<JDObject>& addedObjsOut)
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
-            m_objs.reserve(m_objs.size() + objs.size());
             bool success = true;
-            for (size_t i = 0; i < objs.size(); ++i)
+
+            // Sort out the objects which can't be added before IDs get generated for them
+            std::vector<JDObject> toAdd;
+            std::unordered_set<JDObjectInterface*> unique;
+            toAdd.reserve(objs.size());
+            unique.reserve(objs.size());
+            for (const JDObject& obj : objs)
             {
-                success &= packAndAddObject_internal(objs[i]);
+                if (!obj.get() || obj->isManaged() || m_objs.exists(obj) || !unique.insert(obj.get()).second)
+                {
+                    success = false; // Null, already managed or passed multiple times
+                    continue;
+                }
+                toAdd.push_back(obj);
             }
-			return success;
+            if (toAdd.size() == 0)
+                return success;
+
+            std::vector<JDObjectIDptr> ids;
+            if (!getNewIDs_internal(toAdd.size(), ids))
+                return false;
+            std::vector<JDObjectManager*> managers;
+            managers.reserve(toAdd.size());
+            for (size_t i = 0; i < toAdd.size(); ++i)
+                managers.push_back(new JDObjectManager(&m_manager, toAdd[i], ids[i], m_logger));
+
+            size_t addedBegin = addedObjsOut.size();
+            if (m_objs.addObject(managers))
+            {
+                addedObjsOut.insert(addedObjsOut.end(), toAdd.begin(), toAdd.end());
+            }
+            else
+            {
+                success = false;
+                for (size_t i = 0; i < managers.size(); ++i)
+                {
+                    if (m_objs.exists(managers[i]))
+                    {
+                        addedObjsOut.push_back(toAdd[i]);
+                        continue;
+                    }
+                    if (m_logger)
+                        m_logger->logWarning("Failed to add object with ID: " + ids[i]->toString());
+                    // The object stays unmanaged, its ID can be used again
+                    m_idDomain.unregisterID(ids[i]);
+                    delete managers[i];
+                }
+            }
+
+            size_t addedCount = addedObjsOut.size() - addedBegin;
+            if (addedCount > 0)
+            {
+                m_manager.m_signalsToEmit.addObjectAdded(std::vector<JDObject>(addedObjsOut.begin() + addedBegin, addedObjsOut.end()));
+                if (m_logger)
+                    m_logger->logInfo("Added " + std::to_string(addedCount) + " objects");
+            }
+            return success;
         }
         bool JDManagerObjectManager::packAndAddObject_internal(const std::vector<JDObjectID::IDType>& ids, const std::vector<JDObject>& objs)
         {
@@ -638,12 +928,24 @@ namespace JsonDatabase
         std::vector<JDObject> JDManagerObjectManager::getObjects_internal() const
         {
             JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
-            auto managers = m_objs.getAllObjects();
-            std::vector<JDObject> objs(managers.size());
-            for(size_t i=0; i< managers.size(); ++i)
-                objs[i] = managers[i]->getObject();
-            
-            return objs;
+            return getObjectsSnapshot_internal()->objects;
+        }
+        JDManagerObjectManager::ObjectSnapshotPtr JDManagerObjectManager::getObjectsSnapshot_internal() const
+        {
+            JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
+            unsigned long long version = m_objs.getVersion();
+            ObjectSnapshotPtr snapshot = m_snapshot.load();
+            if (snapshot && snapshot->version == version)
+                return snapshot; // Already published by another reader
+
+            std::shared_ptr<ObjectSnapshot> newSnapshot = std::make_shared<ObjectSnapshot>();
+            newSnapshot->version = version;
+            const std::vector<JDObjectManager*>& managers = m_objs.getAllObjects();
+            newSnapshot->objects.reserve(managers.size());
+            for (JDObjectManager* manager : managers)
+                newSnapshot->objects.push_back(manager->getObject());
+            m_snapshot.store(newSnapshot);
+            return newSnapshot;
         }
         JDObjectManager* JDManagerObjectManager::getObjectManager_internal(const JDObjectIDptr& id)
         {
@@ -792,8 +1094,12 @@ namespace JsonDatabase
             if (!obj->loadInternal(json))
             {
                 if (m_logger)m_logger->logError("Can't load data in object: " + obj->getObjectID().get()->toString() + " classType: " + obj->className());
+                if (obj->getManager())
+                    obj->getManager()->clearContentHash();
                 return false;
             }
+            if (obj->getManager())
+                obj->getManager()->setContentHash(JDObjectManager::getContentHash(json));
             return true;
         }
 
@@ -821,22 +1127,24 @@ namespace JsonDatabase
            // bool overrideChanges = (mode & (int)LoadMode::overrideChanges);
 
             std::vector<JDObject> replaceObjs;
+            std::vector<unsigned long long> newObjHashes;
             std::unordered_map<JDObject, JDObject> loadedObjects;
 
-            // Prepare the data for the loader
-            JDObjectManager::ManagedLoadContainers loaderContainers {
-                .overridingObjs = overridingObjs,
-                .newObjIDs = newObjIDs,
-                .newObjInstances = newObjInstances,
-                .changedPairs = changedPairs,
-                .replaceObjs = replaceObjs,
-                .loadedObjects = loadedObjects 
-            };
+            // The loader threads check the locks of objects with unsaved changes.
+            // They use one snapshot instead of the lock cache of the locker, which has a single mutex.
+            Internal::JDObjectLocker::OwnLocks ownLocks;
+            Error lockerError;
+            if (!m_objLocker.getOwnLocks(ownLocks, lockerError))
+            {
+                if (m_logger)m_logger->logError("Can't read the locks of this session. Error: " + std::string(errorToString(lockerError)));
+            }
+
             JDObjectManager::ManagedLoadMode loadMode {
 				.newObjects = modeNewObjects,
                 .removedObjects = modeRemovedObjects,
 				.changedObjects = modeChangedObjects,
 			//	.overridingObjects = overrideChanges
+                .ownLocks = &ownLocks
 			};
 
             if (progress)
@@ -847,39 +1155,48 @@ namespace JsonDatabase
             
             JD_GENERAL_PROFILING_BLOCK("Load objects", JD_COLOR_STAGE_3);
             size_t jsonCount = jsons.size();
-            overridingObjs.reserve(jsonCount);
-            newObjIDs.reserve(jsonCount);
-            newObjInstances.reserve(jsonCount);
-            changedPairs.reserve(jsonCount);
-            replaceObjs.reserve(jsonCount);
-            //replaceObjs.reserve(jsonCount);
-            loadedObjects.reserve(jsonCount);
 
-            double factor = 1 / (double)jsonCount;
-            for (size_t i = 0; i < jsons.size(); ++i)
+            // The IDs are read before the parallel phase.
+            // An ID that is contained more than once would be loaded into the same object by multiple ranges,
+            // only the data of its last entry gets loaded, at the position of its first entry.
+            struct LoadEntry
             {
-                JDObjectManager::ManagedLoadMisc loaderMisc;
-                bool loaded = false;
-              
-                if(!jsons[i].holds<JsonObject>())
-				{
-                    if (m_logger)m_logger->logError("Json data is not an object: \"" + jsons[i].toString() + "\"");
-					success = false;
-					continue;
-				}
-                const JsonObject& json = jsons[i].get<JsonObject>();
-                
-                if (json.contains(JDObjectInterface::s_tag_objID))
+                size_t index;
+                JDObjectID::IDType id;
+            };
+            std::vector<LoadEntry> loadEntries;
+            loadEntries.reserve(jsonCount);
+            {
+                std::unordered_map<JDObjectID::IDType, size_t> entryOfID;
+                entryOfID.reserve(jsonCount);
+                for (size_t i = 0; i < jsonCount; ++i)
                 {
+                    if (!jsons[i].holds<JsonObject>())
+                    {
+                        if (m_logger)m_logger->logError("Json data is not an object: \"" + jsons[i].toString() + "\"");
+                        success = false;
+                        continue;
+                    }
+                    const JsonObject& json = jsons[i].get<JsonObject>();
+                    if (!json.contains(JDObjectInterface::s_tag_objID))
+                    {
+                        if (m_logger)m_logger->logError("Objet has incomplete data. Key: \""
+                            + JDObjectInterface::s_tag_objID + "\" is missed\n"
+                            + "Object: \"" + JsonValue(json).toString() + "\"");
+                        success = false;
+                        continue;
+                    }
+
+                    JDObjectID::IDType id = JDObjectID::invalidID;
                     const JsonValue& idValue = json.at(JDObjectInterface::s_tag_objID);
-                    if(idValue.holds<JDObjectID::IDType>())
-						loaderMisc.id = idValue.get<JDObjectID::IDType>();
+                    if (idValue.holds<JDObjectID::IDType>())
+                        id = idValue.get<JDObjectID::IDType>();
                     else
                     {
 #if JD_ID_TYPE_SWITCH == JD_ID_TYPE_STRING
                         if (idValue.holds<long>())
                         {
-                            loaderMisc.id = std::to_string(idValue.get<long>());
+                            id = std::to_string(idValue.get<long>());
                         }
                         else
                         {
@@ -892,23 +1209,17 @@ namespace JsonDatabase
                         {
                             const std::string &idStr = idValue.get<std::string>();
                             long idValueLong = std::stol(idStr);
-                            if(idValueLong < 0)
-							{
-                                if(m_logger)m_logger->logError("Invalid ID type in object: \"" + JsonValue(json).toString() + "\"");
-								success = false;
-								continue;
-							}
-                            if(std::to_string(idValueLong) != idStr)
+                            if (idValueLong < 0 || std::to_string(idValueLong) != idStr)
                             {
                                 if (m_logger)m_logger->logError("Invalid ID type in object: \"" + JsonValue(json).toString() + "\"");
-								success = false;
-								continue;
-							}
-                            loaderMisc.id = idValueLong;
+                                success = false;
+                                continue;
+                            }
+                            id = idValueLong;
                         }
                         else
                         {
-                            if(m_logger)m_logger->logError("Invalid ID type in object: \"" + JsonValue(json).toString() + "\"");
+                            if (m_logger)m_logger->logError("Invalid ID type in object: \"" + JsonValue(json).toString() + "\"");
                             success = false;
                             continue;
                         }
@@ -917,41 +1228,195 @@ namespace JsonDatabase
                         success = false;
                         continue;
 #endif
-					}
-                    loaded = true;
+                    }
+
+                    const auto& it = entryOfID.find(id);
+                    if (it != entryOfID.end())
+                    {
+                        if (m_logger)m_logger->logWarning("Object with ID: " + JDObjectID::idToStr(id) + " is contained multiple times, only the last one gets loaded");
+                        loadEntries[it->second].index = i;
+                        continue;
+                    }
+                    entryOfID[id] = loadEntries.size();
+                    loadEntries.push_back({ i, id });
                 }
-				
-                if (!loaded)
+            }
+            size_t loadCount = loadEntries.size();
+
+            // Parallel phase: each range instantiates and loads its objects into its own stage.
+            // Serial phase: the stages get appended in the order of the ranges,
+            // so the result is the same as if the array was loaded in one go.
+            struct LoadStage
+            {
+                size_t start = 0;
+                size_t end = 0;
+                std::atomic<size_t> finishCount = 0;
+                bool success = true;
+                std::vector<std::string> errors;
+                std::vector<JDObject> overridingObjs;
+                std::vector<JDObjectID::IDType> newObjIDs;
+                std::vector<JDObject> newObjInstances;
+                std::vector<unsigned long long> newObjHashes;
+                std::vector<JDObjectPair> changedPairs;
+                std::vector<JDObject> replaceObjs;
+                std::unordered_map<JDObject, JDObject> loadedObjects;
+            };
+            auto loadRange = [this, &jsons, &loadEntries, &loadMode](LoadStage& stage)
+            {
+                // The managers that get looked up below must not be deleted while this stage uses them
+                Internal::JDSharedMutexLock lifetimeLock(m_managerLifetimeMutex, false);
+                JDObjectManager::ManagedLoadContainers loaderContainers{
+                    .overridingObjs = stage.overridingObjs,
+                    .newObjIDs = stage.newObjIDs,
+                    .newObjInstances = stage.newObjInstances,
+                    .newObjHashes = stage.newObjHashes,
+                    .changedPairs = stage.changedPairs,
+                    .replaceObjs = stage.replaceObjs,
+                    .loadedObjects = stage.loadedObjects
+                };
+                size_t count = stage.end - stage.start;
+                stage.overridingObjs.reserve(count);
+                stage.newObjIDs.reserve(count);
+                stage.newObjInstances.reserve(count);
+                stage.newObjHashes.reserve(count);
+                stage.loadedObjects.reserve(count);
+                for (size_t i = stage.start; i < stage.end; ++i, ++stage.finishCount)
                 {
-                    if(m_logger)m_logger->logError("Objet has incomplete data. Key: \"" 
-						+ JDObjectInterface::s_tag_objID + "\" is missed\n"
-						+ "Object: \"" + JsonValue(json).toString() + "\"");
-                    success = false;
-                    continue;
+                    const LoadEntry& entry = loadEntries[i];
+                    const JsonObject& json = jsons[entry.index].get<JsonObject>();
+                    JDObjectManager::ManagedLoadMisc loaderMisc;
+                    loaderMisc.id = entry.id;
+
+                    // Only the lookup is done under the lock, readers don't have to wait for the parsing.
+                    // The manager stays valid after the lookup, the load and save paths only
+                    // delete managers while they hold m_managerLifetimeMutex exclusively.
+                    JDObjectManager* manager = nullptr;
+                    {
+                        JDM_SHARED_LOCK_P_M(m_objsMutex);
+                        manager = getObjectManager_internal(loaderMisc.id);
+                    }
+
+                    JDObjectManager::ManagedLoadStatus status = JDObjectManager::managedLoad(
+                        json, manager, loaderContainers, loadMode, loaderMisc, m_logger);
+
+                    if (status != JDObjectManager::ManagedLoadStatus::success)
+                    {
+                        stage.success = false;
+                        stage.errors.push_back("Failed to load object with ID: " + JDObjectID::idToStr(loaderMisc.id) + " Error: \""
+                            + JDObjectManager::managedLoadStatusToString(status) + "\"");
+                        continue;
+                    }
                 }
+            };
 
-                JDObjectManager *manager = getObjectManager_internal(loaderMisc.id);
+            std::vector<LoadStage> stages;
+#ifdef JD_ENABLE_MULTITHREADING
+            unsigned int threadCount = m_loadThreadCount.load();
+            if (threadCount == 0)
+                threadCount = std::thread::hardware_concurrency();
+            if (threadCount > 100)
+                threadCount = 100;
+            if (threadCount > loadCount)
+                threadCount = (unsigned int)loadCount;
+            if (loadCount > 100 && threadCount > 1)
+            {
+                stages = std::vector<LoadStage>(threadCount);
+                size_t chunkSize = loadCount / threadCount;
+                size_t remainder = loadCount % threadCount;
+                size_t start = 0;
+                for (size_t i = 0; i < threadCount; ++i)
+                {
+                    stages[i].start = start;
+                    stages[i].end = start + chunkSize;
+                    start += chunkSize;
+                    if (i == threadCount - 1)
+                        stages[i].end += remainder;
+                }
 
-                JDObjectManager::ManagedLoadStatus status = JDObjectManager::managedLoad(
-                    json, manager, loaderContainers, loadMode, loaderMisc, m_logger);
+                std::vector<std::thread*> threads(threadCount, nullptr);
+                for (size_t i = 1; i < threadCount; ++i)
+                    threads[i] = new std::thread([&loadRange, &stages, i]() { loadRange(stages[i]); });
 
-                if(status != JDObjectManager::ManagedLoadStatus::success)
-				{
-					success = false;
-                    if (m_logger)m_logger->logError("Failed to load object with ID: " + std::to_string(loaderMisc.id) + " Error: \""
-                        + JDObjectManager::managedLoadStatusToString(status) + "\"");
-					continue;
-				}
-				if (progress)
-					progress->setProgress((double)i * factor);
+                // Create a progress updater Thread
+                std::thread* progressUpdater = nullptr;
+                std::atomic<bool> progressUpdaterRunning = false;
+                if (progress)
+                {
+                    progressUpdaterRunning = true;
+                    double factor = 1 / (double)loadCount;
+                    progressUpdater = new std::thread([&stages, progress, factor, &progressUpdaterRunning]()
+                        {
+                            while (progressUpdaterRunning.load())
+                            {
+                                size_t finishCount = 0;
+                                for (size_t i = 0; i < stages.size(); ++i)
+                                    finishCount += stages[i].finishCount;
+                                progress->setProgress((double)finishCount * factor);
+                                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                            }
+                        });
+                }
+
+                // The first range gets loaded by this thread
+                loadRange(stages[0]);
+                for (size_t i = 1; i < threadCount; ++i)
+                {
+                    threads[i]->join();
+                    delete threads[i];
+                }
+                if (progressUpdater)
+                {
+                    progressUpdaterRunning = false;
+                    progressUpdater->join();
+                    delete progressUpdater;
+                    progressUpdater = nullptr;
+                }
+            }
+            else
+#endif
+            {
+                stages = std::vector<LoadStage>(1);
+                stages[0].end = loadCount;
+                loadRange(stages[0]);
             }
             JD_GENERAL_PROFILING_END_BLOCK;
 
+            JD_GENERAL_PROFILING_BLOCK("Merge loaded objects", JD_COLOR_STAGE_3);
+            overridingObjs.reserve(overridingObjs.size() + jsonCount);
+            newObjIDs.reserve(newObjIDs.size() + jsonCount);
+            newObjInstances.reserve(newObjInstances.size() + jsonCount);
+            newObjHashes.reserve(jsonCount);
+            loadedObjects.reserve(jsonCount);
+            for (LoadStage& stage : stages)
+            {
+                success &= stage.success;
+                if (m_logger)
+                    for (const std::string& error : stage.errors)
+                        m_logger->logError(error);
+                overridingObjs.insert(overridingObjs.end(), stage.overridingObjs.begin(), stage.overridingObjs.end());
+                newObjIDs.insert(newObjIDs.end(), stage.newObjIDs.begin(), stage.newObjIDs.end());
+                newObjInstances.insert(newObjInstances.end(), stage.newObjInstances.begin(), stage.newObjInstances.end());
+                newObjHashes.insert(newObjHashes.end(), stage.newObjHashes.begin(), stage.newObjHashes.end());
+                changedPairs.insert(changedPairs.end(), stage.changedPairs.begin(), stage.changedPairs.end());
+                replaceObjs.insert(replaceObjs.end(), stage.replaceObjs.begin(), stage.replaceObjs.end());
+                loadedObjects.insert(stage.loadedObjects.begin(), stage.loadedObjects.end());
+            }
+            // Collected here instead of in the parallel phase, so the signal order does not depend on the threads
+            if (overridingObjs.size())
+                m_manager.m_signalsToEmit.addObjectChanged(overridingObjs);
+            if (progress)
+                progress->setProgress(1);
+            JD_GENERAL_PROFILING_END_BLOCK;
+
             JD_GENERAL_PROFILING_BLOCK("Find removed objects", JD_COLOR_STAGE_3);
             // Find new added objects
             if (modeRemovedObjects)
             {
-                std::vector<JDObjectManager*> managers = getObjectManagers_internal();
+                std::vector<JDObjectManager*> managers;
+                {
+                    JDM_SHARED_LOCK_P_M(m_objsMutex);
+                    managers = getObjectManagers_internal();
+                }
 
                 removedObjs.reserve(managers.size());
                 for (auto manager : managers)
@@ -982,9 +1447,14 @@ namespace JsonDatabase
             {
                 if (progress)
                     progress->setComment("Remove " + std::to_string(removedObjs.size()) + " objects");
-                for (size_t i = 0; i < removedObjs.size(); ++i)
                 {
-                    success &= unregisterAndRemove(removedObjs[i]);
+                    // Publish the result in one short exclusive section
+                    Internal::JDSharedMutexLock lifetimeLock(m_managerLifetimeMutex, true);
+                    JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
+                    for (size_t i = 0; i < removedObjs.size(); ++i)
+                    {
+                        success &= unregisterAndRemove(removedObjs[i]);
+                    }
                 }
 
 
@@ -1019,7 +1489,18 @@ namespace JsonDatabase
             {
                 if (progress)
                     progress->setComment("Add " + std::to_string(newObjIDs.size()) + " new objects");
-                success &= packAndAddObject_internal(newObjIDs, newObjInstances);
+                {
+                    JDM_EXCLUSIVE_LOCK_P_M(m_objsMutex);
+                    success &= packAndAddObject_internal(newObjIDs, newObjInstances);
+                    // newObjInstances may contain objects of earlier calls, the hashes belong to the last ones
+                    size_t hashOffset = newObjInstances.size() - newObjHashes.size();
+                    for (size_t i = 0; i < newObjHashes.size(); ++i)
+                    {
+                        JDObjectManager* manager = newObjInstances[hashOffset + i]->getManager();
+                        if (manager)
+                            manager->setContentHash(newObjHashes[i]);
+                    }
+                }
                 if (m_logger)
                     m_logger->logInfo("Added " + std::to_string(newObjIDs.size()) + " new objects");
                 if (progress)
@@ -1040,7 +1521,9 @@ namespace JsonDatabase
                 progress->addProgress((3 - counter) * 0.1);
             }
             JD_GENERAL_PROFILING_END_BLOCK;
-                
+
+            // Publish the loaded state, so that the next readers don't have to build the snapshot
+            getObjectsSnapshot();
             return success;
         }
 
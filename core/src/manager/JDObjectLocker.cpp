@@ -13,6 +13,8 @@
 #include "object/JDObjectInterface.h"
 
 #include <QDateTime>
+#include <unordered_set>
+#include <algorithm>
 
 namespace JsonDatabase
 {
@@ -22,6 +24,10 @@ namespace JsonDatabase
 		const std::string JDObjectLocker::JsonKeys::user = "user";
 		const std::string JDObjectLocker::JsonKeys::lockDate = "lockDate";
 		const std::string JDObjectLocker::JsonKeys::lockTime = "lockTime";
+		const std::string JDObjectLocker::JsonKeys::lockType = "lockType";
+		const std::string JDObjectLocker::JsonKeys::className = "className";
+		const std::string JDObjectLocker::JsonKeys::rangeFirst = "rangeFirst";
+		const std::string JDObjectLocker::JsonKeys::rangeLast = "rangeLast";
 
 		JDObjectLocker::JDObjectLocker(JDManager& manager)
 			: AbstractRegistry()
@@ -30,8 +36,15 @@ namespace JsonDatabase
 			, m_registryOpenTimeoutMs(1000)
 			, m_useSpecificDatabasePath(false)
 			, m_specificDatabasePath("")
+			, m_lockCacheValid(false)
+			, m_lockCacheOutdated(true)
+			, m_lockCacheGeneration(0)
 		{
 			AbstractRegistry::setName("lockedObjects");
+			m_lockTableWatcher.setChangeCallback([this] {
+				m_lockCacheOutdated.store(true);
+				m_manager.requestUpdate(); 
+				});
 		}
 
 		JDObjectLocker::~JDObjectLocker()
@@ -47,7 +60,7 @@ namespace JsonDatabase
 		{
 			std::vector<JDObject> objs = { obj };
 			std::vector<Error> errors;
-			if (!lockObjects_internal(objs, errors))
+			if (!lockObjects_internal(objs, errors, false))
 			{
 				err = errors[0];
 				return false;
@@ -56,9 +69,9 @@ namespace JsonDatabase
 			return true;
 		}
 
-		bool JDObjectLocker::lockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors)
+		bool JDObjectLocker::lockObjects(const std::vector<JDObject>& objs, std::vector<Error>& errors, bool allOrNothing)
 		{
-			return lockObjects_internal(objs, errors);
+			return lockObjects_internal(objs, errors, allOrNothing);
 		}
 
 		bool JDObjectLocker::unlockObject(const JDObject& obj, Error& err)
@@ -106,7 +119,7 @@ namespace JsonDatabase
 		{
 			std::vector<Error> errors;
 			std::vector<JDObject> objs = m_manager.getObjects_internal();
-			if (!lockObjects_internal(objs, errors))
+			if (!lockObjects_internal(objs, errors, false))
 			{
 				err = Error::unableToLockObject;
 				return false;
@@ -142,13 +155,14 @@ namespace JsonDatabase
 				err = Error::objIsNullptr;
 				return false;
 			}
-			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
-			{
-				err = Error::cantOpenRegistryFile;
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
 				return false;
-			}
-			AbstractRegistry::AutoClose autoClose(this);
-			return AbstractRegistry::isObjectActive(obj->getObjectID()->toString());
+			const JDObjectID::IDType& id = obj->getObjectID()->get();
+			if (m_lockCache.find(id) != m_lockCache.end())
+				return true;
+			return findIntentionLock_internal(id, obj->className(), false) ||
+				   findIntentionLock_internal(id, obj->className(), true);
 		}
 		bool JDObjectLocker::isObjectLockedByMe(const JDObject& obj, Error& err) const
 		{
@@ -159,17 +173,15 @@ namespace JsonDatabase
 				err = Error::objIsNullptr;
 				return false;
 			}			
-			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
-			{
-				err = Error::cantOpenRegistryFile;
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
 				return false;
-			}
-			AbstractRegistry::AutoClose autoClose(this);
 
-			if (AbstractRegistry::isSelfOwned(obj->getObjectID()->toString()))
+			const JDObjectID::IDType& id = obj->getObjectID()->get();
+			const auto& it = m_lockCache.find(id);
+			if (it != m_lockCache.end() && it->second.user.getSessionID() == m_manager.getUser().getSessionID())
 				return true;
-
-			return false;
+			return findIntentionLock_internal(id, obj->className(), false) != nullptr;
 		}
 		bool JDObjectLocker::isObjectLockedByOther(const JDObject& obj, Error& err) const
 		{
@@ -180,20 +192,71 @@ namespace JsonDatabase
 				err = Error::objIsNullptr;
 				return false;
 			}
-			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
-			{
-				err = Error::cantOpenRegistryFile;
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
 				return false;
-			}
-			AbstractRegistry::AutoClose autoClose(this);
 
-			std::string key = obj->getObjectID()->toString();
+			const JDObjectID::IDType& id = obj->getObjectID()->get();
+			const auto& it = m_lockCache.find(id);
+			if (it != m_lockCache.end() && it->second.user.getSessionID() != m_manager.getUser().getSessionID())
+				return true;
+			return findIntentionLock_internal(id, obj->className(), true) != nullptr;
+		}
+		bool JDObjectLocker::areObjectsLockedByMe(const std::vector<JDObject>& objs, std::vector<bool>& lockedByMeOut, Error& err) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			lockedByMeOut.assign(objs.size(), false);
+			err = Error::none;
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
+				return false;
 
-			if (AbstractRegistry::lockExists(key))
+			std::string sessionID = m_manager.getUser().getSessionID();
+			bool hasIntentionLocks = m_classLockCache.size() > 0 || m_rangeLockCache.size() > 0;
+			for (size_t i = 0; i < objs.size(); ++i)
 			{
-				if (!AbstractRegistry::isSelfOwned(key))
-					return true;
+				if (!objs[i].get())
+					continue;
+				const JDObjectID::IDType& id = objs[i]->getObjectID()->get();
+				const auto& it = m_lockCache.find(id);
+				if (it != m_lockCache.end() && it->second.user.getSessionID() == sessionID)
+					lockedByMeOut[i] = true;
+				else if (hasIntentionLocks)
+					lockedByMeOut[i] = findIntentionLock_internal(id, objs[i]->className(), false) != nullptr;
 			}
+			return true;
+		}
+
+		bool JDObjectLocker::getOwnLocks(OwnLocks& locksOut, Error& err) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			locksOut = OwnLocks();
+			err = Error::none;
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
+				return false;
+
+			std::string sessionID = m_manager.getUser().getSessionID();
+			for (const auto& lock : m_lockCache)
+				if (lock.second.user.getSessionID() == sessionID)
+					locksOut.objectIDs.insert(lock.first);
+			for (const auto& lock : m_classLockCache)
+				if (lock.second.user.getSessionID() == sessionID)
+					locksOut.classNames.insert(lock.first);
+			for (const auto& lock : m_rangeLockCache)
+				if (lock.user.getSessionID() == sessionID)
+					locksOut.ranges.push_back(std::make_pair(lock.rangeFirst, lock.rangeLast));
+			return true;
+		}
+		bool JDObjectLocker::OwnLocks::covers(const JDObjectID::IDType& id, const std::string& className) const
+		{
+			if (objectIDs.find(id) != objectIDs.end())
+				return true;
+			if (className.size() > 0 && classNames.find(className) != classNames.end())
+				return true;
+			for (const auto& range : ranges)
+				if (id >= range.first && id <= range.second)
+					return true;
 			return false;
 		}
 
@@ -203,70 +266,268 @@ namespace JsonDatabase
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
 			lockedObjectsOut.clear();
 
-			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
-			{
-				err = Error::cantOpenRegistryFile;
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
 				return false;
+
+			lockedObjectsOut.reserve(m_lockCache.size());
+			for (const auto& lock : m_lockCache)
+				lockedObjectsOut.push_back(lock.second);
+			return true;
+		}
+		bool JDObjectLocker::getLockData(JDObjectID::IDType objID, LockData& lockDataOut, Error& err) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
+				return false;
+
+			const auto& it = m_lockCache.find(objID);
+			if (it != m_lockCache.end())
+			{
+				lockDataOut = it->second;
+				err = Error::none;
+				return true;
 			}
-			AbstractRegistry::AutoClose autoClose(this);
 
-			std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
-			if (!AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects))
+			JDObject obj = m_manager.getObject_internal(objID);
+			std::string className = obj ? obj->className() : "";
+			const LockData* intentionLock = findIntentionLock_internal(objID, className, true);
+			if (!intentionLock)
+				intentionLock = findIntentionLock_internal(objID, className, false);
+			if (!intentionLock)
 			{
-				err = Error::corruptRegistryFileData;
+				err = Error::objectNotLocked;
 				return false;
 			}
-			bool success = true;
+			lockDataOut = *intentionLock;
+			lockDataOut.objectID = objID;
 			err = Error::none;
-			lockedObjectsOut.reserve(loadedObjects.size());
-			for(auto obj : loadedObjects)
-			{
-				if(obj->data.objectID != JDObjectID::invalidID)
-					lockedObjectsOut.push_back(obj->data);
-				else
-				{
-					if(m_logger)m_logger->logWarning("Object has empty objectID: "
-						+ obj->toString() + "\n");
-					err = Error::corruptRegistryFileData;
-					success = false;
-				}
-			}
-			return success;
+			return true;
 		}
-		bool JDObjectLocker::getLockData(JDObjectID::IDType objID, LockData& lockDataOut, Error& err) const
+		bool JDObjectLocker::getIntentionLocks(std::vector<LockData>& locksOut, Error& err) const
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
-			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
-			{
-				err = Error::cantOpenRegistryFile;
+			locksOut.clear();
+
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			if (!refreshLockCache_internal(err))
 				return false;
-			}
+
+			locksOut.reserve(m_classLockCache.size() + m_rangeLockCache.size());
+			for (const auto& lock : m_classLockCache)
+				locksOut.push_back(lock.second);
+			locksOut.insert(locksOut.end(), m_rangeLockCache.begin(), m_rangeLockCache.end());
+			return true;
+		}
+
+		bool JDObjectLocker::lockClass(const std::string& className, Error& err)
+		{
+			LockData lock;
+			lock.type = LockData::Type::objectClass;
+			lock.className = className;
+			return lockIntention_internal(lock, err);
+		}
+		bool JDObjectLocker::unlockClass(const std::string& className, Error& err)
+		{
+			return unlockIntention_internal(getClassLockKey(className), err);
+		}
+		bool JDObjectLocker::lockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err)
+		{
+			LockData lock;
+			lock.type = LockData::Type::idRange;
+			lock.rangeFirst = std::min(first, last);
+			lock.rangeLast = std::max(first, last);
+			return lockIntention_internal(lock, err);
+		}
+		bool JDObjectLocker::unlockIDRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last, Error& err)
+		{
+			return unlockIntention_internal(getRangeLockKey(std::min(first, last), std::max(first, last)), err);
+		}
+		int JDObjectLocker::removeInactiveObjectLocks() const
+		{
+			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
+				return 0;
+			AbstractRegistry::AutoClose autoClose(this);
+			int removed = AbstractRegistry::removeInactiveObjects();
+			if (removed > 0)
+				m_lockCacheOutdated.store(true);
+			return removed;
+		}
+
+		int JDObjectLocker::removeLocksOfSessions(const std::vector<std::string>& sessionIDs)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			if (sessionIDs.size() == 0)
+				return 0;
+			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
+				return 0;
 			AbstractRegistry::AutoClose autoClose(this);
 
 			std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
 			if (!AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects))
+				return 0;
+
+			std::unordered_set<std::string> sessions(sessionIDs.begin(), sessionIDs.end());
+			std::vector<std::string> keys;
+			for (const auto& obj : loadedObjects)
 			{
-				err = Error::corruptRegistryFileData;
-				return false;
+				if (sessions.find(obj->data.user.getSessionID()) != sessions.end())
+					keys.push_back(obj->getKey());
 			}
-			for (auto obj : loadedObjects)
+			int removed = AbstractRegistry::removeForeignObjects(keys);
+			if (removed > 0)
 			{
-				if (obj->data.objectID == objID)
-				{
-					lockDataOut = obj->data;
-					err = Error::none;
-					return true;
-				}
+				m_lockCacheOutdated.store(true);
+				if (m_logger)m_logger->logInfo("Removed " + std::to_string(removed) + " locks of expired sessions");
 			}
-			err = Error::objectNotLocked;
-			return false;
+			return removed;
 		}
-		int JDObjectLocker::removeInactiveObjectLocks() const
+
+		bool JDObjectLocker::restoreOwnLocks(const std::string& oldSessionID, std::vector<JDObject>& lostObjectsOut, Error& err)
 		{
-			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
-				return 0;
-			AbstractRegistry::AutoClose autoClose(this);
-			return AbstractRegistry::removeInactiveObjects();
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_10);
+			lostObjectsOut.clear();
+			err = Error::none;
+			invalidateLockCache();
+			std::vector<std::string> ownKeys = AbstractRegistry::getSelfOwnedLockNames();
+			if (ownKeys.size() == 0)
+				return true;
+
+			std::vector<JDObject> objs = m_manager.getObjects_internal();
+			std::unordered_map<std::string, JDObject> objsByKey;
+			objsByKey.reserve(objs.size());
+			for (const JDObject& obj : objs)
+				objsByKey[obj->getObjectID()->toString()] = obj;
+
+			// Without the registry no lock can be proven, all of them get released
+			bool registryOpen = AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs);
+			AbstractRegistry::AutoClose autoClose(registryOpen ? this : nullptr);
+			if (!registryOpen)
+				err = Error::cantOpenRegistryFile;
+
+			std::vector<std::shared_ptr<LockEntryObject>> restoring;
+			std::vector<std::string> removing;  // The entry of the old session still exists
+			std::vector<std::string> releasing; // The entry was already removed by another session
+			OwnLocks restoredLocks;
+			OwnLocks lostLocks;
+			auto addLock = [](OwnLocks& locks, const LockData& lock)
+				{
+					if (lock.type == LockData::Type::objectClass)
+						locks.classNames.insert(lock.className);
+					else if (lock.type == LockData::Type::idRange)
+						locks.ranges.push_back(std::make_pair(lock.rangeFirst, lock.rangeLast));
+					else
+						locks.objectIDs.insert(lock.objectID);
+				};
+			{
+				JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+				bool cacheValid = registryOpen && refreshLockCache_internal(err);
+
+				// Entries of the old session that were not removed yet get replaced by the restored ones
+				std::unordered_set<std::string> oldSessionKeys;
+				if (cacheValid)
+				{
+					for (auto it = m_lockCache.begin(); it != m_lockCache.end();)
+					{
+						if (it->second.user.getSessionID() != oldSessionID) { ++it; continue; }
+						oldSessionKeys.insert(JDObjectID::toString(it->first));
+						it = m_lockCache.erase(it);
+					}
+					for (auto it = m_classLockCache.begin(); it != m_classLockCache.end();)
+					{
+						if (it->second.user.getSessionID() != oldSessionID) { ++it; continue; }
+						oldSessionKeys.insert(getClassLockKey(it->first));
+						it = m_classLockCache.erase(it);
+					}
+					for (auto it = m_rangeLockCache.begin(); it != m_rangeLockCache.end();)
+					{
+						if (it->user.getSessionID() != oldSessionID) { ++it; continue; }
+						oldSessionKeys.insert(getRangeLockKey(it->rangeFirst, it->rangeLast));
+						it = m_rangeLockCache.erase(it);
+					}
+				}
+
+				std::string sessionID = m_manager.getUser().getSessionID();
+				for (const std::string& key : ownKeys)
+				{
+					std::shared_ptr<LockEntryObjectImpl> entry;
+					bool conflict = true;
+					const auto& intentionIt = m_ownIntentionLocks.find(key);
+					if (intentionIt != m_ownIntentionLocks.end())
+					{
+						entry = std::make_shared<LockEntryObjectImpl>(key, intentionIt->second, m_manager);
+						conflict = !cacheValid || conflictsWithOther_internal(intentionIt->second);
+					}
+					else
+					{
+						// The entry of an object that is no longer loaded can't be written again
+						const auto& objIt = objsByKey.find(key);
+						if (objIt != objsByKey.end())
+						{
+							const JDObject& obj = objIt->second;
+							const JDObjectID::IDType& id = obj->getObjectID()->get();
+							entry = std::make_shared<LockEntryObjectImpl>(key, obj, m_manager);
+							if (cacheValid)
+							{
+								const auto& lockIt = m_lockCache.find(id);
+								conflict = (lockIt != m_lockCache.end() && lockIt->second.user.getSessionID() != sessionID) ||
+									findIntentionLock_internal(id, obj->className(), true) != nullptr;
+							}
+						}
+					}
+
+					if (!conflict)
+					{
+						restoring.push_back(entry);
+						addLock(restoredLocks, entry->data);
+						continue;
+					}
+					if (entry)
+						addLock(lostLocks, entry->data);
+					if (oldSessionKeys.find(key) != oldSessionKeys.end())
+						removing.push_back(key);
+					else
+						releasing.push_back(key);
+				}
+			}
+
+			if (restoring.size() > 0 && AbstractRegistry::restoreObjects(restoring) != restoring.size())
+			{
+				for (const auto& entry : restoring)
+				{
+					releasing.push_back(entry->getKey());
+					addLock(lostLocks, std::static_pointer_cast<LockEntryObjectImpl>(entry)->data);
+				}
+				restoredLocks = OwnLocks();
+				restoring.clear();
+				err = Error::unableToLockObject;
+			}
+			if (removing.size() > 0 && AbstractRegistry::removeObjects(removing) != removing.size())
+				AbstractRegistry::releaseObjects(removing);
+			AbstractRegistry::releaseObjects(releasing);
+			m_lockCacheOutdated.store(true);
+
+			for (const std::string& key : removing)
+				m_ownIntentionLocks.erase(key);
+			for (const std::string& key : releasing)
+				m_ownIntentionLocks.erase(key);
+
+			for (const JDObject& obj : objs)
+			{
+				const JDObjectID::IDType& id = obj->getObjectID()->get();
+				if (lostLocks.covers(id, obj->className()) && !restoredLocks.covers(id, obj->className()))
+					lostObjectsOut.push_back(obj);
+			}
+			if (m_logger)
+			{
+				m_logger->logInfo("Restored " + std::to_string(restoring.size()) + " locks of the expired session: " + oldSessionID);
+				for (const std::string& key : removing)
+					m_logger->logWarning("Lock: \"" + key + "\" of the expired session is lost");
+				for (const std::string& key : releasing)
+					m_logger->logWarning("Lock: \"" + key + "\" of the expired session is lost");
+			}
+			return err == Error::none;
 		}
 
 		ManagedFileChangeWatcher& JDObjectLocker::getLockTableFileWatcher()
@@ -279,13 +540,14 @@ namespace JsonDatabase
 			if (m_lockTableWatcher.hasFileChanged())
 			{
 				m_lockTableWatcher.clearHasFileChanged();
+				m_lockCacheOutdated.store(true);
 				m_manager.onObjectLockerFileChanged();
 				//m_manager.getSignals().lockedObjectsChanged.emitSignal();
 				m_manager.m_signalsToEmit.setLockedObjectsChanged();
 			}
 		}
 
-		bool JDObjectLocker::lockObjects_internal(const std::vector<JDObject>& objs, std::vector<Error>& errors)
+		bool JDObjectLocker::lockObjects_internal(const std::vector<JDObject>& objs, std::vector<Error>& errors, bool allOrNothing)
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_10);
 			errors.resize(objs.size());
@@ -298,36 +560,30 @@ namespace JsonDatabase
 				return false;
 			}
 			AbstractRegistry::AutoClose autoClose(this);
-			AbstractRegistry::removeInactiveObjects();
-
-			std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
-			if (!AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects))
-			{
-				for (size_t i = 0; i < objs.size(); ++i)
-				{
-					errors[i] = Error::corruptRegistryFileData;
-				}
-				return false;
-			}
 
-			// Check if Lock is already aquired
-			Utilities::JDUser user = m_manager.getUser();
-			std::unordered_map<JDObjectID::IDType, bool> alreadyLocked;
-			std::unordered_map<JDObjectID::IDType, bool> lockedByOther;
-			for (size_t i = 0; i < loadedObjects.size(); ++i)
+			// The registry is open, no other session can add a class or range lock until it gets closed.
+			// Only reloads the cache if the registry has changed.
+			std::vector<bool> coveredByOther(objs.size(), false);
 			{
-				if (loadedObjects[i]->data.user.getSessionID() == user.getSessionID())
+				JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+				m_lockCacheOutdated.store(true);
+				Error cacheErr;
+				if (refreshLockCache_internal(cacheErr) && (m_classLockCache.size() > 0 || m_rangeLockCache.size() > 0))
 				{
-					alreadyLocked[loadedObjects[i]->data.objectID] = true;
-				}
-				else
-				{
-					lockedByOther[loadedObjects[i]->data.objectID] = true;
+					for (size_t i = 0; i < objs.size(); ++i)
+					{
+						if (objs[i])
+							coveredByOther[i] = findIntentionLock_internal(objs[i]->getObjectID()->get(), objs[i]->className(), true) != nullptr;
+					}
 				}
 			}
 
+			// Ownership is proven by the self owned lock, the registry does not have to be read.
+			// Entries of inactive users get overwritten by the new entry.
 			std::vector<std::shared_ptr<LockEntryObject>> newEntries;
-			std::unordered_map<JDObjectID::IDType, std::shared_ptr<LockEntryObjectImpl>> alreadyLockedObjects;
+			std::vector<size_t> newEntryIndexes;
+			newEntries.reserve(objs.size());
+			newEntryIndexes.reserve(objs.size());
 			for (size_t i = 0; i < objs.size(); ++i)
 			{
 				if (!objs[i])
@@ -337,43 +593,61 @@ namespace JsonDatabase
 				}
 				errors[i] = Error::none;
 				const JDObject& obj = objs[i];
-				JDObjectID::IDType id = obj->getObjectID()->get();
 				std::string key = obj->getObjectID()->toString();
-				if (alreadyLocked.find(id) != alreadyLocked.end())
+				if (AbstractRegistry::isSelfOwned(key))
 				{
 					errors[i] = Error::objectAlreadyLocked;
 					continue;
 				}
-				if (lockedByOther.find(id) != lockedByOther.end())
+				if (coveredByOther[i])
 				{
-					std::shared_ptr<LockEntryObjectImpl> lockEntry;
-					for (auto entry : loadedObjects)
-					{
-						if (entry->data.objectID == id)
-						{
-							lockEntry = entry;
-							alreadyLockedObjects[id] = entry;
-							break;
-						}
-					}
 					errors[i] = Error::objectLockedByOther;
 					continue;
 				}
-				auto newEntry = std::make_shared<LockEntryObjectImpl>(key, obj, m_manager);
-				newEntries.push_back(newEntry);
+				newEntries.push_back(std::make_shared<LockEntryObjectImpl>(key, obj, m_manager));
+				newEntryIndexes.push_back(i);
 			}
 
+			std::vector<bool> added(newEntries.size(), false);
 			int ret = 0;
-			if ((ret = AbstractRegistry::addObjects(newEntries)) != newEntries.size())
+			bool aborted = false;
+			if (allOrNothing && newEntries.size() != objs.size())
+				aborted = true; // Don't write anything, an object is nullptr, already locked or covered by another lock
+			else
 			{
-				for (size_t i = 0; i < errors.size(); ++i)
+				// All new entries are written with one registry write
+				ret = AbstractRegistry::addObjects(newEntries, added, allOrNothing);
+				aborted = allOrNothing && ret == 0 && newEntries.size() > 0;
+			}
+			bool lockedByOther = false;
+			for (size_t j = 0; j < newEntries.size(); ++j)
+			{
+				if (added[j])
+					continue;
+				if (AbstractRegistry::lockExists(newEntries[j]->getKey()))
 				{
-					if (errors[i] == Error::none)
-						errors[i] = Error::unableToLockObject;
+					errors[newEntryIndexes[j]] = Error::objectLockedByOther;
+					lockedByOther = true;
 				}
+				else if (aborted)
+					errors[newEntryIndexes[j]] = Error::objectLockBatchAborted;
+				else
+					errors[newEntryIndexes[j]] = Error::unableToLockObject;
 			}
+			// Set after the write, the generation must already be updated when the cache gets refreshed
+			m_lockCacheOutdated.store(true);
+
 			if (m_logger)
 			{
+				// Only read the registry to log who holds the lock
+				std::unordered_map<JDObjectID::IDType, std::shared_ptr<LockEntryObjectImpl>> alreadyLockedObjects;
+				if (lockedByOther)
+				{
+					std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
+					AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects);
+					for (const auto& entry : loadedObjects)
+						alreadyLockedObjects[entry->data.objectID] = entry;
+				}
 				for (size_t i = 0; i < objs.size(); ++i)
 				{
 					switch (errors[i])
@@ -396,6 +670,16 @@ namespace JsonDatabase
 								m_logger->logError("Can't lock object: \"" + objs[i]->getObjectID()->toString() + "\"");
 							break;
 						}
+						case Error::unableToLockObject:
+						{
+							m_logger->logError("Can't lock object: \"" + objs[i]->getObjectID()->toString() + "\"");
+							break;
+						}
+						case Error::objectLockBatchAborted:
+						{
+							m_logger->logWarning("Object: \"" + objs[i]->getObjectID()->toString() + "\" not locked, the batch was aborted");
+							break;
+						}
 						case Error::objIsNullptr:
 						{
 							m_logger->logError("Object is nullptr");
@@ -419,24 +703,10 @@ namespace JsonDatabase
 				return false;
 			}
 			AbstractRegistry::AutoClose autoClose(this);
-			std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
-			std::unordered_map<JDObjectID::IDType, std::shared_ptr<LockEntryObjectImpl>> lockedObjects;
-			if (!AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects))
-			{
-				for (size_t i = 0; i < objs.size(); ++i)
-				{
-					errors[i] = Error::corruptRegistryFileData;
-				}
-				return false;
-			}
-			for (auto obj : loadedObjects)
-			{
-				lockedObjects[obj->data.objectID] = obj;
-			}
-
 
 			std::vector<std::string> removingKeys;
 			removingKeys.reserve(objs.size());
+			bool lockedByOther = false;
 
 			for (size_t i = 0; i < objs.size(); ++i)
 			{
@@ -449,19 +719,16 @@ namespace JsonDatabase
 				const JDObject& obj = objs[i];
 				std::string key = obj->getObjectID()->toString();
 
-				auto lockEntry = lockedObjects.find(obj->getObjectID()->get());
-				if (lockEntry == lockedObjects.end())
-				{
-					errors[i] = Error::objectNotLocked;
-					continue;
-				}
-				else
+				if (!AbstractRegistry::isSelfOwned(key))
 				{
-					if (lockEntry->second->data.user.getSessionID() != m_manager.getUser().getSessionID())
+					if (AbstractRegistry::lockExists(key))
 					{
 						errors[i] = Error::objectLockedByOther;
-						continue;
+						lockedByOther = true;
 					}
+					else
+						errors[i] = Error::objectNotLocked;
+					continue;
 				}
 				removingKeys.push_back(key);
 			}
@@ -469,15 +736,25 @@ namespace JsonDatabase
 			int removed = 0;
 			if ((removed = AbstractRegistry::removeObjects(removingKeys)) != removingKeys.size())
 			{
-				for (size_t i = 0; i < removingKeys.size(); ++i)
+				for (size_t i = 0; i < errors.size(); ++i)
 				{
-					if (errors[i] == Error::none)
+					if (errors[i] == Error::none && objs[i] && AbstractRegistry::isSelfOwned(objs[i]->getObjectID()->toString()))
 						errors[i] = Error::unableToUnlockObject;
 				}
 			}
+			m_lockCacheOutdated.store(true);
 
 			if (m_logger)
 			{
+				// Only read the registry to log who holds the lock
+				std::unordered_map<JDObjectID::IDType, std::shared_ptr<LockEntryObjectImpl>> lockedObjects;
+				if (lockedByOther)
+				{
+					std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
+					AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects);
+					for (const auto& entry : loadedObjects)
+						lockedObjects[entry->data.objectID] = entry;
+				}
 				for (size_t i = 0; i < objs.size(); ++i)
 				{
 					switch (errors[i])
@@ -494,10 +771,15 @@ namespace JsonDatabase
 						}
 						case Error::objectLockedByOther:
 						{
-							auto alreadyLockedObj = lockedObjects.find(objs[i]->getObjectID()->get())->second;
-							m_logger->logError("Can't unlock Object: \"" + objs[i]->getObjectID()->toString() + "\",\nObject locked by user:" +
-												 alreadyLockedObj->data.user.toString() +
-												 "\nLock data:\n" + alreadyLockedObj->toString());
+							auto alreadyLockedObj = lockedObjects.find(objs[i]->getObjectID()->get());
+							if (alreadyLockedObj != lockedObjects.end())
+							{
+								m_logger->logError("Can't unlock Object: \"" + objs[i]->getObjectID()->toString() + "\",\nObject locked by user:" +
+												   alreadyLockedObj->second->data.user.toString() +
+												   "\nLock data:\n" + alreadyLockedObj->second->toString());
+							}
+							else
+								m_logger->logError("Can't unlock object: \"" + objs[i]->getObjectID()->toString() + "\", locked by other user");
 							break;
 						}
 						case Error::unableToUnlockObject:
@@ -517,8 +799,275 @@ namespace JsonDatabase
 			return removingKeys.size() == objs.size() && removingKeys.size() == removed;
 		}
 
+		bool JDObjectLocker::lockIntention_internal(const LockData& lock, Error& err)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_10);
+			std::string key = lock.type == LockData::Type::objectClass ? 
+				getClassLockKey(lock.className) : getRangeLockKey(lock.rangeFirst, lock.rangeLast);
+			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
+			{
+				err = Error::cantOpenRegistryFile;
+				return false;
+			}
+			AbstractRegistry::AutoClose autoClose(this);
+
+			if (AbstractRegistry::isSelfOwned(key))
+			{
+				err = Error::objectAlreadyLocked;
+				return false;
+			}
+			{
+				// The registry is open, the locks of the other sessions can't change during the check
+				JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+				m_lockCacheOutdated.store(true);
+				if (!refreshLockCache_internal(err))
+					return false;
+				if (conflictsWithOther_internal(lock))
+				{
+					err = Error::objectLockedByOther;
+					if (m_logger)m_logger->logError("Can't lock: \"" + key + "\", objects of it are locked by another session");
+					return false;
+				}
+			}
+
+			std::vector<std::shared_ptr<LockEntryObject>> entries = { std::make_shared<LockEntryObjectImpl>(key, lock, m_manager) };
+			int ret = AbstractRegistry::addObjects(entries);
+			m_lockCacheOutdated.store(true);
+			if (ret != 1)
+			{
+				err = AbstractRegistry::lockExists(key) ? Error::objectLockedByOther : Error::unableToLockObject;
+				if (m_logger)m_logger->logError("Can't lock: \"" + key + "\"");
+				return false;
+			}
+			m_ownIntentionLocks[key] = lock;
+			err = Error::none;
+			if (m_logger)m_logger->logInfo("\"" + key + "\" locked");
+			return true;
+		}
+		bool JDObjectLocker::unlockIntention_internal(const std::string& key, Error& err)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_10);
+			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
+			{
+				err = Error::cantOpenRegistryFile;
+				return false;
+			}
+			AbstractRegistry::AutoClose autoClose(this);
+
+			if (!AbstractRegistry::isSelfOwned(key))
+			{
+				err = AbstractRegistry::lockExists(key) ? Error::objectLockedByOther : Error::objectNotLocked;
+				if (m_logger)m_logger->logWarning("Can't unlock: \"" + key + "\", it is not locked by this session");
+				return false;
+			}
+			std::vector<std::string> keys = { key };
+			int ret = AbstractRegistry::removeObjects(keys);
+			m_lockCacheOutdated.store(true);
+			if (ret != 1)
+			{
+				err = Error::unableToUnlockObject;
+				if (m_logger)m_logger->logError("Can't unlock: \"" + key + "\"");
+				return false;
+			}
+			m_ownIntentionLocks.erase(key);
+			err = Error::none;
+			if (m_logger)m_logger->logInfo("\"" + key + "\" unlocked");
+			return true;
+		}
+
+		std::string JDObjectLocker::getClassLockKey(const std::string& className)
+		{
+			return "class_" + className;
+		}
+		std::string JDObjectLocker::getRangeLockKey(const JDObjectID::IDType& first, const JDObjectID::IDType& last)
+		{
+			return "range_" + JDObjectID::toString(first) + "_" + JDObjectID::toString(last);
+		}
+
+		const JDObjectLocker::LockData* JDObjectLocker::findIntentionLock_internal(const JDObjectID::IDType& id, const std::string& className, bool byOther) const
+		{
+			std::string sessionID = m_manager.getUser().getSessionID();
+			if (className.size() > 0)
+			{
+				const auto& it = m_classLockCache.find(className);
+				if (it != m_classLockCache.end() && (it->second.user.getSessionID() != sessionID) == byOther)
+					return &it->second;
+			}
+			for (const auto& lock : m_rangeLockCache)
+			{
+				if (id >= lock.rangeFirst && id <= lock.rangeLast && (lock.user.getSessionID() != sessionID) == byOther)
+					return &lock;
+			}
+			return nullptr;
+		}
+		bool JDObjectLocker::conflictsWithOther_internal(const LockData& lock) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			std::string sessionID = m_manager.getUser().getSessionID();
+
+			// Class and range locks can only be compared through the objects that are known by this session,
+			// IDs that are not loaded count as conflicting
+			std::vector<JDObject> objs;
+			bool objsLoaded = false;
+			auto getObjs = [&]() -> const std::vector<JDObject>&
+				{
+					if (!objsLoaded)
+						objs = m_manager.getObjects_internal();
+					objsLoaded = true;
+					return objs;
+				};
+
+			if (lock.type == LockData::Type::objectClass)
+			{
+				const auto& it = m_classLockCache.find(lock.className);
+				if (it != m_classLockCache.end() && it->second.user.getSessionID() != sessionID)
+					return true;
+				for (const auto& objLock : m_lockCache)
+				{
+					if (objLock.second.user.getSessionID() == sessionID)
+						continue;
+					// The class of an object lock of an older version is unknown if the object is not loaded
+					std::string className = getClassName_internal(objLock.second);
+					if (className.size() == 0 || className == lock.className)
+						return true;
+				}
+				for (const auto& rangeLock : m_rangeLockCache)
+				{
+					if (rangeLock.user.getSessionID() != sessionID &&
+						rangeMayContainClass_internal(rangeLock.rangeFirst, rangeLock.rangeLast, lock.className, getObjs()))
+						return true;
+				}
+				return false;
+			}
+
+			for (const auto& objLock : m_lockCache)
+			{
+				const JDObjectID::IDType& id = objLock.first;
+				if (objLock.second.user.getSessionID() != sessionID && id >= lock.rangeFirst && id <= lock.rangeLast)
+					return true;
+			}
+			for (const auto& rangeLock : m_rangeLockCache)
+			{
+				if (rangeLock.user.getSessionID() != sessionID &&
+					rangeLock.rangeFirst <= lock.rangeLast && lock.rangeFirst <= rangeLock.rangeLast)
+					return true;
+			}
+			for (const auto& classLock : m_classLockCache)
+			{
+				if (classLock.second.user.getSessionID() != sessionID &&
+					rangeMayContainClass_internal(lock.rangeFirst, lock.rangeLast, classLock.first, getObjs()))
+					return true;
+			}
+			return false;
+		}
+		bool JDObjectLocker::rangeMayContainClass_internal(const JDObjectID::IDType& first, const JDObjectID::IDType& last,
+														   const std::string& className, const std::vector<JDObject>& loadedObjs) const
+		{
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+			if (last < first)
+				return false;
+			unsigned long long loadedInRange = 0;
+			for (const auto& obj : loadedObjs)
+			{
+				const JDObjectID::IDType& id = obj->getObjectID()->get();
+				if (id < first || id > last)
+					continue;
+				if (obj->className() == className)
+					return true;
+				++loadedInRange;
+			}
+			unsigned long long rangeSize = static_cast<unsigned long long>(last) - static_cast<unsigned long long>(first) + 1;
+			return loadedInRange < rangeSize;
+#else
+			// The IDs of a range can't be enumerated
+			JD_UNUSED(first);
+			JD_UNUSED(last);
+			JD_UNUSED(className);
+			JD_UNUSED(loadedObjs);
+			return true;
+#endif
+		}
+		std::string JDObjectLocker::getClassName_internal(const LockData& objectLock) const
+		{
+			if (objectLock.className.size() > 0)
+				return objectLock.className;
+			// Lock of an older version, which does not store the class name
+			JDObject obj = m_manager.getObject_internal(objectLock.objectID);
+			if (obj)
+				return obj->className();
+			return "";
+		}
+
+		bool JDObjectLocker::refreshLockCache_internal(Error& err) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			err = Error::none;
+			bool outdated = m_lockCacheOutdated.exchange(false);
+			if (m_lockCacheValid && !outdated)
+				return true;
+
+			// The watcher also fires for writes that did not change the content,
+			// the generation of the registry file tells if a reload is needed
+			std::string registryFile = AbstractRegistry::getRegistrationFilePath();
+			unsigned long long generation = 0;
+			bool hasGeneration = LockedFileAccessor::readGeneration(registryFile, generation);
+			if (m_lockCacheValid && hasGeneration && generation == m_lockCacheGeneration)
+				return true;
+
+			// The caller may already have opened the registry, it must stay open in that case
+			bool wasOpen = AbstractRegistry::isRegistryFileOpen();
+			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
+			{
+				m_lockCacheOutdated.store(true);
+				err = Error::cantOpenRegistryFile;
+				return false;
+			}
+			AbstractRegistry::AutoClose autoClose(wasOpen ? nullptr : this);
+
+			// Read again, the registry can't change while it is open
+			hasGeneration = LockedFileAccessor::readGeneration(registryFile, generation);
+			std::vector<std::shared_ptr<LockEntryObjectImpl>> loadedObjects;
+			if (!AbstractRegistry::readObjects<LockEntryObjectImpl>(loadedObjects))
+			{
+				m_lockCacheOutdated.store(true);
+				err = Error::corruptRegistryFileData;
+				return false;
+			}
+
+			m_lockCache.clear();
+			m_classLockCache.clear();
+			m_rangeLockCache.clear();
+			m_lockCache.reserve(loadedObjects.size());
+			for (const auto& obj : loadedObjects)
+			{
+				if (obj->data.type == LockData::Type::objectClass)
+					m_classLockCache[obj->data.className] = obj->data;
+				else if (obj->data.type == LockData::Type::idRange)
+					m_rangeLockCache.push_back(obj->data);
+				else if (obj->data.objectID != JDObjectID::invalidID)
+					m_lockCache[obj->data.objectID] = obj->data;
+				else
+				{
+					if (m_logger)m_logger->logWarning("Object has empty objectID: "
+						+ obj->toString() + "\n");
+				}
+			}
+			m_lockCacheValid = true;
+			m_lockCacheGeneration = hasGeneration ? generation : 0;
+			return true;
+		}
+		void JDObjectLocker::invalidateLockCache() const
+		{
+			JDM_UNIQUE_LOCK_M(m_lockCacheMutex);
+			m_lockCacheValid = false;
+			m_lockCache.clear();
+			m_classLockCache.clear();
+			m_rangeLockCache.clear();
+		}
+
 		void JDObjectLocker::onCreateFiles()
 		{
+			invalidateLockCache();
 			m_lockTableWatcher.setup(AbstractRegistry::getRegistrationFilePath(), m_logger);
 		}
 
@@ -528,12 +1077,13 @@ namespace JsonDatabase
 		}
 		void JDObjectLocker::onDatabasePathChangeEnd()
 		{
-
+			invalidateLockCache();
 		}
 
 		void JDObjectLocker::onNameChange(const std::string& newName)
 		{
 			JD_UNUSED(newName);
+			invalidateLockCache();
 		}
 
 
@@ -549,6 +1099,15 @@ namespace JsonDatabase
 		{
 			setObject(obj, manager);
 		}
+		JDObjectLocker::LockEntryObjectImpl::LockEntryObjectImpl(const std::string& key, const LockData& lockData, const JDManager& manager)
+			: LockEntryObject(key)
+			, data(lockData)
+			, obj(nullptr)
+		{
+			data.user     = manager.getUser();
+			data.lockDate = QDate::currentDate();
+			data.lockTime = QTime::currentTime();
+		}
 		JDObjectLocker::LockEntryObjectImpl::~LockEntryObjectImpl()
 		{
 
@@ -558,7 +1117,9 @@ namespace JsonDatabase
 			this->obj = obj;
 			if (!this->obj.get())
 				return;
+			data.type      = LockData::Type::object;
 			data.objectID  = this->obj->getObjectID()->get();
+			data.className = this->obj->className();
 			data.user      = manager.getUser();
 			data.lockDate  = QDate::currentDate();
 			data.lockTime  = QTime::currentTime();
@@ -577,6 +1138,26 @@ namespace JsonDatabase
 			data.lockTime = Utilities::fastStringToQTime(obj.at(JsonKeys::lockTime).get<std::string>());
 			//data.lockTime = Utilities::stringToQTime(obj.at(JsonKeys::lockTime).get<std::string>());
 
+			// Optional, not written by older versions
+			data.type = LockData::Type::object;
+			if (obj.contains(JsonKeys::lockType))
+			{
+				const std::string& type = obj.at(JsonKeys::lockType).get<std::string>();
+				if (type == "class")
+					data.type = LockData::Type::objectClass;
+				else if (type == "range")
+					data.type = LockData::Type::idRange;
+			}
+			if (obj.contains(JsonKeys::className))
+				data.className = obj.at(JsonKeys::className).get<std::string>();
+			if (data.type == LockData::Type::idRange)
+			{
+				if (!obj.contains(JsonKeys::rangeFirst) || !obj.contains(JsonKeys::rangeLast))
+					return false;
+				data.rangeFirst = obj.at(JsonKeys::rangeFirst).get<JDObjectID::IDType>();
+				data.rangeLast = obj.at(JsonKeys::rangeLast).get<JDObjectID::IDType>();
+			}
+
 			return success;
 		}
 
@@ -591,6 +1172,25 @@ namespace JsonDatabase
 			obj[JsonKeys::user] = userObj;
 			obj[JsonKeys::lockDate] = Utilities::qDateToString(data.lockDate);
 			obj[JsonKeys::lockTime] = Utilities::qTimeToString(data.lockTime);
+			if (data.className.size() > 0)
+				obj[JsonKeys::className] = data.className;
+			switch (data.type)
+			{
+				case LockData::Type::objectClass:
+				{
+					obj[JsonKeys::lockType] = std::string("class");
+					break;
+				}
+				case LockData::Type::idRange:
+				{
+					obj[JsonKeys::lockType] = std::string("range");
+					obj[JsonKeys::rangeFirst] = data.rangeFirst;
+					obj[JsonKeys::rangeLast] = data.rangeLast;
+					break;
+				}
+				default:
+					break;
+			}
 			return true;
 		}
 
@@ -0,0 +1,186 @@
+#include "manager/async/JDAsyncHandle.h"
+#include "utilities/JDUniqueMutexLock.h"
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        JDAsyncState::JDAsyncState()
+            : m_cancelled(false)
+            , m_done(false)
+            , m_success(false)
+            , m_hasDeadline(false)
+        {
+
+        }
+        JDAsyncState::~JDAsyncState()
+        {
+
+        }
+
+        void JDAsyncState::cancel()
+        {
+            m_cancelled.store(true);
+        }
+        bool JDAsyncState::isCancelled() const
+        {
+            return m_cancelled.load();
+        }
+
+        void JDAsyncState::setDeadline(const std::chrono::steady_clock::time_point& deadline)
+        {
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            m_deadline = deadline;
+            m_hasDeadline.store(true);
+        }
+        bool JDAsyncState::isDeadlineExceeded() const
+        {
+            if (!m_hasDeadline.load())
+                return false;
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            return std::chrono::steady_clock::now() > m_deadline;
+        }
+
+        bool JDAsyncState::isAbortRequested() const
+        {
+            return isCancelled() || isDeadlineExceeded();
+        }
+
+        void JDAsyncState::complete(bool success)
+        {
+            std::vector<std::function<void(bool)>> continuations;
+            {
+                JDM_UNIQUE_LOCK_M(m_mutex);
+                if (m_done.load())
+                    return;
+                m_success.store(success);
+                m_done.store(true);
+                continuations.swap(m_continuations);
+                m_cv.notify_all();
+            }
+            // Outside of the lock, a continuation may add new work or wait for other work
+            for (auto& continuation : continuations)
+                continuation(success);
+        }
+        bool JDAsyncState::isDone() const
+        {
+            return m_done.load();
+        }
+        bool JDAsyncState::hasSucceeded() const
+        {
+            return m_done.load() && m_success.load();
+        }
+
+        bool JDAsyncState::wait() const
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_done.load(); });
+            return m_success.load();
+        }
+        bool JDAsyncState::waitFor(unsigned int timeoutMs) const
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return m_done.load(); });
+        }
+
+        bool JDAsyncState::addContinuation(const std::function<void(bool)>& continuation)
+        {
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            if (m_done.load())
+                return false;
+            m_continuations.push_back(continuation);
+            return true;
+        }
+    }
+
+    JDAsyncHandle::JDAsyncHandle()
+        : m_state(nullptr)
+    {
+
+    }
+    JDAsyncHandle::JDAsyncHandle(const std::shared_ptr<Internal::JDAsyncState>& state)
+        : m_state(state)
+    {
+
+    }
+
+    bool JDAsyncHandle::isValid() const
+    {
+        return m_state != nullptr;
+    }
+    bool JDAsyncHandle::isDone() const
+    {
+        if (!m_state)
+            return true;
+        return m_state->isDone();
+    }
+    bool JDAsyncHandle::hasSucceeded() const
+    {
+        if (!m_state)
+            return false;
+        return m_state->hasSucceeded();
+    }
+
+    bool JDAsyncHandle::wait() const
+    {
+        if (!m_state)
+            return false;
+        return m_state->wait();
+    }
+    bool JDAsyncHandle::waitFor(unsigned int timeoutMs) const
+    {
+        if (!m_state)
+            return true;
+        return m_state->waitFor(timeoutMs);
+    }
+
+    void JDAsyncHandle::cancel()
+    {
+        if (m_state)
+            m_state->cancel();
+    }
+    bool JDAsyncHandle::isCancelled() const
+    {
+        if (!m_state)
+            return false;
+        return m_state->isCancelled();
+    }
+
+    void JDAsyncHandle::setDeadline(unsigned int timeoutMs)
+    {
+        setDeadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs));
+    }
+    void JDAsyncHandle::setDeadline(const std::chrono::steady_clock::time_point& deadline)
+    {
+        if (m_state)
+            m_state->setDeadline(deadline);
+    }
+
+    const JDAsyncHandle& JDAsyncHandle::then(const std::function<void(bool success)>& continuation) const
+    {
+        if (!m_state)
+        {
+            continuation(false);
+            return *this;
+        }
+        if (!m_state->addContinuation(continuation))
+            continuation(m_state->hasSucceeded());
+        return *this;
+    }
+
+    bool JDAsyncHandle::await_ready() const
+    {
+        return isDone();
+    }
+    bool JDAsyncHandle::await_suspend(std::coroutine_handle<> handle) const
+    {
+        if (!m_state)
+            return false;
+        // Returning false resumes the coroutine immediately, the work completed in the meantime
+        return m_state->addContinuation([handle](bool) { handle.resume(); });
+    }
+    bool JDAsyncHandle::await_resume() const
+    {
+        return hasSucceeded();
+    }
+}
@@ -10,6 +10,9 @@ namespace JsonDatabase
             std::mutex& mtx)
             : m_manager(manager)
             , m_mutex(mtx)
+            , m_success(false)
+            , m_state(std::make_shared<JDAsyncState>())
+            , m_queueSequence(0)
         {
             m_progress.setProgress(0);
         }
@@ -18,5 +21,23 @@ namespace JsonDatabase
         {
 
         }
+
+        WorkPriority JDManagerAysncWork::getPriority() const
+        {
+            return WorkPriority::normal;
+        }
+        bool JDManagerAysncWork::isReadOnly() const
+        {
+            return false;
+        }
+        bool JDManagerAysncWork::merge(const JDManagerAysncWork& other)
+        {
+            JD_UNUSED(other);
+            return false;
+        }
+        JDAsyncHandle JDManagerAysncWork::getHandle() const
+        {
+            return JDAsyncHandle(m_state);
+        }
     }
 }
\ No newline at end of file
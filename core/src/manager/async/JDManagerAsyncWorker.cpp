@@ -11,7 +11,15 @@ namespace JsonDatabase
             std::mutex& mtx)
             : m_manager(manager)
             , m_mutex(mtx)
-            , m_thread(nullptr)
+            , m_workerCount(2)
+            , m_affinityMask(0)
+            , m_exclusiveRunning(false)
+            , m_nextQueueSequence(0)
+            , m_stopFlag(false)
+            , m_busy(false)
+            , m_startSignalPending(false)
+            , m_idleWorkers(0)
+            , m_submitQueue(s_submitQueueCapacity)
         {
         }
         JDManagerAsyncWorker::~JDManagerAsyncWorker()
@@ -37,8 +45,28 @@ namespace JsonDatabase
         void JDManagerAsyncWorker::addWork(std::shared_ptr<JDManagerAysncWork> work)
         {
             JD_ASYNC_WORKER_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
-            JDM_UNIQUE_LOCK_M(m_workListMutex);
-            m_workList.push_back(work);
+            m_busy.store(true);
+            m_startSignalPending.store(true);
+            // The queue gets drained by the workers, so work can also be added from a continuation on a worker thread
+            if (!m_submitQueue.tryPush(work))
+            {
+                // The queue is full, queue it directly
+                JDM_UNIQUE_LOCK_M(m_mutexInternal);
+                drainSubmitQueue_internal();
+                queueWork_internal(work);
+            }
+            // Pairs with the fence in threadLoop, either the idle worker sees the work or we see the idle worker.
+            // Workers that wait for blocked work don't count as idle, so the lock is only taken if a worker can start the work.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_idleWorkers.load() > 0)
+            {
+                {
+                    // Makes sure the idle worker is waiting, not between its check and the wait
+                    JDM_UNIQUE_LOCK_M(m_mutexInternal);
+                }
+                m_cv.notify_all();
+            }
+            m_manager.requestUpdate();
         }
         bool JDManagerAsyncWorker::isWorkDone(std::shared_ptr<JDManagerAysncWork> work)
         {
@@ -62,56 +90,62 @@ namespace JsonDatabase
             m_workListDone.clear();
         }
 
-        void JDManagerAsyncWorker::process()
+        bool JDManagerAsyncWorker::process()
         {
-            {
-                JDM_UNIQUE_LOCK_M(m_workListMutex);
-                if (m_workList.size() == 0)
-                    return;
-            }
+            if (!m_startSignalPending.exchange(false))
+                return false;
             emit m_manager.startAsyncWork();
             //m_manager.m_signals.addToQueue(JDManagerSignals::Signals::signal_onStartAsyncWork, true);
-            m_cv.notify_all();
+            return true;
         }
         void JDManagerAsyncWorker::start()
         {
-            if (m_thread)
+            if (m_threads.size() > 0)
                 return;
             if (m_logger)
-                m_logger->logInfo("Starting JDManagerAsyncWorker");
+                m_logger->logInfo("Starting JDManagerAsyncWorker with " + std::to_string(m_workerCount) + " workers");
             m_stopFlag.store(false);
-            m_thread = new std::thread(&JDManagerAsyncWorker::threadLoop, this);
-
-            DWORD_PTR dw = SetThreadAffinityMask(m_thread->native_handle(), DWORD_PTR(1));
-            if (dw == 0)
+            for (unsigned int i = 0; i < m_workerCount; ++i)
             {
+                std::thread* thread = new std::thread(&JDManagerAsyncWorker::threadLoop, this, i);
+                m_threads.push_back(thread);
+                if (m_affinityMask == 0)
+                    continue;
+
+                DWORD_PTR dw = SetThreadAffinityMask(thread->native_handle(), DWORD_PTR(m_affinityMask));
+                if (dw == 0)
+                {
 #ifndef NDEBUG
-                DWORD dwErr = GetLastError();
-                if(m_logger)m_logger->logError("SetThreadAffinityMask failed, GLE=" + std::to_string(dwErr));
+                    DWORD dwErr = GetLastError();
+                    if(m_logger)m_logger->logError("SetThreadAffinityMask failed, GLE=" + std::to_string(dwErr));
 #endif
+                }
             }
         }
         void JDManagerAsyncWorker::stop()
         {
-            if (!m_thread)
+            if (m_threads.size() == 0)
                 return;
             {
                 JDM_UNIQUE_LOCK_M(m_mutexInternal);
                 m_stopFlag.store(true);
                 m_cv.notify_all();
             }
-            m_thread->join();
-            delete m_thread;
-            m_thread = nullptr;
+            for (std::thread* thread : m_threads)
+            {
+                thread->join();
+                delete thread;
+            }
+            m_threads.clear();
         }
 
         WorkProgress JDManagerAsyncWorker::getWorkProgress() const
         {
             WorkProgress p;
-            std::shared_ptr<JDManagerAysncWork> currentWork = m_currentWork.load();
-            if (currentWork)
+            JDM_UNIQUE_LOCK_M(m_mutexInternal);
+            if (m_runningWork.size() > 0)
             {
-				p = currentWork->m_progress;
+				p = m_runningWork.front()->m_progress;
 			}
             return p;
         }
@@ -121,73 +155,250 @@ namespace JsonDatabase
         }
         WorkType JDManagerAsyncWorker::getCurrentWorkType() const
         {
-            std::shared_ptr<JDManagerAysncWork> currentWork = m_currentWork.load();
-            return currentWork->getWorkType();
+            // Only valid while isBusy() returns true
+            JDM_UNIQUE_LOCK_M(m_mutexInternal);
+            if (m_runningWork.size() > 0)
+                return m_runningWork.front()->getWorkType();
+            return WorkType::loadAllObjects;
+        }
+
+        void JDManagerAsyncWorker::setWorkerCount(unsigned int count)
+        {
+            if (count == 0)
+                count = 1;
+            if (count == m_workerCount)
+                return;
+            bool running = m_threads.size() > 0;
+            stop();
+            m_workerCount = count;
+            if (running)
+            {
+                start();
+                m_cv.notify_all();
+            }
+        }
+        unsigned int JDManagerAsyncWorker::getWorkerCount() const
+        {
+            return m_workerCount;
+        }
+        void JDManagerAsyncWorker::setWorkerAffinityMask(unsigned long long mask)
+        {
+            m_affinityMask = mask;
+        }
+        unsigned long long JDManagerAsyncWorker::getWorkerAffinityMask() const
+        {
+            return m_affinityMask;
         }
 
 
-        void JDManagerAsyncWorker::threadLoop()
+        void JDManagerAsyncWorker::threadLoop(unsigned int workerIndex)
         {
-            JD_PROFILING_THREAD((m_manager.getDatabaseName()+"::"+ m_manager.getUser().getName() + " JDManagerAsyncWorker").c_str());
-            while (!m_stopFlag.load())
+            JD_PROFILING_THREAD((m_manager.getDatabaseName()+"::"+ m_manager.getUser().getName() + " JDManagerAsyncWorker " + std::to_string(workerIndex)).c_str());
+            while (true)
             {
-                m_busy.store(false);
+                std::shared_ptr<JDManagerAysncWork> work;
                 {
                     std::unique_lock<std::mutex> lock(m_mutexInternal);
                     JD_ASYNC_WORKER_PROFILING_BLOCK("JDManagerAsyncWorker::threadLoop::idle", JD_COLOR_STAGE_1);
 
-                    // Wait until we have work to do
-                    m_cv.wait(lock);
+                    // Wait until we have work to do which can run next to the running work.
+                    // Only a worker without pending work counts as idle, added work can't pass
+                    // blocked work. Blocked work gets started by the notify of finishWork().
+                    bool idle = false;
+                    m_cv.wait(lock, [this, &work, &idle] {
+                        if (m_stopFlag.load())
+                            return true;
+                        drainSubmitQueue_internal();
+                        work = takeNextWork_internal();
+                        if (!work && !idle && !hasPendingWork_internal())
+                        {
+                            idle = true;
+                            m_idleWorkers.fetch_add(1);
+                            // Pairs with the fence in addWork, either addWork sees the idle worker
+                            // or we see the added work
+                            std::atomic_thread_fence(std::memory_order_seq_cst);
+                            drainSubmitQueue_internal();
+                            work = takeNextWork_internal();
+                        }
+                        return work != nullptr;
+                        });
+                    if (idle)
+                        m_idleWorkers.fetch_sub(1);
 
                     if (m_stopFlag.load()) {
                         break;
                     }
                 }
-                m_busy.store(true);
-                bool hasWork = true;
                 {
                     JD_ASYNC_WORKER_PROFILING_BLOCK("JDManagerAsyncWorker::threadLoop::work", JD_COLOR_STAGE_1);
-                    while (hasWork)
-                    {
-                        //JD_ASYNC_WORKER_PROFILING_BLOCK("while", JD_COLOR_STAGE_1);
-                        //JD_ASYNC_WORKER_PROFILING_BLOCK("copy workList", JD_COLOR_STAGE_1);
-                        std::vector<std::shared_ptr<JDManagerAysncWork>> workCPY;
-                        {
-                            JDM_UNIQUE_LOCK_M(m_workListMutex);
-                            workCPY = m_workList;
-                            m_workList.clear();
-                        }
-                       // JD_ASYNC_WORKER_PROFILING_END_BLOCK;
-                        processWork(workCPY);
-                        //JD_ASYNC_WORKER_PROFILING_BLOCK("check workList", JD_COLOR_STAGE_1);
-                        {
-                            //JDM_UNIQUE_LOCK_M(m_workListMutex);
-                            hasWork = !m_workList.empty();
-                        }
-                    }
+                    processWork(work);
+                }
+                bool allDone = false;
+                {
+                    JDM_UNIQUE_LOCK_M(m_mutexInternal);
+                    drainSubmitQueue_internal();
+                    allDone = m_runningWork.size() == 0 && !hasPendingWork_internal();
+                    if (allDone)
+                        m_busy.store(false);
+                }
+                if (allDone)
+                {
                     //m_manager.m_signals.addToQueue(JDManagerSignals::Signals::signal_onEndAsyncWork, true);
                     emit m_manager.endAsyncWork();
                 }
             }
         }
-        void JDManagerAsyncWorker::processWork(const std::vector<std::shared_ptr<JDManagerAysncWork>>& workList)
+        void JDManagerAsyncWorker::drainSubmitQueue_internal()
         {
-            JD_ASYNC_WORKER_PROFILING_FUNCTION(JD_COLOR_STAGE_2);
-            for (auto& work : workList)
+            // m_mutexInternal is locked, so only one worker at a time consumes the queue
+            std::shared_ptr<JDManagerAysncWork> work;
+            while (m_submitQueue.tryPop(work))
+                queueWork_internal(work);
+        }
+        void JDManagerAsyncWorker::queueWork_internal(const std::shared_ptr<JDManagerAysncWork>& work)
+        {
+            work->m_queueSequence = ++m_nextQueueSequence;
+            if (mergeWork_internal(work))
+                return;
+            m_lanes[(size_t)work->getPriority()].push_back(work);
+            if (!work->isReadOnly())
+                m_exclusiveOrder.push_back(work.get());
+        }
+        bool JDManagerAsyncWorker::mergeWork_internal(const std::shared_ptr<JDManagerAysncWork>& work)
+        {
+            // m_mutexInternal is locked.
+            // Pending work which did not start yet, newest first
+            std::vector<JDManagerAysncWork*> pending;
+            if (work->isReadOnly())
+            {
+                for (size_t i = 0; i < s_laneCount; ++i)
+                    for (auto it = m_lanes[i].rbegin(); it != m_lanes[i].rend(); ++it)
+                        pending.push_back(it->get());
+            }
+            else
+            {
+                for (auto it = m_exclusiveOrder.rbegin(); it != m_exclusiveOrder.rend(); ++it)
+                    pending.push_back(*it);
+            }
+
+            for (JDManagerAysncWork* other : pending)
             {
-                processWork(work);
+                if (other->isReadOnly() != work->isReadOnly())
+                    continue;
+                // Merged read only work runs with the older work. It would pass exclusive work
+                // that was queued in between, the same applies to all older pending work.
+                if (work->isReadOnly() && m_exclusiveOrder.size() > 0 &&
+                    m_exclusiveOrder.back()->m_queueSequence > other->m_queueSequence)
+                    return false;
+                // Cancelled work would take the merged work with it
+                if (!other->m_state->isAbortRequested() && other->merge(*work))
+                {
+                    other->m_mergedWork.push_back(work);
+                    return true;
+                }
+                // Work can only be merged into older work, if it would not pass other work by that
+                if (!work->isReadOnly() && !canReorder(*other, *work))
+                    return false;
             }
+            return false;
         }
-        void JDManagerAsyncWorker::processWork(std::shared_ptr<JDManagerAysncWork> work)
+        bool JDManagerAsyncWorker::canReorder(const JDManagerAysncWork& a, const JDManagerAysncWork& b)
+        {
+            // Saves store the current object data, their order does not matter.
+            // A load in between would read a different file content.
+            auto isSave = [](WorkType type) {
+                return type == WorkType::saveSingleObject || type == WorkType::saveAllObjects;
+                };
+            return isSave(a.getWorkType()) && isSave(b.getWorkType());
+        }
+        std::shared_ptr<JDManagerAysncWork> JDManagerAsyncWorker::takeNextWork_internal()
+        {
+            // Lanes get searched from the highest priority to the lowest.
+            // Read only work can run next to other read only work, but never before exclusive work
+            // that was queued earlier, so a load sees the saves that were queued before it.
+            // Other work has to wait until nothing else runs and keeps the order in which it was added,
+            // a write of a lower lane therefore also blocks the following writes of higher lanes.
+            for (size_t i = 0; i < s_laneCount; ++i)
+            {
+                std::deque<std::shared_ptr<JDManagerAysncWork>>& lane = m_lanes[i];
+                for (auto it = lane.begin(); it != lane.end(); ++it)
+                {
+                    std::shared_ptr<JDManagerAysncWork> work = *it;
+                    if (work->isReadOnly())
+                    {
+                        if (m_exclusiveRunning || isBehindExclusiveWork_internal(*work))
+                            continue;
+                    }
+                    else
+                    {
+                        if (m_exclusiveOrder.front() != work.get())
+                            continue;
+                        // Wait until the running work is done. Later work is blocked by the order,
+                        // earlier read only work of a lower lane may still start meanwhile.
+                        if (m_runningWork.size() > 0)
+                            continue;
+                        m_exclusiveOrder.pop_front();
+                        m_exclusiveRunning = true;
+                    }
+                    lane.erase(it);
+                    m_runningWork.push_back(work);
+                    m_busy.store(true);
+                    return work;
+                }
+            }
+            return nullptr;
+        }
+        bool JDManagerAsyncWorker::hasPendingWork_internal() const
+        {
+            // m_mutexInternal is locked.
+            for (size_t i = 0; i < s_laneCount; ++i)
+                if (!m_lanes[i].empty())
+                    return true;
+            return false;
+        }
+        bool JDManagerAsyncWorker::isBehindExclusiveWork_internal(const JDManagerAysncWork& readOnlyWork) const
+        {
+            // m_mutexInternal is locked.
+            return m_exclusiveOrder.size() > 0 &&
+                m_exclusiveOrder.front()->m_queueSequence < readOnlyWork.m_queueSequence;
+        }
+        void JDManagerAsyncWorker::finishWork(const std::shared_ptr<JDManagerAysncWork>& work)
         {
-            JD_ASYNC_WORKER_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
-            m_currentWork.store(work);
-            work->process();
-            //JD_ASYNC_WORKER_PROFILING_BLOCK("After work", JD_COLOR_STAGE_3);
             {
                 JDM_UNIQUE_LOCK_M(m_mutexInternal);
-				m_workListDone.push_back(work);
+                auto it = std::find(m_runningWork.begin(), m_runningWork.end(), work);
+                if (it != m_runningWork.end())
+                    m_runningWork.erase(it);
+                if (!work->isReadOnly())
+                    m_exclusiveRunning = false;
+
+                m_workListDone.push_back(work);
+                for (auto& merged : work->m_mergedWork)
+                    m_workListDone.push_back(merged);
             }
+            // Work which waited for this one may be able to run now
+            m_cv.notify_all();
+        }
+        void JDManagerAsyncWorker::processWork(std::shared_ptr<JDManagerAysncWork> work)
+        {
+            JD_ASYNC_WORKER_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
+            // The work only gets aborted, if every merged caller gave it up
+            std::vector<std::shared_ptr<JDAsyncState>> states;
+            states.push_back(work->m_state);
+            for (auto& merged : work->m_mergedWork)
+                states.push_back(merged->m_state);
+            work->m_progress.setAbortCheck([states]() {
+                for (auto& state : states)
+                    if (!state->isAbortRequested())
+                        return false;
+                return true;
+                });
+
+            if (work->m_progress.isAbortRequested())
+                work->m_success = false;
+            else
+                work->process();
+            //JD_ASYNC_WORKER_PROFILING_BLOCK("After work", JD_COLOR_STAGE_3);
             if (work->hasSucceeded())
             {
                 work->m_progress.setProgress(1.0);
@@ -196,10 +407,28 @@ namespace JsonDatabase
             else
             {
                 work->m_progress.setProgress(0.0);
-                work->m_progress.setComment(work->getErrorMessage());
+                if (work->m_progress.isAbortRequested())
+                    work->m_progress.setComment(work->m_state->isCancelled() ? "Cancelled" : "Deadline exceeded");
+                else
+                    work->m_progress.setComment(work->getErrorMessage());
             }
-            m_currentWork.store(nullptr);
+            for (auto& merged : work->m_mergedWork)
+            {
+                merged->m_success = work->m_success;
+                merged->m_progress = work->m_progress;
+            }
+            finishWork(work);
+
+            // The work no longer blocks other work, continuations can wait for new work.
+            // Every merged caller gets its own completion.
             m_manager.onAsyncWorkDone(work);
+            work->m_state->complete(work->m_success);
+            for (auto& merged : work->m_mergedWork)
+            {
+                m_manager.onAsyncWorkDone(merged);
+                merged->m_state->complete(merged->m_success);
+            }
+            work->m_mergedWork.clear();
         }
     }
 }
\ No newline at end of file
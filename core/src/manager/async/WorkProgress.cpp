@@ -6,12 +6,35 @@ namespace JsonDatabase
     {
         WorkProgress::WorkProgress()
             : m_scalar(1)
+            , m_subProgress(0)
             , m_progress(0)
+            , m_publishedProgress(0)
+            , m_taskText(std::make_shared<const std::string>())
+            , m_comment(std::make_shared<const std::string>())
+        {
+
+        }
+        WorkProgress::WorkProgress(const WorkProgress& other)
+            : m_scalar(1)
             , m_subProgress(0)
-            , m_taskText("")
-            , m_comment("")
+            , m_progress(other.m_publishedProgress.load())
+            , m_publishedProgress(other.m_publishedProgress.load())
+            , m_taskText(other.m_taskText.load())
+            , m_comment(other.m_comment.load())
         {
 
+        }
+        WorkProgress& WorkProgress::operator=(const WorkProgress& other)
+        {
+            if (this == &other)
+                return *this;
+            m_scalar = 1;
+            m_subProgress = 0;
+            m_progress = other.m_publishedProgress.load();
+            m_publishedProgress.store(m_progress);
+            m_taskText.store(other.m_taskText.load());
+            m_comment.store(other.m_comment.load());
+            return *this;
         }
         WorkProgress::~WorkProgress()
         {
@@ -23,12 +46,14 @@ namespace JsonDatabase
             m_subProgress = percent * m_scalar;
             if(m_progress + m_subProgress > 1)
                 m_subProgress = 1 - m_progress;
+            publishProgress(false);
         }
         void WorkProgress::addProgress(double percent)
         {
             m_subProgress += percent * m_scalar;
             if (m_progress + m_subProgress > 1)
                 m_subProgress = 1 - m_progress;
+            publishProgress(false);
         }
         void WorkProgress::startNewSubProgress(double range)
         {
@@ -40,6 +65,7 @@ namespace JsonDatabase
         {
 			m_progress = 1;
             m_subProgress = 0;
+            publishProgress(true);
         }
         void WorkProgress::setSubProgressCompleted()
         {
@@ -47,11 +73,13 @@ namespace JsonDatabase
         }
         void WorkProgress::setTaskName(const std::string& name)
         {
-            m_taskText = name;
+            m_taskText.store(std::make_shared<const std::string>(name));
         }
         void WorkProgress::setComment(const std::string& comment)
         {
-            m_comment = comment;
+            // Comments change once per phase, they get published immediately
+            m_comment.store(std::make_shared<const std::string>(comment));
+            publishProgress(true);
         }
 
         void WorkProgress::setScalar(double scalar)
@@ -68,16 +96,35 @@ namespace JsonDatabase
 
         double WorkProgress::getProgress() const
         {
-            return m_progress + m_subProgress;
+            return m_publishedProgress.load(std::memory_order_relaxed);
         }
-        const std::string& WorkProgress::getTaskText() const
+        std::string WorkProgress::getTaskText() const
         {
-            return m_taskText;
+            return *m_taskText.load();
         }
-        const std::string& WorkProgress::getComment() const
+        std::string WorkProgress::getComment() const
         {
-            return m_comment;
+            return *m_comment.load();
         }
 
+        void WorkProgress::setAbortCheck(const std::function<bool()>& abortCheck)
+        {
+            m_abortCheck = abortCheck;
+        }
+        bool WorkProgress::isAbortRequested() const
+        {
+            if (!m_abortCheck)
+                return false;
+            return m_abortCheck();
+        }
+
+        void WorkProgress::publishProgress(bool force)
+        {
+            double progress = m_progress + m_subProgress;
+            double published = m_publishedProgress.load(std::memory_order_relaxed);
+            if (!force && progress - published < s_publishStep && published - progress < s_publishStep)
+                return;
+            m_publishedProgress.store(progress, std::memory_order_relaxed);
+        }
     }
 }
\ No newline at end of file
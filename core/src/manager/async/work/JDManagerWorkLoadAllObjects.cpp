@@ -11,7 +11,6 @@ namespace JsonDatabase
 			std::mutex& mtx,
 			int mode)
 			: JDManagerAysncWork(manager, mtx)
-			, m_success(false)
 			, m_loadMode(mode)
 		{
 			m_progress.setTaskName("Lade alle Objekte");
@@ -39,5 +38,11 @@ namespace JsonDatabase
 		{
 			return WorkType::loadAllObjects;
 		}
+		bool JDManagerAysncWorkLoadAllObjects::merge(const JDManagerAysncWork& other)
+		{
+			// A second load with the same mode would read the same data again
+			const JDManagerAysncWorkLoadAllObjects* load = dynamic_cast<const JDManagerAysncWorkLoadAllObjects*>(&other);
+			return load && load->m_loadMode == m_loadMode;
+		}
 	}
 }
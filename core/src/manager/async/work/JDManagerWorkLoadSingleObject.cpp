@@ -12,7 +12,6 @@ namespace JsonDatabase
 			const JDObject& object)
 			: JDManagerAysncWork(manager, mtx)
 			, m_object(object)
-			, m_success(false)
 		{
 			if (object)
 			{
@@ -54,5 +53,18 @@ namespace JsonDatabase
 		{
 			return WorkType::loadSingleObject;
 		}
+		WorkPriority JDManagerAysncWorkLoadSingleObject::getPriority() const
+		{
+			return WorkPriority::interactive;
+		}
+		bool JDManagerAysncWorkLoadSingleObject::isReadOnly() const
+		{
+			return true;
+		}
+		bool JDManagerAysncWorkLoadSingleObject::merge(const JDManagerAysncWork& other)
+		{
+			const JDManagerAysncWorkLoadSingleObject* load = dynamic_cast<const JDManagerAysncWorkLoadSingleObject*>(&other);
+			return load && m_object && load->m_object == m_object;
+		}
 	}
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "manager/async/work/JDManagerWorkSaveList.h"
 #include "manager/JDManager.h"
 #include "utilities/JDUniqueMutexLock.h"
+#include "manager/async/work/JDManagerWorkSaveSingle.h"
 #include "utilities/AsyncContextDrivenDeleter.h"
+#include <unordered_map>
 
 namespace JsonDatabase
 {
@@ -13,7 +15,6 @@ namespace JsonDatabase
 			const std::vector<JDObject>& objects,
 			Log::LogObject* parentLogger)
 			: JDManagerAysncWork(manager, mtx)
-			, m_success(false)
 		{
 			m_logger = parentLogger;
 			//if (parentLogger)
@@ -57,5 +58,42 @@ namespace JsonDatabase
 		{
 			return WorkType::saveAllObjects;
 		}
+		WorkPriority JDManagerAysncWorkSaveList::getPriority() const
+		{
+			return WorkPriority::bulk;
+		}
+		bool JDManagerAysncWorkSaveList::merge(const JDManagerAysncWork& other)
+		{
+			// Single saves and other list saves get folded into this list
+			std::vector<JDObject> added;
+			if (const JDManagerAysncWorkSaveSingle* save = dynamic_cast<const JDManagerAysncWorkSaveSingle*>(&other))
+			{
+				if (!save->getObject())
+					return false;
+				added.push_back(save->getObject());
+			}
+			else if (const JDManagerAysncWorkSaveList* list = dynamic_cast<const JDManagerAysncWorkSaveList*>(&other))
+				added = list->m_objects;
+			else
+				return false;
+
+			std::unordered_map<JDObjectID::IDType, size_t> indexes;
+			indexes.reserve(m_objects.size());
+			for (size_t i = 0; i < m_objects.size(); ++i)
+				indexes[m_objects[i]->getObjectID()->get()] = i;
+			for (const JDObject& obj : added)
+			{
+				const auto& it = indexes.find(obj->getObjectID()->get());
+				if (it != indexes.end())
+				{
+					m_objects[it->second] = obj;
+					continue;
+				}
+				indexes[obj->getObjectID()->get()] = m_objects.size();
+				m_objects.push_back(obj);
+			}
+			m_progress.setTaskName("Speichere " + std::to_string(m_objects.size()) + " Objekte");
+			return true;
+		}
 	}
 }
\ No newline at end of file
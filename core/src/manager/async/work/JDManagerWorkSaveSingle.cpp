@@ -12,7 +12,6 @@ namespace JsonDatabase
 			const JDObject& object)
 			: JDManagerAysncWork(manager, mtx)
 			, m_object(nullptr)
-			, m_success(false)
 		{
 			if (object)
 			{
@@ -57,5 +56,20 @@ namespace JsonDatabase
 		{
 			return WorkType::saveSingleObject;
 		}
+		WorkPriority JDManagerAysncWorkSaveSingle::getPriority() const
+		{
+			return WorkPriority::interactive;
+		}
+		bool JDManagerAysncWorkSaveSingle::merge(const JDManagerAysncWork& other)
+		{
+			// The object gets serialized when the work runs, so the pending save also stores the latest data
+			const JDManagerAysncWorkSaveSingle* save = dynamic_cast<const JDManagerAysncWorkSaveSingle*>(&other);
+			if (!save || !m_object || !save->m_object)
+				return false;
+			if (save->m_object->getObjectID()->get() != m_object->getObjectID()->get())
+				return false;
+			m_object = save->m_object;
+			return true;
+		}
 	}
 }
\ No newline at end of file
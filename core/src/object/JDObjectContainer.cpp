@@ -8,12 +8,7 @@ namespace JsonDatabase
     {
         JDObjectManager* JDObjectContainer::operator[](const JDObjectIDptr& id)
         {
-            auto it = m_objectMap.find(id->get());
-            if (it != m_objectMap.end())
-            {
-                return it->second;
-            }
-            return nullptr;
+            return getObjectByID(id->get());
         }
         JDObjectManager* JDObjectContainer::operator[](size_t index)
         {
@@ -24,82 +19,37 @@ namespace JsonDatabase
         }
         size_t JDObjectContainer::operator[](JDObject& obj)
         {
-            for (size_t i = 0; i < m_objectVector.size(); ++i)
-            {
-                if (m_objectVector[i]->getObject().get() == obj.get())
-                    return i;
-            }
-            return std::string::npos;
+            size_t slot = m_ptrIndex.find(obj.get());
+            if (slot == m_ptrIndex.npos)
+                return std::string::npos;
+            return slot;
         }
 
         void JDObjectContainer::reserve(size_t size)
         {
             m_objectVector.reserve(size);
-            m_objectPtrMap.reserve(size);
-            m_objectMap.reserve(size);
+            m_bucketPositions.reserve(size);
+            m_idIndex.reserve(size);
+            m_ptrIndex.reserve(size);
         }
 
         bool JDObjectContainer::addObject(JDObjectManager* obj)
         {
-            if (!obj)
-                return false;
-            const JDObjectIDptr id = obj->getID();
-            auto it = m_objectMap.find(id->get());
-            if (it != m_objectMap.end())
-            {
-               /* if (it->second == obj)
-                {
-                    // Object already added
-                    return false;
-                }
-                else
-                {
-                    // ID already taken for a different instance
-                    return false;
-                }*/
+            if (!addObject_internal(obj))
                 return false;
-            }
-            m_objectVector.emplace_back(obj);
-            m_objectMap[id->get()] = obj;
-            m_objectPtrMap[obj->getObject().get()] = obj;
+            ++m_version;
             return true;
         }
         bool JDObjectContainer::addObject(const std::vector<JDObjectManager*>& objs)
         {
             bool success = true;
-            m_objectVector.reserve(m_objectVector.size() + objs.size());
-            m_objectMap.reserve(m_objectMap.size() + objs.size());
-            m_objectPtrMap.reserve(m_objectPtrMap.size() + objs.size());
+            reserve(m_objectVector.size() + objs.size());
 
             for (auto it = objs.begin(); it != objs.end(); ++it)
             {
-                JDObjectManager* obj = *it;
-                if (!obj)
-                {
-                    success = false;
-                    continue;
-                }
-
-                JDObjectIDptr id = obj->getID();
-                auto it2 = m_objectMap.find(id->get());
-                if (it2 != m_objectMap.end())
-                {
-                    success = false;
-                    // Object already added
-                   /* if (it2->second == obj)
-                    {
-                        // Object already added
-                    }
-                    else
-                    {
-                        // ID already taken for a different instance
-                    }*/
-                    continue;
-                }
-                m_objectVector.emplace_back(obj);
-                m_objectMap[id->get()] = obj;
-                m_objectPtrMap[obj->getObject().get()] = obj;
+                success &= addObject_internal(*it);
             }
+            ++m_version;
             return success;
         }
         /*JDObject JDObjectContainer::replaceObject(const JDObject& replacement)
@@ -122,32 +72,20 @@ namespace JsonDatabase
         }*/
         JDObjectManager* JDObjectContainer::getAndRemoveObject(const JDObjectIDptr& id)
         {
-            auto it = m_objectMap.find(id->get());
-            if (it != m_objectMap.end())
-            {
-                JDObjectManager *manager = it->second;
-                auto it2 = std::find(m_objectVector.begin(), m_objectVector.end(), it->second);
-
-                m_objectVector.erase(it2);
-                m_objectPtrMap.erase(it->second->getObject().get());
-                m_objectMap.erase(it);
-                return manager;
-            }
-            return nullptr;
+            size_t slot = m_idIndex.find(id->get());
+            if (slot == m_idIndex.npos)
+                return nullptr;
+            JDObjectManager* manager = m_objectVector[slot];
+            removeSlot(slot);
+            return manager;
         }
         bool JDObjectContainer::removeObject(const JDObjectIDptr& id)
         {
-            auto it = m_objectMap.find(id->get());
-            if (it != m_objectMap.end())
-            {
-                auto it2 = std::find(m_objectVector.begin(), m_objectVector.end(), it->second);
-
-                m_objectVector.erase(it2);
-                m_objectPtrMap.erase(it->second->getObject().get());
-                m_objectMap.erase(it);
-                return true;
-            }
-            return false;
+            size_t slot = m_idIndex.find(id->get());
+            if (slot == m_idIndex.npos)
+                return false;
+            removeSlot(slot);
+            return true;
         }
         bool JDObjectContainer::removeObject(JDObjectManager *obj)
         {
@@ -171,59 +109,37 @@ namespace JsonDatabase
 
         JDObjectManager* JDObjectContainer::getObjectByID(const JDObjectIDptr& id) const
         {
-            auto it = m_objectMap.find(id->get());
-            if (it != m_objectMap.end())
-            {
-                return it->second;
-            }
-            return nullptr;
+            return getObjectByID(id->get());
         }
         JDObjectManager* JDObjectContainer::getObjectByID(const JDObjectID::IDType& id) const
         {
-            auto it = m_objectMap.find(id);
-            if (it != m_objectMap.end())
-            {
-                return it->second;
-            }
-            return nullptr;
+            size_t slot = m_idIndex.find(id);
+            if (slot == m_idIndex.npos)
+                return nullptr;
+            return m_objectVector[slot];
         }
         JDObjectManager* JDObjectContainer::getObjectByPtr(JDObjectInterface* obj) const
         {
-            auto it = m_objectPtrMap.find(obj);
-            if (it != m_objectPtrMap.end())
-            {
-                return it->second;
-            }
-            return nullptr;
+            size_t slot = m_ptrIndex.find(obj);
+            if (slot == m_ptrIndex.npos)
+                return nullptr;
+            return m_objectVector[slot];
         }
 
         const std::vector<JDObjectManager*>& JDObjectContainer::getAllObjects() const
         {
             return m_objectVector;
         }
-        const std::unordered_map<JDObjectID::IDType, JDObjectManager*>& JDObjectContainer::getAllObjectsIDMap() const
-        {
-            return m_objectMap;
-        }
-        const std::unordered_map<JDObjectInterface*, JDObjectManager*>& JDObjectContainer::getAllObjectsPtrMap() const
-        {
-            return m_objectPtrMap;
-        }
 
         bool JDObjectContainer::exists(const JDObjectIDptr& id) const
         {
-            auto it = m_objectMap.find(id->get());
-            if (it != m_objectMap.end())
-            {
-                return true;
-            }
-            return false;
+            return m_idIndex.find(id->get()) != m_idIndex.npos;
         }
         bool JDObjectContainer::exists(const JDObject& obj) const
         {
             if (!obj.get())
                 return false;
-            return m_objectPtrMap.find(obj.get()) != m_objectPtrMap.end();
+            return m_ptrIndex.find(obj.get()) != m_ptrIndex.npos;
         }
         bool JDObjectContainer::exists(JDObjectManager* obj) const
         {
@@ -237,8 +153,34 @@ namespace JsonDatabase
         void JDObjectContainer::clear()
         {
             m_objectVector.clear();
-            m_objectMap.clear();
-            m_objectPtrMap.clear();
+            m_bucketPositions.clear();
+            m_idIndex.clear();
+            m_ptrIndex.clear();
+            m_typeBuckets.clear();
+            m_classNameToType.clear();
+            ++m_version;
+        }
+        const JDObjectContainer::TypeBucket* JDObjectContainer::getTypeBucket(const std::type_index& type) const
+        {
+            auto it = m_typeBuckets.find(type);
+            if (it != m_typeBuckets.end())
+                return &it->second;
+            return nullptr;
+        }
+        const JDObjectContainer::TypeBucket* JDObjectContainer::getClassBucket(const std::string& className) const
+        {
+            auto it = m_classNameToType.find(className);
+            if (it != m_classNameToType.end())
+                return getTypeBucket(it->second);
+            return nullptr;
+        }
+        const std::unordered_map<std::type_index, JDObjectContainer::TypeBucket>& JDObjectContainer::getTypeBuckets() const
+        {
+            return m_typeBuckets;
+        }
+        unsigned long long JDObjectContainer::getVersion() const
+        {
+            return m_version.load();
         }
 
         JDObjectContainer::iterator JDObjectContainer::begin()
@@ -260,5 +202,110 @@ namespace JsonDatabase
         {
             return m_objectVector.end();
         }
+
+        bool JDObjectContainer::isConsistent() const
+        {
+            size_t count = m_objectVector.size();
+            if (m_bucketPositions.size() != count || m_idIndex.size() != count || m_ptrIndex.size() != count)
+                return false;
+            size_t bucketObjects = 0;
+            for (const auto& bucket : m_typeBuckets)
+                bucketObjects += bucket.second.objects.size();
+            if (bucketObjects != count)
+                return false;
+
+            for (size_t slot = 0; slot < count; ++slot)
+            {
+                JDObjectManager* obj = m_objectVector[slot];
+                if (m_idIndex.find(obj->getID()->get()) != slot || m_ptrIndex.find(obj->getObject().get()) != slot)
+                    return false;
+                const JDObjectInterface* instance = obj->getObject().get();
+                auto it = m_typeBuckets.find(std::type_index(typeid(*instance)));
+                if (it == m_typeBuckets.end())
+                    return false;
+                const std::vector<JDObjectManager*>& objects = it->second.objects;
+                if (m_bucketPositions[slot] >= objects.size() || objects[m_bucketPositions[slot]] != obj)
+                    return false;
+            }
+            return true;
+        }
+
+        bool JDObjectContainer::addObject_internal(JDObjectManager* obj)
+        {
+            if (!obj)
+                return false;
+            size_t slot = m_objectVector.size();
+            // Fails if the ID is already taken
+            if (!m_idIndex.insert(obj->getID()->get(), slot))
+                return false;
+            if (!m_ptrIndex.insert(obj->getObject().get(), slot))
+            {
+                // Same instance with a different ID
+                m_idIndex.erase(obj->getID()->get());
+                return false;
+            }
+            m_objectVector.emplace_back(obj);
+            m_bucketPositions.emplace_back(0);
+            addToTypeBucket(slot);
+            return true;
+        }
+        void JDObjectContainer::removeSlot(size_t slot)
+        {
+            JDObjectManager* obj = m_objectVector[slot];
+            removeFromTypeBucket(slot);
+            m_idIndex.erase(obj->getID()->get());
+            m_ptrIndex.erase(obj->getObject().get());
+
+            // Fill the gap with the last slot
+            size_t last = m_objectVector.size() - 1;
+            if (slot != last)
+            {
+                JDObjectManager* moved = m_objectVector[last];
+                m_objectVector[slot] = moved;
+                m_bucketPositions[slot] = m_bucketPositions[last];
+                m_idIndex.update(moved->getID()->get(), slot);
+                m_ptrIndex.update(moved->getObject().get(), slot);
+            }
+            m_objectVector.pop_back();
+            m_bucketPositions.pop_back();
+            ++m_version;
+        }
+        void JDObjectContainer::addToTypeBucket(size_t slot)
+        {
+            JDObjectInterface* instance = m_objectVector[slot]->getObject().get();
+            std::type_index type(typeid(*instance));
+            auto it = m_typeBuckets.find(type);
+            if (it == m_typeBuckets.end())
+            {
+                TypeBucket bucket;
+                bucket.className = instance->className();
+                it = m_typeBuckets.emplace(type, std::move(bucket)).first;
+                m_classNameToType.emplace(it->second.className, type);
+            }
+            m_bucketPositions[slot] = it->second.objects.size();
+            it->second.objects.push_back(m_objectVector[slot]);
+        }
+        void JDObjectContainer::removeFromTypeBucket(size_t slot)
+        {
+            JDObjectInterface* instance = m_objectVector[slot]->getObject().get();
+            auto it = m_typeBuckets.find(std::type_index(typeid(*instance)));
+            if (it == m_typeBuckets.end())
+                return;
+
+            // Swap remove, the position of the moved object has to be updated
+            std::vector<JDObjectManager*>& objects = it->second.objects;
+            size_t position = m_bucketPositions[slot];
+            JDObjectManager* moved = objects.back();
+            objects[position] = moved;
+            objects.pop_back();
+            if (moved != m_objectVector[slot])
+                m_bucketPositions[m_ptrIndex.find(moved->getObject().get())] = position;
+
+            if (objects.size() == 0)
+            {
+                m_classNameToType.erase(it->second.className);
+                m_typeBuckets.erase(it);
+            }
+        }
     }
-}
\ No newline at end of file
+}
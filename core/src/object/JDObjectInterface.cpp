@@ -3,6 +3,7 @@
 #include "object/JDObjectManager.h"
 #include "ui/JDObjectListWidget.h"
 #include "changehistory/ChangeTransaction.h"
+#include "changehistory/ChangeHistoryScope.h"
 #include "utilities/ResourceManager.h"
 
 
@@ -32,30 +33,40 @@ int JDObjectInterface::AutoObjectAddToRegistry::addToRegistry(JDObject obj)
 JDObjectInterface::JDObjectInterface()
     : m_manager(nullptr)
     , m_shallowID(JDObjectID::invalidID)
+    , m_dirtyMask(0)
 {
 	//markAsChanged();
 	m_hasBeenSaved = false;
     m_marketdForRemoval = false;
     markAsCorrectData();
-    std::shared_ptr<IChangeTransaction> change = std::make_shared<ChangeTransaction>("ObjectInstantiation", "Object instantiated");
-    m_changeHistory.push_back(change);
+    recordInstantiation();
 }
 
 JDObjectInterface::JDObjectInterface(const JDObjectInterface &other)
     : m_manager(nullptr)
     , m_shallowID(other.m_shallowID)
+    , m_dirtyMask(0)
 {
 	//markAsChanged();
 	m_hasBeenSaved = false;
     m_marketdForRemoval = false;
     markAsCorrectData();
-    std::shared_ptr<IChangeTransaction> change = std::make_shared<ChangeTransaction>("ObjectInstantiation", "Object instantiated");
-    m_changeHistory.push_back(change);
+    recordInstantiation();
 }
 JDObjectInterface::~JDObjectInterface()
 {
 
 }
+void JDObjectInterface::recordInstantiation()
+{
+    // The object has no manager yet, only a scope can turn the history off
+    ChangeHistoryMode mode;
+    size_t ringBufferSize;
+    if (ChangeHistoryScope::getCurrentMode(mode, ringBufferSize) && mode == ChangeHistoryMode::off)
+        return;
+    std::shared_ptr<IChangeTransaction> change = std::make_shared<ChangeTransaction>("ObjectInstantiation", "Object instantiated");
+    m_changeHistory.push_back(change);
+}
 
 JDObject JDObjectInterface::deepClone() const
 {
@@ -268,16 +279,19 @@ bool JDObjectInterface::hasChanges() const
 {
     if (!m_hasBeenSaved || m_marketdForRemoval)
         return true;
-	bool hasChanges = false;
-	for (auto value : m_values)
-	{
-		if (value->hasChanged())
-		{
-			hasChanges = true;
-			break;
-		}
-	}
-	return hasChanges;
+	return m_dirtyMask.load(std::memory_order_relaxed) != 0;
+}
+unsigned long long JDObjectInterface::getDirtyMask() const
+{
+    return m_dirtyMask.load(std::memory_order_relaxed);
+}
+bool JDObjectInterface::isValueDirty(const IJDObjectValue& value) const
+{
+    if (value.m_parent != this)
+        return false;
+    if (value.m_valueIndex < 63)
+        return (m_dirtyMask.load(std::memory_order_relaxed) & getDirtyBit(value.m_valueIndex)) != 0;
+    return value.hasChanged();
 }
 void JDObjectInterface::onValueChanged(IJDObjectValue* value) const
 {
@@ -418,7 +432,32 @@ bool JDObjectInterface::getSaveData(JsonObject& obj) const
 void JDObjectInterface::addValue(IJDObjectValue& value)
 {
 	value.setParent(this);
+	value.m_valueIndex = m_values.size();
 	m_values.push_back(&value);
+	// A copied value may already differ from its original value
+	if (value.hasChanged())
+		setValueDirty(&value, true);
+}
+void JDObjectInterface::setValueDirty(const IJDObjectValue* value, bool dirty) const
+{
+    unsigned long long bit = getDirtyBit(value->m_valueIndex);
+    if (!dirty && value->m_valueIndex >= 63)
+    {
+        // The last bit is shared, it stays set as long as one of the other values is changed
+        for (size_t i = 63; i < m_values.size(); ++i)
+            if (m_values[i] != value && m_values[i]->hasChanged())
+                return;
+    }
+    if (dirty)
+        m_dirtyMask.fetch_or(bit, std::memory_order_relaxed);
+    else
+        m_dirtyMask.fetch_and(~bit, std::memory_order_relaxed);
+}
+unsigned long long JDObjectInterface::getDirtyBit(size_t valueIndex)
+{
+    if (valueIndex > 63)
+        valueIndex = 63;
+    return 1ull << valueIndex;
 }
 
 void JDObjectInterface::setManager(Internal::JDObjectManager* manager)
@@ -20,6 +20,7 @@ namespace JsonDatabase
 			, m_id(id)
 			, m_lockstate(Lockstate::unlocked)
 			, m_changestate(ChangeState::unchanged)
+			, m_contentHash(0)
 		{
 			JD_UNUSED(parentLogger);
 			//if(parentLogger)
@@ -264,6 +265,45 @@ namespace JsonDatabase
 			}
 		}
 
+		ChangeHistoryMode JDObjectManager::getChangeHistoryMode(size_t& ringBufferSizeOut) const
+		{
+			if (!m_databaseManager)
+			{
+				ringBufferSizeOut = 0;
+				return ChangeHistoryMode::full;
+			}
+			ringBufferSizeOut = m_databaseManager->getChangeHistoryRingBufferSize();
+			return m_databaseManager->getChangeHistoryMode();
+		}
+
+		unsigned long long JDObjectManager::getContentHash(const JsonObject& json)
+		{
+			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_4);
+			auto it = json.find(JDObjectInterface::s_tag_data);
+			if (it == json.end())
+				return 0;
+			const JsonObject* data = it->second.get_if<JsonObject>();
+			if (!data)
+				return 0;
+			unsigned long long hash = JsonValue::getHash(*data);
+			// 0 is reserved for "no hash known"
+			if (hash == 0)
+				hash = 1;
+			return hash;
+		}
+		void JDObjectManager::setContentHash(unsigned long long hash)
+		{
+			m_contentHash.store(hash);
+		}
+		void JDObjectManager::clearContentHash()
+		{
+			m_contentHash.store(0);
+		}
+		bool JDObjectManager::hasContentHash(unsigned long long hash) const
+		{
+			return hash != 0 && m_contentHash.load() == hash;
+		}
+
 		const std::string& JDObjectManager::managedLoadStatusToString(ManagedLoadStatus status)
 		{
 			
@@ -314,7 +354,17 @@ namespace JsonDatabase
 			JD_UNUSED(logger);
 			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
 			JDObject obj = manager->getObject();
-			bool hasChanged = !obj->equalData(json);
+			unsigned long long contentHash = getContentHash(json);
+			bool hasChanged;
+			// Same data as at the last load or save, no need to serialize the object to compare it
+			if (manager->hasContentHash(contentHash) && !obj->hasChanges())
+				hasChanged = false;
+			else
+			{
+				hasChanged = !obj->equalData(json);
+				if (!hasChanged)
+					manager->setContentHash(contentHash);
+			}
 			if (!loadMode.changedObjects)
 				return ManagedLoadStatus::noLoadNeeded;
 			if (hasChanged)
@@ -322,7 +372,7 @@ namespace JsonDatabase
 				//if (loadMode.overridingObjects)
 				//{
 					
-					if (!manager->loadAndOverrideData(json))
+					if (!manager->deserializeOverrideFromJson_internal(json, obj, contentHash, loadMode.ownLocks))
 						return ManagedLoadStatus::loadFailed;
 
 					containers.overridingObjs.push_back(obj);
@@ -366,6 +416,7 @@ namespace JsonDatabase
 			instance->loadInternal(json);
 			containers.newObjIDs.push_back(misc.id);
 			containers.newObjInstances.push_back(instance);
+			containers.newObjHashes.push_back(getContentHash(json));
 
 			return ManagedLoadStatus::success;
 		}
@@ -439,11 +490,17 @@ namespace JsonDatabase
 			return true;
 		}
 		bool JDObjectManager::deserializeOverrideFromJson_internal(const JsonObject& json, JDObject obj)
+		{
+			return deserializeOverrideFromJson_internal(json, obj, getContentHash(json), nullptr);
+		}
+		bool JDObjectManager::deserializeOverrideFromJson_internal(const JsonObject& json, JDObject obj, unsigned long long contentHash,
+																   const JDObjectLocker::OwnLocks* ownLocks)
 		{
 			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
 			if (obj->hasChanges())
 			{
-				if (obj->isLockedByMe())
+				bool lockedByMe = ownLocks ? ownLocks->covers(obj->getObjectID()->get(), obj->className()) : obj->isLockedByMe();
+				if (lockedByMe)
 				{
 					if (m_logger)m_logger->logError("Can't load data in object: " + obj->getObjectID().get()->toString() + " classType: " + obj->className() + " Object is locked by this user and has unsaved changes");
 					return false;
@@ -452,10 +509,12 @@ namespace JsonDatabase
 			if (!obj->loadInternal(json))
 			{
 				if (m_logger)m_logger->logError("Can't load data in object: " + obj->getObjectID().get()->toString() + " classType: " + obj->className());
+				clearContentHash();
 				return false;
 			}
-			if(m_databaseManager)
-				m_databaseManager->m_signalsToEmit.addObjectChanged(obj);
+			if (obj == m_obj)
+				setContentHash(contentHash);
+			// The changed signal gets collected by the loader, this may run on multiple threads
 			return true;
 		}
 	}
@@ -1,25 +1,92 @@
 #include "object/value/IJDObjectValue.h"
 #include "object/JDObjectInterface.h"
+#include "object/JDObjectManager.h"
+#include "changehistory/ChangeHistoryScope.h"
+#include <algorithm>
 
 namespace JsonDatabase
 {
 
+	std::vector<std::shared_ptr<IChangeTransaction>> IJDObjectValue::getValueChangeTransactions() const
+	{
+		std::vector<std::shared_ptr<IChangeTransaction>> history;
+		history.reserve(m_changeHistory.size());
+		history.insert(history.end(), m_changeHistory.begin() + m_historyStart, m_changeHistory.end());
+		history.insert(history.end(), m_changeHistory.begin(), m_changeHistory.begin() + m_historyStart);
+		return history;
+	}
 	void IJDObjectValue::clearValueChangeTransactions()
 	{
 		m_changeHistory.clear();
+		m_historyStart = 0;
 		if (m_parent)
+		{
+			m_parent->setValueDirty(this, false);
 			m_parent->onValueChanged(this);
+		}
+	}
+
+	ChangeHistoryMode IJDObjectValue::getChangeHistoryMode(size_t& historyLimitOut) const
+	{
+		ChangeHistoryMode mode = ChangeHistoryMode::full;
+		size_t ringBufferSize = 0;
+		if (!ChangeHistoryScope::getCurrentMode(mode, ringBufferSize))
+		{
+			Internal::JDObjectManager* manager = m_parent ? m_parent->getManager() : nullptr;
+			if (manager)
+				mode = manager->getChangeHistoryMode(ringBufferSize);
+		}
+		historyLimitOut = (mode == ChangeHistoryMode::ringBuffer) ? ringBufferSize : 0;
+		return mode;
 	}
 
-	void IJDObjectValue::onValueChange(std::shared_ptr<IChangeTransaction> change)
+	void IJDObjectValue::onValueChange(std::shared_ptr<IChangeTransaction> change, size_t historyLimit)
 	{
 		if (hasChanged())
 		{
-			m_changeHistory.push_back(change);
+			if (change)
+			{
+				if (historyLimit && m_changeHistory.size() >= historyLimit)
+				{
+					// Only needed if the limit got smaller since the last change
+					if (m_changeHistory.size() > historyLimit)
+					{
+						linearizeHistory();
+						m_changeHistory.erase(m_changeHistory.begin(), m_changeHistory.begin() + (m_changeHistory.size() - historyLimit));
+					}
+					// The new change overwrites the oldest one
+					m_changeHistory[m_historyStart] = std::move(change);
+					m_historyStart = (m_historyStart + 1) % historyLimit;
+				}
+				else
+				{
+					if (m_historyStart)
+						linearizeHistory();
+					m_changeHistory.push_back(std::move(change));
+				}
+			}
 			if (m_parent)
+			{
+				m_parent->setValueDirty(this, true);
 				m_parent->onValueChanged(this);
+			}
 		}
 		else
 			clearValueChangeTransactions();
 	}
+
+	std::shared_ptr<IChangeTransaction> IJDObjectValue::getRecyclableTransaction(size_t historyLimit) const
+	{
+		if (!historyLimit || m_changeHistory.size() != historyLimit)
+			return nullptr;
+		const std::shared_ptr<IChangeTransaction>& oldest = m_changeHistory[m_historyStart];
+		if (oldest.use_count() != 1)
+			return nullptr;
+		return oldest;
+	}
+	void IJDObjectValue::linearizeHistory()
+	{
+		std::rotate(m_changeHistory.begin(), m_changeHistory.begin() + m_historyStart, m_changeHistory.end());
+		m_historyStart = 0;
+	}
 }
\ No newline at end of file
@@ -26,6 +26,8 @@ namespace JsonDatabase
 				return "Object not locked";
 			case Error::objectAlreadyLocked:
 				return "Object already locked";
+			case Error::objectLockBatchAborted:
+				return "Object not locked, another object of the all or nothing batch could not be locked";
 
 			case Error::unableToCreateOrOpenLockFile:
 				return "Unable to create or open lock file";
@@ -45,6 +47,8 @@ namespace JsonDatabase
 				return "File lock timeout";
 			case Error::fileNotLocked:
 				return "File not locked";
+			case Error::fileLockQueuedBehindWriter:
+				return "File lock queued behind a waiting writer";
 
 			case Error::cantOpenFileForRead:
 				return "Can't open file for read";
@@ -0,0 +1,235 @@
+#include "utilities/JDLeaseManager.h"
+#include "utilities/JDUniqueMutexLock.h"
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+namespace JsonDatabase
+{
+	namespace Utilities
+	{
+		const std::string JDLeaseManager::s_leaseFileEnding = ".lease";
+		unsigned int JDLeaseManager::s_heartbeatIntervalMs = 2000;
+		unsigned int JDLeaseManager::s_leaseTimeoutMs = 15000;
+
+		JDLeaseManager::JDLeaseManager()
+			: m_heartbeat(0)
+			, m_thread(nullptr)
+			, m_stopFlag(false)
+			, m_renewalPaused(false)
+			, m_leaseLost(false)
+		{
+
+		}
+		JDLeaseManager::~JDLeaseManager()
+		{
+			stop();
+			delete m_logger;
+		}
+
+		void JDLeaseManager::setParentLogger(Log::LogObject* parentLogger)
+		{
+			if (parentLogger)
+			{
+				if (m_logger)
+					delete m_logger;
+				m_logger = new Log::LogObject(*parentLogger, "Lease manager");
+			}
+		}
+
+		bool JDLeaseManager::start(const std::string& leaseDirectory, const std::string& sessionID)
+		{
+			stop();
+			m_leaseDirectory = leaseDirectory;
+			m_sessionID = sessionID;
+			m_heartbeat = 0;
+			m_observedLeases.clear();
+			m_leaseLost.store(false);
+
+			std::error_code ec;
+			std::filesystem::create_directories(m_leaseDirectory, ec);
+			if (!renewLease())
+			{
+				if (m_logger)m_logger->logError("Can't create the lease for session: " + m_sessionID);
+				return false;
+			}
+
+			m_stopFlag.store(false);
+			m_thread = new std::thread(&JDLeaseManager::threadLoop, this);
+			return true;
+		}
+		void JDLeaseManager::stop()
+		{
+			if (!m_thread)
+				return;
+			{
+				JDM_UNIQUE_LOCK_M(m_threadMutex);
+				m_stopFlag.store(true);
+				m_cv.notify_all();
+			}
+			m_thread->join();
+			delete m_thread;
+			m_thread = nullptr;
+
+			// Clean log off, the lease does not have to expire
+			std::error_code ec;
+			std::filesystem::remove(getLeaseFilePath(m_sessionID), ec);
+		}
+		bool JDLeaseManager::isRunning() const
+		{
+			return m_thread != nullptr;
+		}
+
+		const std::string& JDLeaseManager::getSessionID() const
+		{
+			return m_sessionID;
+		}
+
+		std::vector<std::string> JDLeaseManager::takeExpiredSessions()
+		{
+			JDM_UNIQUE_LOCK_M(m_expiredMutex);
+			std::vector<std::string> expired;
+			expired.swap(m_expiredSessions);
+			return expired;
+		}
+		bool JDLeaseManager::takeLeaseLost()
+		{
+			return m_leaseLost.exchange(false);
+		}
+		void JDLeaseManager::setExpiredCallback(const std::function<void()>& callback)
+		{
+			JDM_UNIQUE_LOCK_M(m_expiredMutex);
+			m_expiredCallback = callback;
+		}
+
+		void JDLeaseManager::setRenewalPaused(bool paused)
+		{
+			m_renewalPaused.store(paused);
+		}
+		bool JDLeaseManager::isRenewalPaused() const
+		{
+			return m_renewalPaused.load();
+		}
+
+		void JDLeaseManager::setHeartbeatInterval(unsigned int ms)
+		{
+			s_heartbeatIntervalMs = ms;
+		}
+		unsigned int JDLeaseManager::getHeartbeatInterval()
+		{
+			return s_heartbeatIntervalMs;
+		}
+		void JDLeaseManager::setLeaseTimeout(unsigned int ms)
+		{
+			s_leaseTimeoutMs = ms;
+		}
+		unsigned int JDLeaseManager::getLeaseTimeout()
+		{
+			return s_leaseTimeoutMs;
+		}
+
+		void JDLeaseManager::threadLoop()
+		{
+			JD_PROFILING_THREAD(("JDLeaseManager " + m_sessionID).c_str());
+			while (!m_stopFlag.load())
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_threadMutex);
+					m_cv.wait_for(lock, std::chrono::milliseconds(s_heartbeatIntervalMs), [this] { return m_stopFlag.load(); });
+				}
+				if (m_stopFlag.load())
+					break;
+				if (!m_renewalPaused.load())
+					renewLease();
+				reapExpiredLeases();
+			}
+		}
+		bool JDLeaseManager::renewLease()
+		{
+			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			std::string filePath = getLeaseFilePath(m_sessionID);
+			if (m_heartbeat > 0 && !std::filesystem::exists(filePath))
+			{
+				// The manager has to log on again and restore the locks, the lease of this session is not renewed anymore
+				if (m_logger)m_logger->logWarning("The lease of this session was expired by another session, locks of this session may have been removed");
+				std::function<void()> callback;
+				{
+					JDM_UNIQUE_LOCK_M(m_expiredMutex);
+					m_leaseLost.store(true);
+					callback = m_expiredCallback;
+				}
+				if (callback)
+					callback();
+				return false;
+			}
+
+			std::ofstream file(filePath, std::ios::trunc);
+			if (!file.is_open())
+			{
+				if (m_logger)m_logger->logError("Can't renew the lease: " + filePath);
+				return false;
+			}
+			++m_heartbeat;
+			file << m_heartbeat;
+			return !file.fail();
+		}
+		void JDLeaseManager::reapExpiredLeases()
+		{
+			JD_GENERAL_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			std::chrono::milliseconds timeout(s_leaseTimeoutMs);
+
+			std::unordered_map<std::string, ObservedLease> observedLeases;
+			std::vector<std::string> expired;
+			std::error_code ec;
+			for (const auto& entry : std::filesystem::directory_iterator(m_leaseDirectory, ec))
+			{
+				if (!entry.is_regular_file() || entry.path().extension().string() != s_leaseFileEnding)
+					continue;
+				std::string sessionID = entry.path().stem().string();
+				if (sessionID == m_sessionID)
+					continue;
+
+				std::ifstream file(entry.path());
+				std::stringstream buffer;
+				buffer << file.rdbuf();
+				std::string content = buffer.str();
+
+				ObservedLease lease;
+				lease.content = content;
+				lease.lastChange = now;
+				const auto& it = m_observedLeases.find(sessionID);
+				if (it != m_observedLeases.end() && it->second.content == content)
+					lease.lastChange = it->second.lastChange;
+
+				if (now - lease.lastChange > timeout)
+				{
+					// Another session may have reaped it at the same time, removing it twice does no harm
+					std::error_code removeEc;
+					std::filesystem::remove(entry.path(), removeEc);
+					expired.push_back(sessionID);
+					if (m_logger)m_logger->logInfo("Lease of session: " + sessionID + " expired");
+					continue;
+				}
+				observedLeases[sessionID] = lease;
+			}
+			m_observedLeases = std::move(observedLeases);
+
+			if (expired.size() == 0)
+				return;
+			std::function<void()> callback;
+			{
+				JDM_UNIQUE_LOCK_M(m_expiredMutex);
+				m_expiredSessions.insert(m_expiredSessions.end(), expired.begin(), expired.end());
+				callback = m_expiredCallback;
+			}
+			if (callback)
+				callback();
+		}
+		std::string JDLeaseManager::getLeaseFilePath(const std::string& sessionID) const
+		{
+			return m_leaseDirectory + "\\" + sessionID + s_leaseFileEnding;
+		}
+	}
+}
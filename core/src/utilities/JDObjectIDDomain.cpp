@@ -1,4 +1,5 @@
 #include "utilities/JDObjectIDDomain.h"
+#include "utilities/JDUniqueMutexLock.h"
 #include <cstdlib> // For atoi, used to convert string to integer
 #include <ctime>   // For time, used for seeding random number generator
 #include <sstream> // For stringstream, used to convert integer to string
@@ -54,10 +55,23 @@ namespace JsonDatabase
 
 	const JDObjectID::IDType JDObjectIDDomain::s_startID = JDObjectID::defaultID;
 
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+	static bool insertUsedID(Internal::JDIDRangeSet<JDObjectID::IDType>& usedIDs, const JDObjectID::IDType& id)
+	{
+		return usedIDs.insert(id);
+	}
+#else
+	static bool insertUsedID(std::unordered_set<JDObjectID::IDType>& usedIDs, const JDObjectID::IDType& id)
+	{
+		return usedIDs.insert(id).second;
+	}
+#endif
+
 	JDObjectIDDomain::JDObjectIDDomain()
 		: m_name("")
 		, m_interface(std::shared_ptr<JDObjectIDDomainInterface>(new JDObjectIDDomainInterface(this)))
 		, m_nextID(s_startID)
+		, m_reservedCount(0)
 	{
 
 	};
@@ -65,6 +79,7 @@ namespace JsonDatabase
 		: m_name(name)
 		, m_interface(std::shared_ptr<JDObjectIDDomainInterface>(new JDObjectIDDomainInterface(this)))
 		, m_nextID(s_startID)
+		, m_reservedCount(0)
 	{
 
 	};
@@ -88,22 +103,38 @@ namespace JsonDatabase
 	JDObjectIDptr JDObjectIDDomain::getNewID()
 	{
 		JD_ID_DOMAIN_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-		auto it = m_usedIDs.find(m_nextID);
-
-		unsigned int counter = 1;
-		while(it != m_usedIDs.end())
+		JDObjectID::IDType newID;
+		bool reserved;
+		{
+			JDM_UNIQUE_LOCK_M(m_reserveMutex);
+			reserved = takeReservedID_internal(newID);
+		}
+		if (!reserved)
 		{
-			// Generate new ID until we find one that is not used
-			generateNextID(counter);
-			counter++;
-			it = m_usedIDs.find(m_nextID);
+			unsigned int counter = 1;
+			while (m_usedIDs.contains(m_nextID))
+			{
+				// Generate new ID until we find one that is not used
+				generateNextID(counter);
+				counter++;
+			}
+			newID = m_nextID;
+			generateNextID();
 		}
 
-		JDObjectIDptr id = JDObjectIDptr( new JDObjectID(m_nextID, JDObjectID::State::Valid, m_interface));
-		m_usedIDs[m_nextID] = id;
-		generateNextID();
+		JDObjectIDptr id = JDObjectIDptr( new JDObjectID(newID, JDObjectID::State::Valid, m_interface));
+		insertUsedID(m_usedIDs, newID);
 		return id;
 	}
+	std::vector<JDObjectIDptr> JDObjectIDDomain::getNewIDs(size_t count)
+	{
+		JD_ID_DOMAIN_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
+		std::vector<JDObjectIDptr> ids;
+		ids.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			ids.push_back(getNewID());
+		return ids;
+	}
 
 	
 
@@ -111,25 +142,13 @@ namespace JsonDatabase
 	{
 		JD_ID_DOMAIN_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
 
-		if(existing == JDObjectID::invalidID)
-			goto invalid;
-
-		{
-			auto it = m_usedIDs.find(existing);
-			if (it != m_usedIDs.end())
-				goto invalid;
-		}
-
+		if (existing == JDObjectID::invalidID || !insertUsedID(m_usedIDs, existing))
 		{
-			JDObjectIDptr id = JDObjectIDptr(new JDObjectID(existing, JDObjectID::State::Valid, m_interface));
-			m_usedIDs[existing] = id;
-			success = true;
-			return id;
+			success = false;
+			return nullptr;
 		}
-
-	    invalid:
-		success = false;
-		return nullptr;
+		success = true;
+		return JDObjectIDptr(new JDObjectID(existing, JDObjectID::State::Valid, m_interface));
 	}
 	std::vector<JDObjectIDptr> JDObjectIDDomain::getPredefinedIDs(const std::vector<JDObjectID::IDType>& existingIDs, bool& allSuccess)
 	{
@@ -137,56 +156,24 @@ namespace JsonDatabase
 		std::vector<JDObjectIDptr> ids;
 		allSuccess = true;
 
-
-		m_usedIDs.reserve(m_usedIDs.size() + existingIDs.size());
 		ids.reserve(existingIDs.size());
-		for (rsize_t i = 0; i < existingIDs.size(); ++i)
+		for (size_t i = 0; i < existingIDs.size(); ++i)
 		{
 			const JDObjectID::IDType& current = existingIDs[i];
-			if (current == JDObjectID::invalidID)
+			if (current == JDObjectID::invalidID || !insertUsedID(m_usedIDs, current))
 			{
 				allSuccess = false;
 				ids.push_back(nullptr);
 				continue;
 			}
-			else
-			{
-				auto it = m_usedIDs.find(current);
-				if (it != m_usedIDs.end())
-				{
-					allSuccess = false;
-					ids.push_back(nullptr);
-					continue;
-				}
-			}
-			JDObjectIDptr id = JDObjectIDptr(new JDObjectID(current, JDObjectID::State::Valid, m_interface));
-			m_usedIDs[current] = id;
-			ids.push_back(id);
+			ids.push_back(JDObjectIDptr(new JDObjectID(current, JDObjectID::State::Valid, m_interface)));
 		}
 		return ids;
 	}
-	JDObjectIDptr JDObjectIDDomain::getExistingID(const JDObjectID::IDType& existing) const
-	{
-		JD_ID_DOMAIN_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
-		if (existing == JDObjectID::invalidID)
-			return nullptr;
-
-		auto it = m_usedIDs.find(existing);
-		if (it != m_usedIDs.end())
-			return it->second;
-		return nullptr;
-	
-	}
 
 	bool JDObjectIDDomain::idExists(const JDObjectID::IDType& id) const
 	{
-		auto it = m_usedIDs.find(id);
-		if(it != m_usedIDs.end())
-		{
-			if (it->second)
-				return true;
-		}
-		return false;
+		return m_usedIDs.contains(id);
 	}
 	bool JDObjectIDDomain::idExists(const JDObjectIDptr& id) const
 	{
@@ -195,27 +182,110 @@ namespace JsonDatabase
 
 	bool JDObjectIDDomain::unregisterID(const JDObjectID::IDType& id)
 	{
-		auto it = m_usedIDs.find(id);
-		if (it != m_usedIDs.end())
+		return m_usedIDs.erase(id);
+	}
+	bool JDObjectIDDomain::unregisterID(JDObjectIDptr id)
+	{
+		if(id->m_domainInterface != m_interface)
+			return false; // ID does not belong to this domain
+
+		if (!unregisterID(id->get()))
+			return false;
+		id->m_isValid = JDObjectID::State::Invalid;
+		id->m_id = JDObjectID::invalidID;
+		return true;
+	}
+
+	void JDObjectIDDomain::addReservedRange(const JDObjectID::IDType& first, const JDObjectID::IDType& last)
+	{
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+		if (first == JDObjectID::invalidID || last < first)
+			return;
+		JDM_UNIQUE_LOCK_M(m_reserveMutex);
+		m_reservedRanges.emplace_back(first, last);
+		m_reservedCount += static_cast<size_t>(last - first) + 1;
+#else
+		JD_UNUSED(first);
+		JD_UNUSED(last);
+#endif
+	}
+	bool JDObjectIDDomain::getReservedIDs(size_t count, std::vector<JDObjectIDptr>& idsOut)
+	{
+		JD_ID_DOMAIN_PROFILING_FUNCTION(JD_COLOR_STAGE_1);
+		idsOut.clear();
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+		std::vector<JDObjectID::IDType> taken;
+		taken.reserve(count);
 		{
-			if (it->second)
+			JDM_UNIQUE_LOCK_M(m_reserveMutex);
+			JDObjectID::IDType id;
+			while (taken.size() < count && takeReservedID_internal(id))
+				taken.push_back(id);
+			if (taken.size() < count)
 			{
-				it->second->m_isValid = JDObjectID::State::Invalid;
-				it->second->m_id = JDObjectID::invalidID;
-				it->second = nullptr;
-				m_usedIDs.erase(it);
-				return true;	
+				// Give the IDs back in their order, they stay reserved for this session
+				for (auto it = taken.rbegin(); it != taken.rend(); ++it)
+					m_reservedRanges.emplace_front(*it, *it);
+				m_reservedCount += taken.size();
+				return false;
 			}
 		}
+		idsOut.reserve(count);
+		for (const JDObjectID::IDType& id : taken)
+		{
+			insertUsedID(m_usedIDs, id);
+			idsOut.push_back(JDObjectIDptr(new JDObjectID(id, JDObjectID::State::Valid, m_interface)));
+		}
+		return true;
+#else
+		// IDs which are not numbers can't be reserved
+		return count == 0;
+#endif
+	}
+	size_t JDObjectIDDomain::getReservedIDCount() const
+	{
+		JDM_UNIQUE_LOCK_M(m_reserveMutex);
+		return m_reservedCount;
+	}
+	void JDObjectIDDomain::clearReservedRanges()
+	{
+		JDM_UNIQUE_LOCK_M(m_reserveMutex);
+		m_reservedRanges.clear();
+		m_reservedCount = 0;
+	}
+	bool JDObjectIDDomain::getHighestUsedID(JDObjectID::IDType& idOut) const
+	{
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+		return m_usedIDs.getMax(idOut);
+#else
+		JD_UNUSED(idOut);
 		return false;
+#endif
 	}
-	bool JDObjectIDDomain::unregisterID(JDObjectIDptr id)
+	bool JDObjectIDDomain::takeReservedID_internal(JDObjectID::IDType& idOut)
 	{
-		if(id->m_domainInterface != m_interface)
-			return false; // ID does not belong to this domain
-
-		bool success = unregisterID(id->get());
-		return success;
+#if JD_ID_TYPE_SWITCH == JD_ID_TYPE_LONG
+		while (m_reservedRanges.size())
+		{
+			std::pair<JDObjectID::IDType, JDObjectID::IDType>& range = m_reservedRanges.front();
+			JDObjectID::IDType id = range.first;
+			if (range.first == range.second)
+				m_reservedRanges.pop_front();
+			else
+				++range.first;
+			--m_reservedCount;
+			// The ID may have been loaded from the database in the meantime
+			if (!m_usedIDs.contains(id))
+			{
+				idOut = id;
+				return true;
+			}
+		}
+		return false;
+#else
+		JD_UNUSED(idOut);
+		return false;
+#endif
 	}
 
 
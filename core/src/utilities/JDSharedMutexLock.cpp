@@ -0,0 +1,28 @@
+#include "utilities/JDSharedMutexLock.h"
+
+namespace JsonDatabase
+{
+	namespace Internal
+	{
+		JDSharedMutexLock::JDSharedMutexLock(std::shared_mutex& mutex, bool exclusive)
+			: m_mutex(mutex)
+			, m_exclusive(exclusive)
+		{
+			JD_MUTEX_PROFILING_NONSCOPED_BLOCK("Mutex try get lock", JD_COLOR_STAGE_8);
+			if (m_exclusive)
+				m_mutex.lock();
+			else
+				m_mutex.lock_shared();
+			JD_MUTEX_PROFILING_END_BLOCK;
+			JD_MUTEX_PROFILING_NONSCOPED_BLOCK("Mutex locked", JD_COLOR_STAGE_10);
+		}
+		JDSharedMutexLock::~JDSharedMutexLock()
+		{
+			if (m_exclusive)
+				m_mutex.unlock();
+			else
+				m_mutex.unlock_shared();
+			JD_MUTEX_PROFILING_END_BLOCK;
+		}
+	}
+}
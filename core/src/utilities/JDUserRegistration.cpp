@@ -155,6 +155,17 @@ namespace JsonDatabase
 			return AbstractRegistry::removeInactiveObjects();
 		}
 
+		int JDUserRegistration::unregisterSessions(const std::vector<std::string>& sessionIDs)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_3);
+			if (sessionIDs.size() == 0)
+				return 0;
+			if (!AbstractRegistry::openRegistryFile(m_registryOpenTimeoutMs))
+				return 0;
+			AbstractRegistry::AutoClose autoClose(this);
+			return AbstractRegistry::removeForeignObjects(sessionIDs);
+		}
+
 		bool JDUserRegistration::checkForUserChange(std::vector<JDUser>& loggedOnUsers, std::vector<JDUser>& loggedOffUsers) const
 		{
 			std::vector<JDUser> currentUsers = getRegisteredUsers();
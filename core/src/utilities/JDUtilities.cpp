@@ -8,6 +8,7 @@ namespace JsonDatabase
 {
 	namespace Utilities
 	{
+#ifdef _WIN32
 		std::string getLastErrorString(DWORD error)
 		{
 			std::string errorString;
@@ -24,6 +25,7 @@ namespace JsonDatabase
 			LocalFree(messageBuffer);
 			return errorString;
 		}
+#endif
 
 		std::string JSON_DATABASE_API calculateMD5Hash(const std::string& filePath, Log::LogObject* logger, bool& success)
 		{
@@ -1,17 +1,29 @@
 #include "utilities/filesystem/AbstractRegistry.h"
 #include "utilities/JDSerializable.h"
+#include "Json/JsonSerializer.h"
+#include "Json/JsonDeserializer.h"
 #include <QDir>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
 
 namespace JsonDatabase
 {
 	namespace Utilities
 	{
+		AbstractRegistry::LockMode AbstractRegistry::s_defaultLockMode = AbstractRegistry::LockMode::lockFilePerObject;
+		size_t AbstractRegistry::s_minCompactionLogSize = 64 * 1024;
+		const std::string AbstractRegistry::LogKeys::add = "add";
+		const std::string AbstractRegistry::LogKeys::remove = "remove";
+
 		AbstractRegistry::AbstractRegistry()
 			: m_databasePath("")
 			, m_registrationName("registry")
 			, m_registrationFileEnding(".json")
 			, m_fileLocksPath("locks")
 			, m_registryFile(nullptr)
+			, m_rangeLock(nullptr)
+			, m_lockMode(s_defaultLockMode)
 			, m_nameSet(false)
 			, m_databasePathSet(false)
 		{
@@ -24,10 +36,45 @@ namespace JsonDatabase
 				AbstractRegistry::AutoClose autoClose(this);
 				removeAllSelfOwnedObjects();
 			}
-			
+			closeRangeLock();
 			delete m_registryFile;
 		}
 
+		bool AbstractRegistry::setLockMode(LockMode mode)
+		{
+			if (m_lockMode == mode)
+				return true;
+			if (getSelfLockCount() > 0)
+			{
+				if (m_logger)
+					m_logger->logError("Can't change the lock mode while locks are owned");
+				return false;
+			}
+			closeRangeLock();
+			m_lockMode = mode;
+			return true;
+		}
+		AbstractRegistry::LockMode AbstractRegistry::getLockMode() const
+		{
+			return m_lockMode;
+		}
+		void AbstractRegistry::setDefaultLockMode(LockMode mode)
+		{
+			s_defaultLockMode = mode;
+		}
+		AbstractRegistry::LockMode AbstractRegistry::getDefaultLockMode()
+		{
+			return s_defaultLockMode;
+		}
+		void AbstractRegistry::setMinCompactionLogSize(size_t bytes)
+		{
+			s_minCompactionLogSize = bytes;
+		}
+		size_t AbstractRegistry::getMinCompactionLogSize()
+		{
+			return s_minCompactionLogSize;
+		}
+
 		void AbstractRegistry::setParentLogger(Log::LogObject* parentLogger, const std::string& registryName)
 		{
 			if(parentLogger)
@@ -54,7 +101,7 @@ namespace JsonDatabase
 					{
 						JsonObject& obj = backup[i].get<JsonObject>();
 						std::string key = LockEntryObject::getKey(obj);
-						if (m_fileLocks.find(key) != m_fileLocks.end())
+						if (isSelfOwned(key))
 						{
 							selfOwnedObjects.push_back(backup[i]);
 						}
@@ -63,6 +110,7 @@ namespace JsonDatabase
 
 				removeAllSelfOwnedObjects();
 				closeRegistryFile();
+				closeRangeLock();
 
 				onDatabasePathChangeStart(path);
 			}
@@ -113,7 +161,7 @@ namespace JsonDatabase
 					{
 						JsonObject& obj = backup[i].get<JsonObject>();
 						std::string key = LockEntryObject::getKey(obj);
-						if (m_fileLocks.find(key) != m_fileLocks.end())
+						if (isSelfOwned(key))
 						{
 							selfOwnedObjects.push_back(backup[i]);
 						}
@@ -122,6 +170,7 @@ namespace JsonDatabase
 
 				removeAllSelfOwnedObjects();
 				closeRegistryFile();
+				closeRangeLock();
 				onNameChange(newName);
 			}
 			
@@ -282,6 +331,10 @@ namespace JsonDatabase
 		{
 			return getLocksPath() + "\\" + key;
 		}
+		std::string AbstractRegistry::getRangeLockFileName() const
+		{
+			return m_registrationName + "Locks";
+		}
 
 		bool AbstractRegistry::openRegistryFile() const
 		{
@@ -330,6 +383,15 @@ namespace JsonDatabase
 			if (!isRegistryFileOpen())
 				return true;
 
+			// Older clients only read the registry file
+			if (m_lockMode == LockMode::lockFilePerObject)
+			{
+				std::error_code ec;
+				uintmax_t logSize = std::filesystem::file_size(getRegistryLogFilePath(), ec);
+				if (!ec && logSize > 0)
+					compact_internal();
+			}
+
 			Error err = m_registryFile->unlock();
 			delete m_registryFile;
 			m_registryFile = nullptr;
@@ -339,32 +401,59 @@ namespace JsonDatabase
 		}
 
 		int AbstractRegistry::addObjects(const std::vector<std::shared_ptr<LockEntryObject>>& objects)
+		{
+			std::vector<bool> added;
+			return addObjects(objects, added);
+		}
+		int AbstractRegistry::addObjects(const std::vector<std::shared_ptr<LockEntryObject>>& objects, std::vector<bool>& addedOut, bool allOrNothing)
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			addedOut.assign(objects.size(), false);
 			if (!isRegistryFileOpen())
 				return 0;
-			JsonArray jsons;
-			readObjects_internal(jsons);
-			int added = 0;
-			for (auto& obj : objects)
+
+			std::vector<JsonObject> records;
+			std::vector<size_t> recordIndexes;
+			records.reserve(objects.size());
+			recordIndexes.reserve(objects.size());
+			for (size_t i = 0; i < objects.size(); ++i)
 			{
-				std::shared_ptr<JsonObject> jsonObj = std::make_shared<JsonObject>();
-				if (!createSelfOwnedLock(obj->getKey()))
+				const auto& obj = objects[i];
+				bool success = createSelfOwnedLock(obj->getKey());
+				JsonObject jsonObj;
+				if (success && !obj->save(jsonObj))
 				{
-					// Can't create lock
-					continue;
+					removeSelfOwnedLock(obj->getKey());
+					success = false;
 				}
-				if (obj->save(*jsonObj))
+				if (!success)
 				{
-					++added;
-					jsons.push_back(std::move(jsonObj));
+					if (allOrNothing)
+					{
+						// Release what was acquired so far, nothing was written yet
+						for (size_t j : recordIndexes)
+							removeSelfOwnedLock(objects[j]->getKey());
+						return 0;
+					}
+					continue;
 				}
-
+				JsonObject record;
+				record[LogKeys::add] = std::move(jsonObj);
+				records.emplace_back(std::move(record));
+				recordIndexes.push_back(i);
 			}
+			if (records.size() == 0)
+				return 0;
 			
-			if(saveObjects_internal(jsons) != 0)
-				return added;
-			return 0;
+			if (!appendRecords_internal(records))
+			{
+				for (size_t i : recordIndexes)
+					removeSelfOwnedLock(objects[i]->getKey());
+				return 0;
+			}
+			for (size_t i : recordIndexes)
+				addedOut[i] = true;
+			return records.size();
 		}
 		int AbstractRegistry::removeObjects(const std::vector<std::shared_ptr<LockEntryObject>>& objects)
 		{
@@ -384,31 +473,93 @@ namespace JsonDatabase
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
 			if (!isRegistryFileOpen())
 				return 0;
-			JsonArray jsons;
 
-			readObjects_internal(jsons);
-			int removed = 0;
-			for (auto& obj : keys)
+			std::vector<JsonObject> records;
+			std::vector<std::string> removingKeys;
+			records.reserve(keys.size());
+			removingKeys.reserve(keys.size());
+			for (const std::string& key : keys)
 			{
-				std::string key = obj;
-				if (m_fileLocks.find(key) == m_fileLocks.end())
+				if (!isSelfOwned(key))
 					continue; // This lock is not owned by this registry
 
-				for (size_t i = 0; i < jsons.size(); ++i)
-				{
-					JsonObject& subObj = jsons[i].get<JsonObject>();
-					std::string loadedKey = LockEntryObject::getKey(subObj);
-					if (loadedKey == key)
-					{
-						jsons.erase(jsons.begin() + i);
-						removeSelfOwnedLock(key);
-						++removed;
-						break;
-					}
-				}
+				JsonObject record;
+				record[LogKeys::remove] = key;
+				records.emplace_back(std::move(record));
+				removingKeys.push_back(key);
 			}
-			saveObjects_internal(jsons);
-			return removed;
+			if (records.size() == 0)
+				return 0;
+
+			if (!appendRecords_internal(records))
+				return 0;
+			for (const std::string& key : removingKeys)
+				removeSelfOwnedLock(key);
+			return removingKeys.size();
+		}
+		int AbstractRegistry::removeForeignObjects(const std::vector<std::string>& keys)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			if (!isRegistryFileOpen())
+				return 0;
+
+			std::vector<JsonObject> records;
+			records.reserve(keys.size());
+			for (const std::string& key : keys)
+			{
+				if (isSelfOwned(key))
+					continue;
+				JsonObject record;
+				record[LogKeys::remove] = key;
+				records.emplace_back(std::move(record));
+
+				// Lock file of a dead owner, deleting fails if it is still in use
+				if (m_lockMode == LockMode::lockFilePerObject)
+					Internal::FileLock::deleteFile(getLocksPath(), key);
+			}
+			if (records.size() == 0)
+				return 0;
+			if (!appendRecords_internal(records))
+				return 0;
+			return records.size();
+		}
+		int AbstractRegistry::restoreObjects(const std::vector<std::shared_ptr<LockEntryObject>>& objects)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			if (!isRegistryFileOpen())
+				return 0;
+
+			std::vector<JsonObject> records;
+			records.reserve(objects.size());
+			for (const auto& obj : objects)
+			{
+				if (!isSelfOwned(obj->getKey()))
+					continue; // The lock was released, the entry can't be restored
+				JsonObject jsonObj;
+				if (!obj->save(jsonObj))
+					continue;
+				JsonObject record;
+				record[LogKeys::add] = std::move(jsonObj);
+				records.emplace_back(std::move(record));
+			}
+			if (records.size() == 0)
+				return 0;
+			if (!appendRecords_internal(records))
+				return 0;
+			return records.size();
+		}
+		int AbstractRegistry::releaseObjects(const std::vector<std::string>& keys)
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_5);
+			int released = 0;
+			for (const std::string& key : keys)
+			{
+				if (!isSelfOwned(key))
+					continue;
+				if (removeSelfOwnedLock(key))
+					++released;
+			}
+			return released;
 		}
 		bool AbstractRegistry::isObjectActive(const std::string& key) const
 		{
@@ -435,9 +586,11 @@ namespace JsonDatabase
 				return 0;
 			
 			auto err = m_registryFile->writeJsonFile(jsons);
-			if(err == Error::none)
-				return jsons.size();
-			return 0;
+			if (err != Error::none)
+				return 0;
+			// The log is contained in the written data now
+			clearLog_internal();
+			return jsons.size();
 		}
 
 		bool AbstractRegistry::readObjects_internal(JsonArray& jsons) const
@@ -449,8 +602,169 @@ namespace JsonDatabase
 			auto err = m_registryFile->readJsonFile(jsons);
 			if (err != Error::none)
 				return false;
+			return replayLog_internal(jsons);
+		}
+
+		std::string AbstractRegistry::getRegistryLogFilePath() const
+		{
+			return getRegistrationFilePath() + ".log";
+		}
+		bool AbstractRegistry::appendRecords_internal(const std::vector<JsonObject>& records) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+			if (!isRegistryFileOpen())
+				return false;
+
+			// One record per line
+			JsonSerializer serializer;
+			serializer.enableTabs(false);
+			serializer.enableNewLinesInObjects(false);
+			serializer.enableNewLineAfterObject(false);
+			serializer.enableSpaces(false);
+			std::string data;
+			for (const JsonObject& record : records)
+			{
+				data += serializer.serializeObject(record);
+				data += '\n';
+			}
+
+			std::string logFilePath = getRegistryLogFilePath();
+			std::ofstream file(logFilePath, std::ios::app | std::ios::binary);
+			if (!file.is_open())
+			{
+				if (m_logger)
+					m_logger->logError("Can't open registry log file: " + logFilePath);
+				return false;
+			}
+			file << data;
+			file.flush();
+			if (file.fail())
+			{
+				if (m_logger)
+					m_logger->logError("Can't write to registry log file: " + logFilePath);
+				return false;
+			}
+			file.close();
+
+			// Let the watchers of the registry file know about the change
+			m_registryFile->markAsChanged();
+			compactIfNeeded_internal();
 			return true;
 		}
+		bool AbstractRegistry::replayLog_internal(JsonArray& jsons) const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+			std::ifstream file(getRegistryLogFilePath(), std::ios::binary);
+			if (!file.is_open())
+				return true; // No log, nothing changed since the last compaction
+
+			std::unordered_map<std::string, size_t> keyIndex;
+			keyIndex.reserve(jsons.size());
+			for (size_t i = 0; i < jsons.size(); ++i)
+			{
+				const JsonObject* obj = jsons[i].get_if<JsonObject>();
+				if (obj)
+					keyIndex[LockEntryObject::getKey(*obj)] = i;
+			}
+			std::vector<bool> removed(jsons.size(), false);
+			bool hasRemoved = false;
+
+			JsonDeserializer deserializer;
+			std::string line;
+			while (std::getline(file, line))
+			{
+				if (line.size() == 0)
+					continue;
+				JsonObject record;
+				if (!deserializer.deserializeObject(line, record))
+				{
+					// Can be a record which was not written completely
+					if (m_logger)
+						m_logger->logWarning("Skipping corrupt registry log record: " + line);
+					continue;
+				}
+				if (record.contains(LogKeys::add))
+				{
+					JsonObject* entry = record.at(LogKeys::add).get_if<JsonObject>();
+					if (!entry)
+						continue;
+					std::string key = LockEntryObject::getKey(*entry);
+					const auto& it = keyIndex.find(key);
+					if (it != keyIndex.end())
+					{
+						jsons[it->second] = std::move(*entry);
+						removed[it->second] = false;
+					}
+					else
+					{
+						keyIndex[key] = jsons.size();
+						jsons.emplace_back(std::move(*entry));
+						removed.push_back(false);
+					}
+				}
+				else if (record.contains(LogKeys::remove))
+				{
+					const std::string* key = record.at(LogKeys::remove).get_if<std::string>();
+					if (!key)
+						continue;
+					const auto& it = keyIndex.find(*key);
+					if (it == keyIndex.end())
+						continue;
+					removed[it->second] = true;
+					hasRemoved = true;
+					keyIndex.erase(it);
+				}
+			}
+
+			if (hasRemoved)
+			{
+				JsonArray remaining;
+				remaining.reserve(jsons.size());
+				for (size_t i = 0; i < jsons.size(); ++i)
+				{
+					if (!removed[i])
+						remaining.emplace_back(std::move(jsons[i]));
+				}
+				jsons = std::move(remaining);
+			}
+			return true;
+		}
+		bool AbstractRegistry::clearLog_internal() const
+		{
+			std::string logFilePath = getRegistryLogFilePath();
+			if (!QFile::exists(QString::fromStdString(logFilePath)))
+				return true;
+			// Truncate, a log that stays after a full write would be applied again
+			std::ofstream file(logFilePath, std::ios::trunc | std::ios::binary);
+			if (!file.is_open())
+			{
+				if (m_logger)
+					m_logger->logError("Can't clear registry log file: " + logFilePath);
+				return false;
+			}
+			return true;
+		}
+		bool AbstractRegistry::compactIfNeeded_internal() const
+		{
+			std::error_code ec;
+			uintmax_t logSize = std::filesystem::file_size(getRegistryLogFilePath(), ec);
+			if (ec || logSize < s_minCompactionLogSize)
+				return true;
+			uintmax_t registrySize = std::filesystem::file_size(getRegistrationFilePath(), ec);
+			if (!ec && logSize < registrySize)
+				return true;
+			return compact_internal();
+		}
+		bool AbstractRegistry::compact_internal() const
+		{
+			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+			JsonArray jsons;
+			if (!readObjects_internal(jsons))
+				return false;
+			if (m_registryFile->writeJsonFile(jsons) != Error::none)
+				return false;
+			return clearLog_internal();
+		}
 
 		bool AbstractRegistry::readObjects_internal(const JsonArray& jsons, std::vector<JDSerializable*>& objects) const
 		{
@@ -476,6 +790,14 @@ namespace JsonDatabase
 		bool AbstractRegistry::createSelfOwnedLock(const std::string& name)
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_7);
+			if (m_lockMode == LockMode::rangeLockFile)
+			{
+				Internal::FileRangeLock* rangeLock = getRangeLock();
+				if (!rangeLock)
+					return false;
+				Error err;
+				return rangeLock->lockSlot(name, err);
+			}
 			if(m_fileLocks.find(name) != m_fileLocks.end())
 				return false;
 
@@ -492,6 +814,13 @@ namespace JsonDatabase
 		bool AbstractRegistry::removeSelfOwnedLock(const std::string& name)
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_7);
+			if (m_lockMode == LockMode::rangeLockFile)
+			{
+				if (!m_rangeLock)
+					return false;
+				Error err;
+				return m_rangeLock->unlockSlot(name, err);
+			}
 			const auto &it = m_fileLocks.find(name);
 			if (it == m_fileLocks.end())
 				return false;
@@ -503,40 +832,32 @@ namespace JsonDatabase
 			delete lock;
 			return err == Error::none;
 		}
+		Internal::FileRangeLock* AbstractRegistry::getRangeLock() const
+		{
+			if (!m_rangeLock)
+				m_rangeLock = new Internal::FileRangeLock(getPath(), getRangeLockFileName(), m_logger);
+			Error err;
+			if (!m_rangeLock->open(err))
+				return nullptr;
+			return m_rangeLock;
+		}
+		void AbstractRegistry::closeRangeLock()
+		{
+			delete m_rangeLock;
+			m_rangeLock = nullptr;
+		}
 		bool AbstractRegistry::removeAllSelfOwnedObjects()
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_7);
 			if (!isRegistryFileOpen())
 				return 0;
-			JsonArray jsons;
-			JsonArray jsonsOut;
 			std::vector<std::string> selfOwned = getSelfOwnedLockNames();
-			readObjects_internal(jsons);
-			jsonsOut = jsons;
 			bool success = true;
-			for (auto& obj : selfOwned)
-			{
-				std::string key = obj;
-				if (m_fileLocks.find(key) == m_fileLocks.end())
-					continue; // This lock is not owned by this registry
-
-				for (size_t i = 0; i < jsonsOut.size(); ++i)
-				{
-					JsonObject& subObj = jsonsOut[i].get<JsonObject>();
-					std::string loadedKey = LockEntryObject::getKey(subObj);
-					if (loadedKey == key)
-					{
-						jsonsOut.erase(jsonsOut.begin() + i);
-						success &= removeSelfOwnedLock(key);
-						break;
-					}
-				}
-			}
-			if (jsonsOut.size() != jsons.size())
-			{
-				saveObjects_internal(jsonsOut);
-			}
+			if (selfOwned.size() > 0)
+				success = removeObjects(selfOwned) == selfOwned.size();
 			m_fileLocks.clear();
+			if (m_rangeLock)
+				m_rangeLock->unlockAll();
 			return success;
 		}
 		int AbstractRegistry::removeInactiveObjects() const
@@ -551,6 +872,33 @@ namespace JsonDatabase
 				return 0;
 			
 
+			if (m_lockMode == LockMode::rangeLockFile)
+			{
+				// An entry is inactive if no one holds its range anymore
+				Internal::FileRangeLock* rangeLock = getRangeLock();
+				if (!rangeLock)
+					return 0;
+				int removed = 0;
+				JD_REGISTRY_PROFILING_BLOCK("Search inactive locks", JD_COLOR_STAGE_8);
+				for (auto& obj : jsons)
+				{
+					JsonObject& subObj = obj.get<JsonObject>();
+					std::string key = LockEntryObject::getKey(subObj);
+					if (rangeLock->isSlotInUse(key))
+						jsonsOut.emplace_back(std::move(obj));
+					else
+						++removed;
+				}
+				JD_REGISTRY_PROFILING_END_BLOCK;
+				if (removed > 0)
+				{
+					saveObjects_internal(jsonsOut);
+					if (m_logger)
+						m_logger->logInfo("Removed " + std::to_string(removed) + " inactive locks");
+				}
+				return removed;
+			}
+
 			for (auto& obj : jsons)
 			{
 				JsonObject& subObj = obj.get<JsonObject>();
@@ -603,6 +951,13 @@ namespace JsonDatabase
 			/*/const auto& it = m_fileLocks.find(name);
 			if (it == m_fileLocks.end())
 				return false;*/
+			if (m_lockMode == LockMode::rangeLockFile)
+			{
+				Internal::FileRangeLock* rangeLock = getRangeLock();
+				if (!rangeLock)
+					return false;
+				return rangeLock->isSlotInUse(name);
+			}
 
 			std::string path = getLocksPath();
 			if (Internal::FileLock::fileExists(path, name))
@@ -612,6 +967,8 @@ namespace JsonDatabase
 		bool AbstractRegistry::isSelfOwned(const std::string& key) const
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+			if (m_lockMode == LockMode::rangeLockFile)
+				return m_rangeLock && m_rangeLock->isSlotOwned(key);
 			const auto& it = m_fileLocks.find(key);
 			if (it != m_fileLocks.end())
 				return true;
@@ -621,12 +978,39 @@ namespace JsonDatabase
 		std::vector<std::string> AbstractRegistry::getLockNames() const
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+			if (m_lockMode == LockMode::rangeLockFile)
+			{
+				// There are no files per lock, the registry entries with a held range are the locks
+				bool wasOpen = isRegistryFileOpen();
+				if (!wasOpen && !openRegistryFile())
+					return {};
+				AutoClose autoClose(wasOpen ? nullptr : this);
+				std::vector<std::string> names;
+				JsonArray jsons;
+				Internal::FileRangeLock* rangeLock = getRangeLock();
+				if (!rangeLock || !readObjects_internal(jsons))
+					return names;
+				names.reserve(jsons.size());
+				for (auto& obj : jsons)
+				{
+					std::string key = LockEntryObject::getKey(obj.get<JsonObject>());
+					if (rangeLock->isSlotInUse(key))
+						names.push_back(key);
+				}
+				return names;
+			}
 			std::vector<std::string> files = Internal::FileLock::getLockFileNamesInDirectory(getLocksPath());
 			return files;
 		}
 		std::vector<std::string> AbstractRegistry::getSelfOwnedLockNames() const
 		{
 			JD_REGISTRY_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+			if (m_lockMode == LockMode::rangeLockFile)
+			{
+				if (!m_rangeLock)
+					return {};
+				return m_rangeLock->getOwnedKeys();
+			}
 			std::vector<std::string> names;
 			for (auto& lock : m_fileLocks)
 			{
@@ -654,11 +1038,15 @@ namespace JsonDatabase
 		}
 		unsigned int AbstractRegistry::getLockCount() const
 		{
+			if (m_lockMode == LockMode::rangeLockFile)
+				return getLockNames().size();
 			std::vector<std::string> files = Internal::FileLock::getLockFileNamesInDirectory(getLocksPath());
 			return files.size();
 		}
 		unsigned int AbstractRegistry::getSelfLockCount() const
 		{
+			if (m_lockMode == LockMode::rangeLockFile)
+				return m_rangeLock ? m_rangeLock->getOwnedCount() : 0;
 			return m_fileLocks.size();
 		}
 		unsigned int AbstractRegistry::getNotSelfLockCount() const
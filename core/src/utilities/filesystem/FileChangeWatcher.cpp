@@ -1,21 +1,33 @@
 #include "utilities/filesystem/FileChangeWatcher.h"
+#include "utilities/filesystem/LockedFileAccessor.h"
 #include "utilities/JDUtilities.h"
 #include "utilities/StringUtilities.h"
 #include <fstream>
 #include <filesystem>
 
+#ifdef __linux__
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 
 namespace JsonDatabase
 {
     namespace Internal
     {
         FileChangeWatcher::Mode FileChangeWatcher::s_defaultWatchMode = FileChangeWatcher::Mode::polling;
+        const unsigned int FileChangeWatcher::s_inotifyDebounceMs = 50;
+        bool FileChangeWatcher::s_pollingContentHash = false;
 
         FileChangeWatcher::FileChangeWatcher(const std::string& filePath)
             : m_stopFlag(false)
             , m_fileChanged(false)
             , m_paused(false)
+#ifdef _WIN32
             , m_eventHandle(nullptr)
+#endif
             , m_setupError(0)
         {
             m_filePath = getFullPath(filePath);
@@ -29,8 +41,8 @@ namespace JsonDatabase
 
         bool FileChangeWatcher::setup(Log::LogObject* parentLogger)
         {
-            std::string directory = m_filePath.substr(0, m_filePath.find_last_of("\\") + 1);
-            /*m_eventHandle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE);
+            /*std::string directory = m_filePath.substr(0, m_filePath.find_last_of("\\") + 1);
+            m_eventHandle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE);
             if (m_eventHandle == INVALID_HANDLE_VALUE)
             {
                 m_setupError = GetLastError();
@@ -41,7 +53,7 @@ namespace JsonDatabase
             m_setupError = 0;
             return true;
         }
-        DWORD FileChangeWatcher::getSetupError() const
+        FileChangeWatcher::SetupError FileChangeWatcher::getSetupError() const
         {
 			return m_setupError;
 		}
@@ -58,6 +70,7 @@ namespace JsonDatabase
                 }
                 case Mode::winApi:
                 {
+#ifdef _WIN32
                     if (m_watchThread)
                         return true;
                     if (!m_eventHandle.load())
@@ -65,6 +78,24 @@ namespace JsonDatabase
                             return false;
 
                     m_watchThread = new std::thread(&FileChangeWatcher::monitorFileChanges, this);
+                    break;
+#else
+                    if (m_logger)m_logger->logError("Mode::winApi is only available on windows");
+                    return false;
+#endif
+                }
+                case Mode::inotify:
+                {
+#ifdef __linux__
+                    if (m_watchThread)
+                        return true;
+                    m_stopFlag.store(false);
+                    m_watchThread = new std::thread(&FileChangeWatcher::monitorFileChangesInotify, this);
+                    break;
+#else
+                    if (m_logger)m_logger->logError("Mode::inotify is only available on linux");
+                    return false;
+#endif
                 }
                 default:
                 {
@@ -88,6 +119,7 @@ namespace JsonDatabase
                     break;
                 }
                 case Mode::winApi:
+                case Mode::inotify:
                 {
                     if (!m_watchThread)
                         return;
@@ -113,6 +145,7 @@ namespace JsonDatabase
                     break;
                 }
                 case Mode::winApi:
+                case Mode::inotify:
                 {
                     return m_watchThread != nullptr;
                 }
@@ -140,16 +173,38 @@ namespace JsonDatabase
 
         void FileChangeWatcher::pause()
         {
+            if (m_watchMode == Mode::inotify)
+            {
+                // Events that are queued before the pause come from other writers,
+                // they stay pending and get reported after unpause()
+                std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                readInotifyEvents_internal();
+                m_paused.store(true);
+                return;
+            }
             m_paused.store(true);
         }
         void FileChangeWatcher::unpause()
         {
+            if (m_watchMode == Mode::inotify)
+            {
+                // Our own write has already been closed, its events are queued and must not be reported
+                std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                readInotifyEvents_internal();
+                m_paused.store(false);
+                return;
+            }
             m_paused.store(false);
         }
         bool FileChangeWatcher::isPaused() const
         {
             return m_paused.load();
         }
+        void FileChangeWatcher::setChangeCallback(const std::function<void()>& callback)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changeCallback = callback;
+        }
 
 
         void FileChangeWatcher::setDefaultWatchMode(Mode mode)
@@ -160,8 +215,24 @@ namespace JsonDatabase
         {
             return s_defaultWatchMode;
         }
+        void FileChangeWatcher::setPollingContentHashEnabled(bool enable)
+        {
+            s_pollingContentHash = enable;
+        }
+        bool FileChangeWatcher::isPollingContentHashEnabled()
+        {
+            return s_pollingContentHash;
+        }
 
         std::string FileChangeWatcher::getFullPath(const std::string& relativePath) {
+#ifndef _WIN32
+            std::error_code ec;
+            std::filesystem::path fullPath = std::filesystem::absolute(relativePath, ec);
+            if (ec) {
+                throw std::runtime_error("Error getting full path.");
+            }
+            return fullPath.string();
+#else
             char fullPath[MAX_PATH];
             DWORD result = GetFullPathNameA(relativePath.c_str(), MAX_PATH, fullPath, nullptr);
 
@@ -170,11 +241,13 @@ namespace JsonDatabase
             }
 
             return fullPath;
+#endif
         }
 
 
         void FileChangeWatcher::monitorFileChanges()
         {
+#ifdef _WIN32
             JD_PROFILING_THREAD("FileChangeWatcher");
 #ifdef JD_PROFILING
             std::string title = ("FileChangeWatcher \"" + m_filePath + "\"");            
@@ -242,6 +315,8 @@ namespace JsonDatabase
                         m_fileChanged.store(true);
                         if(m_logger)
                             m_logger->logInfo("File change detected");
+                        if (m_changeCallback)
+                            m_changeCallback();
                         while (m_fileChanged && !m_stopFlag.load()) {
                             m_cv.wait(lock);
                         }
@@ -262,9 +337,110 @@ namespace JsonDatabase
 
             FindCloseChangeNotification(m_eventHandle.load());
             m_eventHandle.store(nullptr);
+#endif
         }
 
 
+        void FileChangeWatcher::monitorFileChangesInotify()
+        {
+#ifdef __linux__
+            JD_PROFILING_THREAD("FileChangeWatcher");
+            std::filesystem::path file(m_filePath);
+            std::string directory = file.parent_path().string();
+
+            int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (fd < 0)
+            {
+                if (m_logger)m_logger->logError("inotify_init1 failed, errno = " + std::to_string(errno));
+                return;
+            }
+            if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+            {
+                if (m_logger)m_logger->logError("inotify_add_watch on \"" + directory + "\" failed, errno = " + std::to_string(errno));
+                close(fd);
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                m_inotifyFd = fd;
+                m_inotifyFileName = file.filename().string();
+                m_inotifyPending = false;
+            }
+
+            while (!m_stopFlag.load())
+            {
+                bool pending;
+                {
+                    std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                    pending = m_inotifyPending;
+                }
+                // Wait up to one second while idle, so that the stop flag gets checked,
+                // but only for the debounce time while a change is pending
+                pollfd pfd{ fd, POLLIN, 0 };
+                int ready = poll(&pfd, 1, pending ? s_inotifyDebounceMs : 1000);
+                if (m_stopFlag.load())
+                    break;
+                if (ready < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    if (m_logger)m_logger->logError("poll on inotify failed, errno = " + std::to_string(errno));
+                    break;
+                }
+                if (ready == 0)
+                {
+                    // Burst is over. A change stays pending while paused
+                    // and gets reported after unpause()
+                    {
+                        std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                        if (!m_inotifyPending || m_paused.load())
+                            continue;
+                        m_inotifyPending = false;
+                    }
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_fileChanged.store(true);
+                    if (m_logger)
+                        m_logger->logInfo("File change detected");
+                    if (m_changeCallback)
+                        m_changeCallback();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                readInotifyEvents_internal();
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(m_inotifyMutex);
+                m_inotifyFd = -1;
+                m_inotifyPending = false;
+            }
+            close(fd);
+#endif
+        }
+        void FileChangeWatcher::readInotifyEvents_internal()
+        {
+#ifdef __linux__
+            if (m_inotifyFd < 0)
+                return;
+            // Only the events that get read while paused are ignored
+            bool paused = m_paused.load();
+            alignas(inotify_event) char buffer[4096];
+            ssize_t len;
+            while ((len = read(m_inotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(ptr)->len)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    if (event->len == 0 || m_inotifyFileName != event->name)
+                        continue;
+                    if (!paused)
+                        m_inotifyPending = true;
+                }
+            }
+#endif
+        }
+
         bool FileChangeWatcher::fileChanged()
         {
             std::filesystem::path file(m_filePath);
@@ -282,6 +458,7 @@ namespace JsonDatabase
 
             // Check if the file has been modified since lastWriteTime
             if (change > m_lastModificationTime) {
+#ifdef _WIN32
                 HANDLE fileHandle = CreateFile(
 #ifdef UNICODE
                     Utilities::strToWstr(m_filePath).c_str(),
@@ -302,9 +479,10 @@ namespace JsonDatabase
                     std::this_thread::sleep_for(std::chrono::milliseconds(1));
                     return false;
                 }
-                m_lastModificationTime = change;
                 // Close the file handle
                 CloseHandle(fileHandle);
+#endif
+                m_lastModificationTime = change;
                 return true;
             }
 
@@ -312,19 +490,94 @@ namespace JsonDatabase
         }
         void FileChangeWatcher::checkFileChanges()
         {
-            bool success;
-            std::string md5 = Utilities::calculateMD5Hash(m_filePath, m_logger, success);
-            if (!success)
+            // Tier 1: file metadata
+            std::error_code ec;
+            std::filesystem::path file(m_filePath);
+            uintmax_t fileSize = std::filesystem::file_size(file, ec);
+            std::filesystem::file_time_type modificationTime;
+            if (!ec)
+                modificationTime = std::filesystem::last_write_time(file, ec);
+            if (ec)
             {
-				if (m_logger)m_logger->logError("Error calculating md5 hash of file: " + m_filePath);
-				return;
-			}
-            if (md5 != m_md5Hash && m_md5Hash!="")
+                if (m_logger)m_logger->logError("Can't read the file status of: " + m_filePath + " " + ec.message());
+                return;
+            }
+            unsigned long long fileID = 0;
+#ifdef __linux__
+            struct stat fileStat;
+            if (stat(m_filePath.c_str(), &fileStat) == 0)
+                fileID = fileStat.st_ino;
+#elif defined(_WIN32)
+            HANDLE fileHandle = CreateFile(
+#ifdef UNICODE
+                Utilities::strToWstr(m_filePath).c_str(),
+#else
+                m_filePath.c_str(),
+#endif
+                0, // Only the metadata is read
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr
+            );
+            if (fileHandle != INVALID_HANDLE_VALUE)
             {
-				m_fileChanged.store(true);
+                BY_HANDLE_FILE_INFORMATION info;
+                if (GetFileInformationByHandle(fileHandle, &info))
+                    fileID = (static_cast<unsigned long long>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+                CloseHandle(fileHandle);
+            }
+#endif
+
+            // Tier 2: generation counter, catches writes that the timestamp resolution misses
+            unsigned long long generation = 0;
+            LockedFileAccessor::readGeneration(m_filePath, generation);
+
+            bool changed = fileSize != m_pollFileSize ||
+                modificationTime != m_pollModificationTime ||
+                fileID != m_pollFileID ||
+                generation != m_pollGeneration;
+
+            m_pollFileSize = fileSize;
+            m_pollModificationTime = modificationTime;
+            m_pollFileID = fileID;
+            m_pollGeneration = generation;
+
+            if (!m_pollInitialized)
+            {
+                m_pollInitialized = true;
+                changed = false;
+            }
+
+            // Tier 3: content hash, only if enabled
+            if (s_pollingContentHash)
+            {
+                if (changed)
+                {
+                    // The next check takes the new hash as reference
+                    m_md5Hash = "";
+                }
+                else
+                {
+                    bool success;
+                    std::string md5 = Utilities::calculateMD5Hash(m_filePath, m_logger, success);
+                    if (!success)
+                    {
+                        if (m_logger)m_logger->logError("Error calculating md5 hash of file: " + m_filePath);
+                        return;
+                    }
+                    if (md5 != m_md5Hash && m_md5Hash != "")
+                        changed = true;
+                    m_md5Hash = md5;
+                }
+            }
+
+            if (changed)
+            {
+                m_fileChanged.store(true);
                 if(m_logger)m_logger->logInfo("File change detected");
-			}
-            m_md5Hash = md5;
+            }
         }
 
 
@@ -358,6 +611,12 @@ namespace JsonDatabase
 
             return restart(targetFile);
         }
+        void ManagedFileChangeWatcher::setChangeCallback(const std::function<void()>& callback)
+        {
+            m_changeCallback = callback;
+            if (m_databaseFileWatcher)
+                m_databaseFileWatcher->setChangeCallback(callback);
+        }
         bool ManagedFileChangeWatcher::restart(const std::string& targetFile)
         {
             if (m_databaseFileWatcher)
@@ -367,12 +626,17 @@ namespace JsonDatabase
                 m_databaseFileWatcher = nullptr;
             }
             m_databaseFileWatcher = new FileChangeWatcher(targetFile);
+            m_databaseFileWatcher->setChangeCallback(m_changeCallback);
             bool success = m_databaseFileWatcher->setup(m_logger);
-            DWORD lastError = m_databaseFileWatcher->getSetupError();
+            FileChangeWatcher::SetupError lastError = m_databaseFileWatcher->getSetupError();
             JD_UNUSED(lastError);
             if (!success)
             {
+#ifdef _WIN32
                 if(m_logger)m_logger->logError("Initializing file change monitoring. GetLastError() =  " + std::to_string(lastError) + " : " + Utilities::getLastErrorString(lastError));
+#else
+                if(m_logger)m_logger->logError("Initializing file change monitoring. Error = " + std::to_string(lastError));
+#endif
 				return false;
 			}
             m_databaseFileWatcher->startWatching();
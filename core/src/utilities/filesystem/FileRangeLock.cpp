@@ -0,0 +1,228 @@
+#include "utilities/filesystem/FileRangeLock.h"
+#include "utilities/JDUniqueMutexLock.h"
+#include "utilities/JDUtilities.h"
+#include "utilities/StringUtilities.h"
+
+
+namespace JsonDatabase
+{
+    namespace Internal
+    {
+        const std::string FileRangeLock::s_fileEnding = ".rlck";
+
+        FileRangeLock::FileRangeLock(const std::string& filePath, const std::string& fileName, Log::LogObject* logger)
+            : m_logger(logger)
+            , m_directory(Utilities::replaceForwardSlashesWithBackslashes(filePath))
+            , m_fileName(fileName)
+            , m_fileHandle(nullptr)
+        {
+
+        }
+        FileRangeLock::~FileRangeLock()
+        {
+            close();
+        }
+
+        const std::string& FileRangeLock::getFilePath() const
+        {
+            return m_directory;
+        }
+        const std::string& FileRangeLock::getFileName() const
+        {
+            return m_fileName;
+        }
+        std::string FileRangeLock::getFullFilePath() const
+        {
+            return m_directory + "\\" + m_fileName + s_fileEnding;
+        }
+
+        bool FileRangeLock::open(Error& err)
+        {
+            JDFILE_FILE_LOCK_PROFILING_FUNCTION(JD_COLOR_STAGE_8);
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            err = Error::none;
+            if (m_fileHandle)
+                return true;
+
+            std::string filePath = getFullFilePath();
+            HANDLE fileHandle = CreateFile(
+#ifdef UNICODE
+                Utilities::strToWstr(filePath).c_str(),
+#else
+                filePath.c_str(),
+#endif
+                GENERIC_READ | GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr
+            );
+            if (fileHandle == INVALID_HANDLE_VALUE)
+            {
+                DWORD lastError = GetLastError();
+                err = Error::unableToCreateOrOpenLockFile;
+                if (m_logger)m_logger->logError("Can't open range lock file: " + filePath + " GetLastError() = " +
+                                                std::to_string(lastError) + " : " + Utilities::getLastErrorString(lastError));
+                return false;
+            }
+            m_fileHandle = fileHandle;
+            return true;
+        }
+        void FileRangeLock::close()
+        {
+            JDFILE_FILE_LOCK_PROFILING_FUNCTION(JD_COLOR_STAGE_8);
+            unlockAll();
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            if (!m_fileHandle)
+                return;
+            // Closing the handle releases all ranges which are still locked
+            CloseHandle(m_fileHandle);
+            m_fileHandle = nullptr;
+        }
+        bool FileRangeLock::isOpen() const
+        {
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            return m_fileHandle != nullptr;
+        }
+
+        bool FileRangeLock::lockSlot(const std::string& key, Error& err)
+        {
+            JDFILE_FILE_LOCK_PROFILING_FUNCTION(JD_COLOR_STAGE_8);
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            if (!m_fileHandle)
+            {
+                err = Error::fileNotLocked;
+                return false;
+            }
+            if (m_ownedSlots.find(key) != m_ownedSlots.end())
+            {
+                err = Error::fileAlreadyLocked;
+                return false;
+            }
+            unsigned long long offset = getSlotOffset(key);
+            if (!lockRange(offset))
+            {
+                err = Error::unableToLockFile;
+                return false;
+            }
+            // The presence range may be held for a moment by the probe of another session
+            if (!lockRange(getPresenceOffset(offset), false))
+            {
+                unlockRange(offset);
+                err = Error::unableToLockFile;
+                return false;
+            }
+            m_ownedSlots[key] = offset;
+            err = Error::none;
+            return true;
+        }
+        bool FileRangeLock::unlockSlot(const std::string& key, Error& err)
+        {
+            JDFILE_FILE_LOCK_PROFILING_FUNCTION(JD_COLOR_STAGE_8);
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            const auto& it = m_ownedSlots.find(key);
+            if (it == m_ownedSlots.end())
+            {
+                err = Error::fileAlreadyUnlocked;
+                return false;
+            }
+            unsigned long long offset = it->second;
+            m_ownedSlots.erase(it);
+            unlockRange(getPresenceOffset(offset));
+            if (!unlockRange(offset))
+            {
+                DWORD lastError = GetLastError();
+                if (m_logger)m_logger->logError("UnlockFileEx. GetLastError() =  " + std::to_string(lastError) + " : " + Utilities::getLastErrorString(lastError));
+                err = Error::unableToLockFile;
+                return false;
+            }
+            err = Error::none;
+            return true;
+        }
+        void FileRangeLock::unlockAll()
+        {
+            JDFILE_FILE_LOCK_PROFILING_FUNCTION(JD_COLOR_STAGE_8);
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            for (const auto& slot : m_ownedSlots)
+            {
+                unlockRange(getPresenceOffset(slot.second));
+                unlockRange(slot.second);
+            }
+            m_ownedSlots.clear();
+        }
+
+        bool FileRangeLock::isSlotOwned(const std::string& key) const
+        {
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            return m_ownedSlots.find(key) != m_ownedSlots.end();
+        }
+        bool FileRangeLock::isSlotInUse(const std::string& key) const
+        {
+            JDFILE_FILE_LOCK_PROFILING_FUNCTION(JD_COLOR_STAGE_8);
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            if (m_ownedSlots.find(key) != m_ownedSlots.end())
+                return true;
+            if (!m_fileHandle)
+                return false;
+
+            // Probe the presence range, if it can be locked, no one else holds the slot.
+            // Lock attempts of other sessions only compete for the slot range.
+            unsigned long long offset = getPresenceOffset(getSlotOffset(key));
+            if (!lockRange(offset))
+                return true;
+            unlockRange(offset);
+            return false;
+        }
+
+        std::vector<std::string> FileRangeLock::getOwnedKeys() const
+        {
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            std::vector<std::string> keys;
+            keys.reserve(m_ownedSlots.size());
+            for (const auto& slot : m_ownedSlots)
+                keys.push_back(slot.first);
+            return keys;
+        }
+        size_t FileRangeLock::getOwnedCount() const
+        {
+            JDM_UNIQUE_LOCK_M(m_mutex);
+            return m_ownedSlots.size();
+        }
+
+        unsigned long long FileRangeLock::getSlotOffset(const std::string& key)
+        {
+            // FNV-1a, the top bit is cleared to stay in the range of a signed file offset,
+            // the second bit is reserved for the presence ranges
+            unsigned long long hash = 14695981039346656037ull;
+            for (unsigned char c : key)
+            {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash & 0x3FFFFFFFFFFFFFFFull;
+        }
+        unsigned long long FileRangeLock::getPresenceOffset(unsigned long long slotOffset)
+        {
+            return slotOffset | 0x4000000000000000ull;
+        }
+
+        bool FileRangeLock::lockRange(unsigned long long offset, bool failImmediately) const
+        {
+            OVERLAPPED overlapped = { 0 };
+            overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD flags = LOCKFILE_EXCLUSIVE_LOCK;
+            if (failImmediately)
+                flags |= LOCKFILE_FAIL_IMMEDIATELY;
+            return LockFileEx(m_fileHandle, flags, 0, 1, 0, &overlapped);
+        }
+        bool FileRangeLock::unlockRange(unsigned long long offset) const
+        {
+            OVERLAPPED overlapped = { 0 };
+            overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            return UnlockFileEx(m_fileHandle, 0, 1, 0, &overlapped);
+        }
+    }
+}
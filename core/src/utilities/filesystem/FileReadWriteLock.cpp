@@ -2,12 +2,34 @@
 #include "utilities/StringUtilities.h"
 
 #include <random>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
 
 namespace JsonDatabase
 {
     namespace Internal
     {
         const unsigned int FileReadWriteLock::s_tryLockTimeoutMs = 1000;
+        const std::string FileReadWriteLock::s_writerQueueTag = "wq";
+        const unsigned int FileReadWriteLock::s_defaultWriterTicketLeaseMs = 10000;
+
+        std::mutex FileReadWriteLock::s_ticketMutex;
+        std::map<std::string, std::chrono::steady_clock::time_point> FileReadWriteLock::s_ticketFirstSeen;
+
+        std::mutex FileReadWriteLock::s_statisticsMutex;
+        FileReadWriteLock::WaitStatistics FileReadWriteLock::s_readStatistics;
+        FileReadWriteLock::WaitStatistics FileReadWriteLock::s_writeStatistics;
+
+        double FileReadWriteLock::WaitStatistics::getAverageWaitMs() const
+        {
+            size_t count = lockCount + timeoutCount;
+            if (count == 0)
+                return 0;
+            return totalWaitMs / count;
+        }
 
 
         FileReadWriteLock::FileReadWriteLock(const std::string& filePath, const std::string& fileName, Log::LogObject *logger)
@@ -17,6 +39,9 @@ namespace JsonDatabase
             , m_locked(false)
             , m_access(Access::unknown)
             , m_lock(nullptr)
+            , m_queueLock(nullptr)
+            , m_queueTicket(0)
+            , m_writerTicketLeaseMs(s_defaultWriterTicketLeaseMs)
         {
             // m_filePath = m_directory + "\\" + m_fileName;
         }
@@ -24,6 +49,7 @@ namespace JsonDatabase
         {
             Error err;
             unlock(err);
+            dequeueWriter();
         }
 
         const std::string& FileReadWriteLock::getFilePath() const
@@ -38,6 +64,7 @@ namespace JsonDatabase
         {
             wasLockedByOtherUserOut = false;
             err = lock_internal(direction, wasLockedByOtherUserOut);
+            dequeueWriter();
 #ifdef JD_DEBUG
             if (err != Error::none)
             {
@@ -61,6 +88,7 @@ namespace JsonDatabase
             // Calculate the time point when the desired duration will be reached
             auto end = start + std::chrono::milliseconds(timeoutMs);
             wasLockedByOtherUserOut = false;
+
             bool timeout = false;
             while ((timeout = (std::chrono::high_resolution_clock::now() < end)) &&
                 (err = lock_internal(direction, wasLockedByOtherUserOut)) != Error::none)
@@ -69,10 +97,13 @@ namespace JsonDatabase
                 // Sleep for a short while to avoid busy-waiting
                 std::this_thread::yield();
             }
+            dequeueWriter();
             if (timeout && err != Error::none)
             {
                 err = Error::fileLockTimeout;
             }
+            double waitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            addWaitStatistics(direction, waitMs, m_locked);
 #ifdef JD_DEBUG
             if (err != Error::none)
             {
@@ -135,10 +166,21 @@ namespace JsonDatabase
 
             m_access = Access::unknown;
 
-            size_t readerCount = 0;
-            bool deletedSuccessfully = tryDeleteLocks();
-            JD_UNUSED(deletedSuccessfully);
-            switch (getAccessStatus(readerCount))
+            DirectoryState state;
+            scanDirectory(state);
+            size_t readerCount = state.readerCount;
+
+            // Writers take a ticket so that new readers and later writers wait behind them
+            if (direction != Access::read && !m_queueLock)
+            {
+                Error queueErr;
+                if (!enqueueWriter(state, queueErr))
+                {
+                    if (m_logger)m_logger->logWarning("Error FileReadWriteLock::lockFile(direction=" + accessTypeToString(direction) + ") Can't enqueue writer: " + errorToString(queueErr));
+                }
+            }
+
+            switch (state.access)
             {
                 case Access::readWrite:
                 case Access::write:
@@ -157,6 +199,12 @@ namespace JsonDatabase
                 return Error::fileAlreadyLockedForReading;
             }
 
+            // Readers wait behind every queued writer, writers behind the ones with an older ticket
+            if (hasQueuedWriterBefore(state, direction == Access::read ? 0 : m_queueTicket))
+            {
+                return Error::fileLockQueuedBehindWriter;
+            }
+
 
             std::string accessType = accessTypeToString(direction);
             std::string randStr;
@@ -177,6 +225,7 @@ namespace JsonDatabase
             m_locked = true;
             m_access = direction;
             m_lockFilePathName = lockFileName;
+            dequeueWriter();
             return Error::none;
         }
         void FileReadWriteLock::unlock(Error& err)
@@ -275,6 +324,165 @@ namespace JsonDatabase
             return success;
         }
 
+        void FileReadWriteLock::scanDirectory(DirectoryState& stateOut) const
+        {
+            stateOut = DirectoryState();
+            std::vector<std::string> files = FileLock::getFileNamesInDirectory(m_directory, FileLock::s_lockFileEnding);
+            for (const std::string& file : files)
+            {
+                // Check the filename to see if it matches the file we want to lock
+                size_t pos = file.find_last_of("_");
+                if (pos == std::string::npos)
+                    continue;
+                if (file.substr(0, pos) != m_fileName)
+                    continue;
+
+                // Files which are still locked by someone can't be deleted,
+                // the ones that got deleted belonged to crashed sessions
+                if (FileLock::deleteFile(m_directory, file))
+                    continue;
+
+                size_t pos2 = file.find_last_of("-");
+                if (pos2 == std::string::npos || pos2 < pos)
+                    continue;
+                std::string accessType = file.substr(pos + 1, pos2 - pos - 1);
+                if (accessType == s_writerQueueTag)
+                {
+                    std::string ticketStr = file.substr(pos2 + 1);
+                    char* end = nullptr;
+                    unsigned long long ticket = std::strtoull(ticketStr.c_str(), &end, 10);
+                    if (ticket != 0 && end && *end == '\0')
+                        stateOut.tickets.push_back(ticket);
+                    continue;
+                }
+                switch (stringToAccessType(accessType))
+                {
+                case Access::readWrite:
+                {
+                    stateOut.access = Access::readWrite;
+                    break;
+                }
+                case Access::write:
+                {
+                    if (stateOut.access != Access::readWrite)
+                        stateOut.access = Access::write;
+                    break;
+                }
+                case Access::read:
+                {
+                    ++stateOut.readerCount;
+                    if (stateOut.access == Access::unknown)
+                        stateOut.access = Access::read;
+                    break;
+                }
+                }
+            }
+        }
+
+        bool FileReadWriteLock::enqueueWriter(const DirectoryState& state, Error& err)
+        {
+            err = Error::none;
+            if (m_queueLock)
+                return true;
+            // The meta lock is held, so no other session can take the same ticket
+            unsigned long long ticket = 1;
+            for (unsigned long long other : state.tickets)
+                if (other >= ticket)
+                    ticket = other + 1;
+            m_queueLock = new FileLock(m_directory, m_fileName + "_" + s_writerQueueTag + "-" + ticketToString(ticket), m_logger);
+            if (!m_queueLock->lock(err))
+            {
+                delete m_queueLock;
+                m_queueLock = nullptr;
+                return false;
+            }
+            m_queueTicket = ticket;
+            return true;
+        }
+        void FileReadWriteLock::dequeueWriter()
+        {
+            if (!m_queueLock)
+                return;
+            Error err;
+            m_queueLock->unlock(err);
+            delete m_queueLock;
+            m_queueLock = nullptr;
+            m_queueTicket = 0;
+        }
+        bool FileReadWriteLock::hasQueuedWriterBefore(const DirectoryState& state, unsigned long long ticket) const
+        {
+            // Readers (ticket 0) wait behind every ticket, writers behind the lower ones.
+            // A ticket which blocks longer than the lease belongs to a hung writer and gets ignored.
+            auto now = std::chrono::steady_clock::now();
+            std::string prefix = m_directory + "\\" + m_fileName + "|";
+            std::unique_lock<std::mutex> lock(s_ticketMutex);
+
+            // Forget the tickets which are gone
+            for (auto it = s_ticketFirstSeen.lower_bound(prefix); 
+                 it != s_ticketFirstSeen.end() && it->first.compare(0, prefix.size(), prefix) == 0;)
+            {
+                unsigned long long seen = std::strtoull(it->first.c_str() + prefix.size(), nullptr, 10);
+                if (std::find(state.tickets.begin(), state.tickets.end(), seen) == state.tickets.end())
+                    it = s_ticketFirstSeen.erase(it);
+                else
+                    ++it;
+            }
+
+            bool queued = false;
+            for (unsigned long long other : state.tickets)
+            {
+                if (other == ticket || (ticket != 0 && other > ticket))
+                    continue;
+                auto seen = s_ticketFirstSeen.emplace(prefix + ticketToString(other), now).first;
+                if (now - seen->second < std::chrono::milliseconds(m_writerTicketLeaseMs))
+                    queued = true;
+            }
+            return queued;
+        }
+        std::string FileReadWriteLock::ticketToString(unsigned long long ticket)
+        {
+            // Zero padded, so that the ticket files sort in queue order
+            std::stringstream ss;
+            ss << std::setw(20) << std::setfill('0') << ticket;
+            return ss.str();
+        }
+
+        void FileReadWriteLock::setWriterTicketLease(unsigned int leaseMs)
+        {
+            m_writerTicketLeaseMs = leaseMs;
+        }
+        unsigned int FileReadWriteLock::getWriterTicketLease() const
+        {
+            return m_writerTicketLeaseMs;
+        }
+
+        FileReadWriteLock::WaitStatistics FileReadWriteLock::getWaitStatistics(Access direction)
+        {
+            std::unique_lock<std::mutex> lock(s_statisticsMutex);
+            if (direction == Access::read)
+                return s_readStatistics;
+            return s_writeStatistics;
+        }
+        void FileReadWriteLock::resetWaitStatistics()
+        {
+            std::unique_lock<std::mutex> lock(s_statisticsMutex);
+            s_readStatistics = WaitStatistics();
+            s_writeStatistics = WaitStatistics();
+        }
+        void FileReadWriteLock::addWaitStatistics(Access direction, double waitMs, bool success)
+        {
+            std::unique_lock<std::mutex> lock(s_statisticsMutex);
+            WaitStatistics& stats = (direction == Access::read) ? s_readStatistics : s_writeStatistics;
+            if (success)
+                ++stats.lockCount;
+            else
+                ++stats.timeoutCount;
+            stats.totalWaitMs += waitMs;
+            stats.lastWaitMs = waitMs;
+            if (waitMs > stats.maxWaitMs)
+                stats.maxWaitMs = waitMs;
+        }
+
         const std::string& FileReadWriteLock::accessTypeToString(Access access)
         {
             switch (access)
@@ -10,6 +10,10 @@
 
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <chrono>
 
 namespace JsonDatabase
 {
@@ -451,6 +455,20 @@ namespace JsonDatabase
             return writeFile_internal(fileData);
         }
 
+        std::string LockedFileAccessor::getGenerationFilePath(const std::string& fullFilePath)
+        {
+            return fullFilePath + ".gen";
+        }
+        bool LockedFileAccessor::readGeneration(const std::string& fullFilePath, unsigned long long& generationOut)
+        {
+            generationOut = 0;
+            std::ifstream file(getGenerationFilePath(fullFilePath));
+            if (!file.is_open())
+                return false;
+            file >> generationOut;
+            return !file.fail();
+        }
+
         Error LockedFileAccessor::readFile_internal(QByteArray& fileDataOut) const
         {
             JDFILE_IO_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
@@ -651,7 +669,68 @@ namespace JsonDatabase
                 return Error::cantVerifyFileContents;
             }
             JDFILE_IO_PROFILING_END_BLOCK;
+
+            if (!incrementGeneration())
+            {
+                if (m_logger)m_logger->logWarning("bool LockedFileAccessor::writeFile(QByteArray&) Could not update the generation file of " + filePath);
+            }
             return Error::none;
         }
+        Error LockedFileAccessor::markAsChanged() const
+        {
+            JDFILE_IO_PROFILING_FUNCTION(JD_COLOR_STAGE_6);
+            if (!isLocked())
+            {
+                if (m_logger)m_logger->logError("LockedFileAccessor::markAsChanged() File is not locked");
+                return Error::fileNotLocked;
+            }
+            std::string filePath = getFullFilePath();
+            std::error_code ec;
+            std::filesystem::last_write_time(filePath, std::filesystem::file_time_type::clock::now(), ec);
+            if (ec)
+            {
+                if (m_logger)m_logger->logError("LockedFileAccessor::markAsChanged() Can't update the modification time of " + filePath + " " + ec.message());
+                return Error::cantWriteFile;
+            }
+            if (!incrementGeneration())
+            {
+                if (m_logger)m_logger->logWarning("LockedFileAccessor::markAsChanged() Could not update the generation file of " + filePath);
+            }
+            return Error::none;
+        }
+        bool LockedFileAccessor::incrementGeneration() const
+        {
+            // Called while the write lock is held, no other writer can interfere
+            JDFILE_IO_PROFILING_FUNCTION(JD_COLOR_STAGE_7);
+            std::string filePath = getFullFilePath();
+            unsigned long long generation = 0;
+            readGeneration(filePath, generation);
+
+            // Write to a temporary file and replace the generation file with it,
+            // so that a reader never sees a partially written value
+            std::string generationFilePath = getGenerationFilePath(filePath);
+            std::string tmpFilePath = generationFilePath + ".tmp";
+            {
+                std::ofstream file(tmpFilePath, std::ios::trunc);
+                if (!file.is_open())
+                    return false;
+                file << (generation + 1);
+                file.close();
+                if (file.fail())
+                    return false;
+            }
+
+            // A reader may have the generation file open for a short moment
+            std::error_code ec;
+            for (int attempt = 0; attempt < 10; ++attempt)
+            {
+                std::filesystem::rename(tmpFilePath, generationFilePath, ec);
+                if (!ec)
+                    return true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::filesystem::remove(tmpFilePath, ec);
+            return false;
+        }
 	}
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "Item.h"
+
+
+JD_OBJECT_IMPL(Item);
+
+Item::Item(const Item& other)
+    : JDObjectInterface(other)
+    , name("name")
+    , description("description")
+{
+    addValue(name);
+    addValue(description);
+
+    loadFrom(&other);
+}
+Item::Item(const std::string& name, const std::string& description)
+    : JDObjectInterface()
+    , name("name")
+    , description("description")
+{
+    addValue(this->name);
+    addValue(this->description);
+
+    this->name = name;
+    this->description = description;
+}
+Item::Item()
+    : JDObjectInterface()
+    , name("name")
+    , description("description")
+{
+    addValue(name);
+    addValue(description);
+}
+Item::~Item()
+{
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "JsonDatabase.h"
+#include <string>
+
+using namespace JsonDatabase;
+
+// Test object which tracks its changes with JDObjectValue's
+class Item : public JDObjectInterface
+{
+    JD_OBJECT(Item)
+public:
+    Item(const std::string& name, const std::string& description);
+    Item();
+    ~Item();
+
+    JDObjectValue<std::string> name;
+    JDObjectValue<std::string> description;
+};
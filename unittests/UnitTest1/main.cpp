@@ -15,7 +15,20 @@
 // Instantiate Tests here:
 // TEST_INSTANTIATE(Test_simple); // Where Test_simple is a derived class from the Test class
 TEST_INSTANTIATE(TST_stringUtilities);
+TEST_INSTANTIATE(TST_objectContainer);
+TEST_INSTANTIATE(TST_fileLocks);
+TEST_INSTANTIATE(TST_locks);
+TEST_INSTANTIATE(TST_asyncWork);
+TEST_INSTANTIATE(TST_idAllocator);
+TEST_INSTANTIATE(TST_addObjects);
+TEST_INSTANTIATE(TST_fileWatcher);
+TEST_INSTANTIATE(TST_changeJournal);
+TEST_INSTANTIATE(TST_leases);
+TEST_INSTANTIATE(TST_loadObjects);
+TEST_INSTANTIATE(TST_contentHash);
+TEST_INSTANTIATE(TST_changeHistory);
 //TEST_INSTANTIATE(TST_readWrite);
+//TEST_INSTANTIATE(TST_objectContainerBenchmark); // Benchmark, not part of the default run
 
 int main(int argc, char* argv[])
 {
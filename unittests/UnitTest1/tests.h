@@ -4,4 +4,17 @@
 #include "tests/TST_simple.h"
 #include "tests/TST_readWrite.h"
 #include "tests/TST_stringUtilities.h"
+#include "tests/TST_objectContainer.h"
+#include "tests/TST_objectContainerBenchmark.h"
+#include "tests/TST_fileLocks.h"
+#include "tests/TST_locks.h"
+#include "tests/TST_asyncWork.h"
+#include "tests/TST_idAllocator.h"
+#include "tests/TST_addObjects.h"
+#include "tests/TST_fileWatcher.h"
+#include "tests/TST_changeJournal.h"
+#include "tests/TST_leases.h"
+#include "tests/TST_loadObjects.h"
+#include "tests/TST_contentHash.h"
+#include "tests/TST_changeHistory.h"
 //#include "test_nasted.h"
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+#include <unordered_set>
+
+#include "JsonDatabase.h"
+#include "Person.h"
+
+
+using namespace JsonDatabase;
+
+class TST_addObjects : public UnitTest::Test
+{
+	TEST_CLASS(TST_addObjects)
+public:
+	TST_addObjects()
+		: Test("TST_addObjects")
+	{
+		ADD_TEST(TST_addObjects::createInstances);
+		ADD_TEST(TST_addObjects::batchAdd);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+	}
+
+private:
+	std::string dbPath = "TestAddDB";
+	std::string dbName = "DBName";
+	std::string dbUser = "User";
+
+	// Tests
+	TEST_FUNCTION(createInstances)
+	{
+		TEST_START;
+		size_t emitCount = 0;
+		size_t emittedObjs = 0;
+		JDManager db;
+		TEST_ASSERT(db.setup(dbPath, dbName, dbUser));
+
+		QObject::connect(&db, &JDManager::objectAdded, [&](std::vector<JDObject> objs)
+						 {
+							 ++emitCount;
+							 emittedObjs += objs.size();
+						 });
+
+		std::vector<std::shared_ptr<Person>> persons = db.createInstances<Person>(100);
+		TEST_ASSERT(persons.size() == 100);
+		TEST_ASSERT(db.getObjectCount() == 100);
+
+		std::unordered_set<JDObjectID::IDType> ids;
+		for (const std::shared_ptr<Person>& person : persons)
+		{
+			TEST_ASSERT(person->isManaged());
+			TEST_ASSERT(ids.insert(person->getObjectID()->get()).second);
+		}
+
+		// All objects of the batch are in one signal
+		db.update();
+		TEST_ASSERT(emitCount == 1);
+		TEST_ASSERT(emittedObjs == 100);
+
+		Error err;
+		TEST_ASSERT(db.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(batchAdd)
+	{
+		TEST_START;
+		size_t emitCount = 0;
+		size_t emittedObjs = 0;
+		JDManager db;
+		TEST_ASSERT(db.setup(dbPath, dbName + "_batch", dbUser));
+
+		QObject::connect(&db, &JDManager::objectAdded, [&](std::vector<JDObject> objs)
+						 {
+							 ++emitCount;
+							 emittedObjs += objs.size();
+						 });
+
+		// The managed and the duplicate object fail, the others get added
+		std::vector<JDObject> managed = createPersons();
+		TEST_ASSERT(db.addObject(managed[0]));
+		db.update();
+		emitCount = 0;
+		emittedObjs = 0;
+
+		std::vector<JDObject> persons = createPersons();
+		std::vector<JDObject> batch = persons;
+		batch.push_back(persons[0]);
+		batch.push_back(managed[0]);
+		TEST_ASSERT(!db.addObject(batch));
+		TEST_ASSERT(db.getObjectCount() == persons.size() + 1);
+
+		std::unordered_set<JDObjectID::IDType> ids;
+		ids.insert(managed[0]->getObjectID()->get());
+		for (const JDObject& person : persons)
+		{
+			TEST_ASSERT(person->isManaged());
+			TEST_ASSERT(ids.insert(person->getObjectID()->get()).second);
+		}
+
+		db.update();
+		TEST_ASSERT(emitCount == 1);
+		TEST_ASSERT(emittedObjs == persons.size());
+
+		Error err;
+		TEST_ASSERT(db.unlockAllObjs(err));
+	}
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+#include <thread>
+#include <chrono>
+#include <coroutine>
+#include <atomic>
+
+#include "JsonDatabase.h"
+#include "manager/async/JDAsyncHandle.h"
+#include "utilities/filesystem/LockedFileAccessor.h"
+#include "Person.h"
+
+
+using namespace JsonDatabase;
+using namespace JsonDatabase::Internal;
+
+class TST_asyncWork : public UnitTest::Test
+{
+	TEST_CLASS(TST_asyncWork)
+public:
+	TST_asyncWork()
+		: Test("TST_asyncWork")
+	{
+		ADD_TEST(TST_asyncWork::loadAfterSave);
+		ADD_TEST(TST_asyncWork::cancelQueuedWork);
+		ADD_TEST(TST_asyncWork::deadlineExceeded);
+		ADD_TEST(TST_asyncWork::continuationOrder);
+		ADD_TEST(TST_asyncWork::waitForResult);
+		ADD_TEST(TST_asyncWork::coroutineResume);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+	}
+
+private:
+	std::string dbPath = "TestAsyncDB";
+	std::string dbName = "DBName";
+	std::string dbUser = "User";
+
+	// Coroutine which runs until the end without a result, used to await a handle
+	struct AwaitTask
+	{
+		struct promise_type
+		{
+			AwaitTask get_return_object() { return {}; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+	// result is -1 until the coroutine got resumed
+	static AwaitTask awaitHandle(JDAsyncHandle handle, std::atomic<int>& result, std::thread::id& resumedOn)
+	{
+		bool success = co_await handle;
+		resumedOn = std::this_thread::get_id();
+		result.store(success ? 1 : 0);
+	}
+
+	// Tests
+	TEST_FUNCTION(loadAfterSave)
+	{
+		TEST_START;
+		JDManager db;
+		TEST_ASSERT(db.setup(dbPath, dbName, dbUser));
+
+		std::vector<JDObject> persons = createPersons();
+		TEST_ASSERT(db.addObject(persons));
+		Person* person = dynamic_cast<Person*>(persons[0].get());
+		TEST_ASSERT(person != nullptr);
+		person->age = "42";
+
+		// The object is not in the database file before the save,
+		// a load that passes the save can't find it
+		JDAsyncHandle save = db.saveObjectAsync(persons[0]);
+		JDAsyncHandle load = db.loadObjectAsync(persons[0]);
+		TEST_ASSERT(save.waitFor(10000));
+		TEST_ASSERT(load.waitFor(10000));
+		TEST_ASSERT(save.hasSucceeded());
+		TEST_ASSERT(load.hasSucceeded());
+		TEST_ASSERT(person->age == "42");
+
+		JDManager db2;
+		TEST_ASSERT(db2.setup(dbPath, dbName, dbUser));
+		TEST_ASSERT(db2.loadObjects());
+		Person* loaded = dynamic_cast<Person*>(db2.getObject(persons[0]->getObjectID()->get()).get());
+		TEST_ASSERT(loaded != nullptr);
+		TEST_ASSERT(loaded->age == "42");
+
+		Error err;
+		TEST_ASSERT(db.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(cancelQueuedWork)
+	{
+		TEST_START;
+		JDManager db;
+		TEST_ASSERT(db.setup(dbPath, dbName + "_cancel", dbUser));
+		db.setWorkerCount(1);
+		std::vector<JDObject> persons = createPersons();
+		TEST_ASSERT(db.addObject(persons));
+
+		// The save waits for the database file, the load stays queued behind it
+		LockedFileAccessor blocker(db.getDatabasePath(), db.getDatabaseFileName(), JDManager::getJsonFileEnding(), nullptr);
+		TEST_ASSERT(blocker.lock(LockedFileAccessor::AccessMode::readWrite) == Error::none);
+		JDAsyncHandle save = db.saveObjectsAsync();
+		JDAsyncHandle load = db.loadObjectsAsync();
+		load.cancel();
+		TEST_ASSERT(load.isCancelled());
+		TEST_ASSERT(!save.isCancelled());
+		TEST_ASSERT(blocker.unlock() == Error::none);
+
+		// Cancelled work completes as failed, the work before it is not affected
+		TEST_ASSERT(save.waitFor(10000));
+		TEST_ASSERT(load.waitFor(10000));
+		TEST_ASSERT(save.hasSucceeded());
+		TEST_ASSERT(!load.hasSucceeded());
+		TEST_ASSERT(!load.wait());
+
+		Error err;
+		TEST_ASSERT(db.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(deadlineExceeded)
+	{
+		TEST_START;
+		JDManager db;
+		TEST_ASSERT(db.setup(dbPath, dbName + "_deadline", dbUser));
+		db.setWorkerCount(1);
+		std::vector<JDObject> persons = createPersons();
+		TEST_ASSERT(db.addObject(persons));
+
+		LockedFileAccessor blocker(db.getDatabasePath(), db.getDatabaseFileName(), JDManager::getJsonFileEnding(), nullptr);
+		TEST_ASSERT(blocker.lock(LockedFileAccessor::AccessMode::readWrite) == Error::none);
+		JDAsyncHandle save = db.saveObjectsAsync();
+		JDAsyncHandle load = db.loadObjectsAsync();
+		load.setDeadline(1);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		TEST_ASSERT(blocker.unlock() == Error::none);
+
+		// The deadline passed while the load was queued, it is not a cancellation
+		TEST_ASSERT(load.waitFor(10000));
+		TEST_ASSERT(save.hasSucceeded());
+		TEST_ASSERT(!load.hasSucceeded());
+		TEST_ASSERT(!load.isCancelled());
+
+		Error err;
+		TEST_ASSERT(db.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(continuationOrder)
+	{
+		TEST_START;
+		// Pending work runs its continuations in the order they were added
+		std::shared_ptr<JDAsyncState> state = std::make_shared<JDAsyncState>();
+		JDAsyncHandle pending(state);
+		std::vector<int> order;
+		std::vector<bool> results;
+		pending.then([&](bool success) { order.push_back(1); results.push_back(success); })
+			   .then([&](bool success) { order.push_back(2); results.push_back(success); });
+		pending.then([&](bool success) { order.push_back(3); results.push_back(success); });
+		TEST_ASSERT(order.size() == 0);
+		state->complete(true);
+		TEST_ASSERT(order == std::vector<int>({ 1, 2, 3 }));
+		TEST_ASSERT(results == std::vector<bool>({ true, true, true }));
+
+		// A second completion does not run them again
+		state->complete(false);
+		TEST_ASSERT(order.size() == 3);
+
+		// Continuations of finished work run immediately, with the result of the work
+		std::shared_ptr<JDAsyncState> failedState = std::make_shared<JDAsyncState>();
+		failedState->complete(false);
+		JDAsyncHandle finished(failedState);
+		order.clear();
+		results.clear();
+		finished.then([&](bool success) { order.push_back(1); results.push_back(success); });
+		order.push_back(2);
+		finished.then([&](bool success) { order.push_back(3); results.push_back(success); });
+		TEST_ASSERT(order == std::vector<int>({ 1, 2, 3 }));
+		TEST_ASSERT(results == std::vector<bool>({ false, false }));
+
+		// A handle without work behaves like failed work
+		JDAsyncHandle invalid;
+		results.clear();
+		invalid.then([&](bool success) { results.push_back(success); });
+		TEST_ASSERT(results == std::vector<bool>({ false }));
+	}
+
+	TEST_FUNCTION(waitForResult)
+	{
+		TEST_START;
+		std::shared_ptr<JDAsyncState> state = std::make_shared<JDAsyncState>();
+		JDAsyncHandle handle(state);
+		TEST_ASSERT(!handle.waitFor(20));
+		TEST_ASSERT(!handle.isDone());
+
+		std::thread worker([state]()
+						   {
+							   std::this_thread::sleep_for(std::chrono::milliseconds(50));
+							   state->complete(true);
+						   });
+		TEST_ASSERT(handle.waitFor(10000));
+		TEST_ASSERT(handle.isDone());
+		TEST_ASSERT(handle.hasSucceeded());
+		TEST_ASSERT(handle.wait());
+		worker.join();
+
+		// Finished work returns immediately
+		TEST_ASSERT(handle.waitFor(0));
+
+		JDAsyncHandle invalid;
+		TEST_ASSERT(invalid.waitFor(0));
+		TEST_ASSERT(!invalid.wait());
+	}
+
+	TEST_FUNCTION(coroutineResume)
+	{
+		TEST_START;
+		// The coroutine gets resumed on the thread which completes the work
+		std::shared_ptr<JDAsyncState> state = std::make_shared<JDAsyncState>();
+		std::atomic<int> result = -1;
+		std::thread::id resumedOn;
+		awaitHandle(JDAsyncHandle(state), result, resumedOn);
+		TEST_ASSERT(result.load() == -1);
+
+		std::thread::id completedOn;
+		std::thread worker([state, &completedOn]()
+						   {
+							   completedOn = std::this_thread::get_id();
+							   state->complete(true);
+						   });
+		worker.join();
+		TEST_ASSERT(result.load() == 1);
+		TEST_ASSERT(resumedOn == completedOn);
+
+		// Finished work does not suspend the coroutine
+		std::shared_ptr<JDAsyncState> failedState = std::make_shared<JDAsyncState>();
+		failedState->complete(false);
+		result.store(-1);
+		awaitHandle(JDAsyncHandle(failedState), result, resumedOn);
+		TEST_ASSERT(result.load() == 0);
+		TEST_ASSERT(resumedOn == std::this_thread::get_id());
+
+		// Work that completes between await_ready() and await_suspend() resumes the coroutine immediately
+		JDAsyncHandle finished(failedState);
+		TEST_ASSERT(!finished.await_suspend(std::noop_coroutine()));
+		TEST_ASSERT(!finished.await_resume());
+		JDAsyncHandle pending(std::make_shared<JDAsyncState>());
+		TEST_ASSERT(!pending.await_ready());
+		TEST_ASSERT(pending.await_suspend(std::noop_coroutine()));
+	}
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <algorithm>
+
+#include "JsonDatabase.h"
+
+
+using namespace JsonDatabase;
+
+class TST_changeHistory : public UnitTest::Test
+{
+	TEST_CLASS(TST_changeHistory)
+public:
+	TST_changeHistory()
+		: Test("TST_changeHistory")
+	{
+		ADD_TEST(TST_changeHistory::ringBufferOrder);
+		ADD_TEST(TST_changeHistory::shrinkingLimit);
+		ADD_TEST(TST_changeHistory::modeSwitch);
+		ADD_TEST(TST_changeHistory::heldChangeNotRecycled);
+	}
+
+private:
+	static void setValues(JDObjectValue<long>& value, long from, long to)
+	{
+		for (long i = from; i <= to; ++i)
+			value = i;
+	}
+	// New values of the changes, from the oldest to the newest
+	static std::vector<long> getNewValues(const JDObjectValue<long>& value)
+	{
+		std::vector<long> values;
+		for (const std::shared_ptr<IChangeTransaction>& change : value.getValueChangeTransactions())
+		{
+			const ValueChangeTransaction* valueChange = dynamic_cast<const ValueChangeTransaction*>(change.get());
+			values.push_back(valueChange ? valueChange->getNewValue().get<long>() : -1);
+		}
+		return values;
+	}
+	static std::vector<long> getOldValues(const JDObjectValue<long>& value)
+	{
+		std::vector<long> values;
+		for (const std::shared_ptr<IChangeTransaction>& change : value.getValueChangeTransactions())
+		{
+			const ValueChangeTransaction* valueChange = dynamic_cast<const ValueChangeTransaction*>(change.get());
+			values.push_back(valueChange ? valueChange->getOldValue().get<long>() : -1);
+		}
+		return values;
+	}
+	static std::vector<const IChangeTransaction*> getChangePointers(const JDObjectValue<long>& value)
+	{
+		std::vector<const IChangeTransaction*> pointers;
+		for (const std::shared_ptr<IChangeTransaction>& change : value.getValueChangeTransactions())
+			pointers.push_back(change.get());
+		return pointers;
+	}
+
+	// Tests
+	TEST_FUNCTION(ringBufferOrder)
+	{
+		TEST_START;
+		ChangeHistoryScope scope(ChangeHistoryMode::ringBuffer, 4);
+		JDObjectValue<long> value("value", 0);
+
+		setValues(value, 1, 3);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 1, 2, 3 }));
+		setValues(value, 4, 4);
+		std::vector<const IChangeTransaction*> pointers = getChangePointers(value);
+
+		// Once the buffer is full, the oldest changes get overwritten
+		setValues(value, 5, 10);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 7, 8, 9, 10 }));
+		TEST_ASSERT(getOldValues(value) == std::vector<long>({ 6, 7, 8, 9 }));
+		TEST_ASSERT(value.hasChanged());
+
+		// The overwritten changes are reused, changes 5 to 8 used the same objects as changes 1 to 4
+		std::vector<const IChangeTransaction*> reused = getChangePointers(value);
+		std::sort(pointers.begin(), pointers.end());
+		std::sort(reused.begin(), reused.end());
+		TEST_ASSERT(pointers == reused);
+
+		// Discarding goes back to the value before the first change, not the oldest kept change
+		value.discardChanges();
+		TEST_ASSERT(value == 0l);
+		TEST_ASSERT(value.getValueChangeTransactions().size() == 0);
+	}
+
+	TEST_FUNCTION(shrinkingLimit)
+	{
+		TEST_START;
+		ChangeHistoryScope scope(ChangeHistoryMode::ringBuffer, 4);
+		JDObjectValue<long> value("value", 0);
+
+		// The oldest change is in the middle of the buffer
+		setValues(value, 1, 6);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 3, 4, 5, 6 }));
+		{
+			ChangeHistoryScope smaller(ChangeHistoryMode::ringBuffer, 3);
+			setValues(value, 7, 7);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 5, 6, 7 }));
+			setValues(value, 8, 8);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 6, 7, 8 }));
+			{
+				ChangeHistoryScope single(ChangeHistoryMode::ringBuffer, 1);
+				setValues(value, 9, 9);
+				TEST_ASSERT(getNewValues(value) == std::vector<long>({ 9 }));
+			}
+			setValues(value, 10, 12);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 10, 11, 12 }));
+			setValues(value, 13, 13);
+		}
+
+		// A larger limit keeps the order and fills up before it overwrites again
+		setValues(value, 14, 14);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 11, 12, 13, 14 }));
+		setValues(value, 15, 15);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 12, 13, 14, 15 }));
+		TEST_ASSERT(getOldValues(value) == std::vector<long>({ 11, 12, 13, 14 }));
+	}
+
+	TEST_FUNCTION(modeSwitch)
+	{
+		TEST_START;
+		JDObjectValue<long> value("value", 0);
+		{
+			ChangeHistoryScope ringBuffer(ChangeHistoryMode::ringBuffer, 3);
+			setValues(value, 1, 5);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 3, 4, 5 }));
+		}
+		{
+			// The full history appends after the newest change
+			ChangeHistoryScope full(ChangeHistoryMode::full);
+			setValues(value, 6, 7);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 3, 4, 5, 6, 7 }));
+		}
+		{
+			// Without a history the value changes, the recorded changes stay as they are
+			ChangeHistoryScope off(ChangeHistoryMode::off);
+			setValues(value, 8, 8);
+			TEST_ASSERT(value == 8l);
+			TEST_ASSERT(value.hasChanged());
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 3, 4, 5, 6, 7 }));
+		}
+		{
+			// Switching back to a ring buffer drops the oldest changes of the full history
+			ChangeHistoryScope ringBuffer(ChangeHistoryMode::ringBuffer, 3);
+			setValues(value, 9, 9);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 6, 7, 9 }));
+			TEST_ASSERT(getOldValues(value) == std::vector<long>({ 5, 6, 8 }));
+			setValues(value, 10, 10);
+		}
+		{
+			ChangeHistoryScope full(ChangeHistoryMode::full);
+			setValues(value, 11, 11);
+			TEST_ASSERT(getNewValues(value) == std::vector<long>({ 7, 9, 10, 11 }));
+		}
+
+		// Going back to the original value clears the history in every mode
+		{
+			ChangeHistoryScope ringBuffer(ChangeHistoryMode::ringBuffer, 3);
+			value = 0l;
+			TEST_ASSERT(!value.hasChanged());
+			TEST_ASSERT(value.getValueChangeTransactions().size() == 0);
+		}
+	}
+
+	TEST_FUNCTION(heldChangeNotRecycled)
+	{
+		TEST_START;
+		ChangeHistoryScope scope(ChangeHistoryMode::ringBuffer, 3);
+		JDObjectValue<long> value("value", 0);
+		setValues(value, 1, 3);
+
+		// The oldest change is held outside of the history, the next change must not overwrite it
+		std::shared_ptr<IChangeTransaction> held = value.getValueChangeTransactions()[0];
+		const ValueChangeTransaction* heldChange = dynamic_cast<const ValueChangeTransaction*>(held.get());
+		TEST_ASSERT(heldChange != nullptr);
+		const IChangeTransaction* secondOldest = getChangePointers(value)[1];
+		setValues(value, 4, 4);
+		TEST_ASSERT(heldChange->getOldValue().get<long>() == 0);
+		TEST_ASSERT(heldChange->getNewValue().get<long>() == 1);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 2, 3, 4 }));
+		std::vector<const IChangeTransaction*> pointers = getChangePointers(value);
+		TEST_ASSERT(std::find(pointers.begin(), pointers.end(), held.get()) == pointers.end());
+
+		// Changes nobody else holds are still reused
+		setValues(value, 5, 5);
+		TEST_ASSERT(getNewValues(value) == std::vector<long>({ 3, 4, 5 }));
+		TEST_ASSERT(getChangePointers(value)[2] == secondOldest);
+		TEST_ASSERT(heldChange->getNewValue().get<long>() == 1);
+	}
+};
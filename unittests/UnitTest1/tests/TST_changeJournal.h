@@ -0,0 +1,273 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+#include <fstream>
+#include <sstream>
+
+#include "JsonDatabase.h"
+#include "manager/JDChangeJournal.h"
+#include "Item.h"
+
+
+using namespace JsonDatabase;
+using namespace JsonDatabase::Internal;
+
+class TST_changeJournal : public UnitTest::Test
+{
+	TEST_CLASS(TST_changeJournal)
+public:
+	TST_changeJournal()
+		: Test("TST_changeJournal")
+	{
+		ADD_TEST(TST_changeJournal::appendAndRead);
+		ADD_TEST(TST_changeJournal::compaction);
+		ADD_TEST(TST_changeJournal::epochReset);
+		ADD_TEST(TST_changeJournal::incrementalLoadOrder);
+		ADD_TEST(TST_changeJournal::fullLoadFallback);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+		dbDir.mkpath(".");
+	}
+
+private:
+	std::string dbPath = "TestJournalDB";
+	std::string dbName = "DBName";
+
+	static JsonObject createEntryData(JDObjectID::IDType id, const std::string& name)
+	{
+		JsonObject obj;
+		obj[JDObjectInterface::s_tag_objID] = JsonValue(id);
+		obj["name"] = JsonValue(name);
+		return obj;
+	}
+	static JDChangeJournal::FileStamp createStamp(unsigned long long generation)
+	{
+		JDChangeJournal::FileStamp stamp;
+		stamp.generation = generation;
+		stamp.fileSize = 100 + generation;
+		stamp.modificationTime = 1000 + (long long)generation;
+		return stamp;
+	}
+	static bool readFile(const std::string& path, std::string& contentOut)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		contentOut = buffer.str();
+		return true;
+	}
+	static bool writeFile(const std::string& path, const std::string& content)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+		file << content;
+		file.close();
+		return !file.fail();
+	}
+
+	// Tests
+	TEST_FUNCTION(appendAndRead)
+	{
+		TEST_START;
+		JDChangeJournal journal(dbPath + "/appendAndRead.json", nullptr);
+		JDChangeJournal::State state;
+		int64_t firstSequence;
+
+		JsonObject obj1 = createEntryData(1, "first");
+		JsonObject obj2 = createEntryData(2, "second");
+		TEST_ASSERT(journal.append({ &obj1, &obj2 }, { 3 }, createStamp(1), state, firstSequence));
+		TEST_ASSERT(firstSequence == 1);
+		TEST_ASSERT(state.lastSequence == 3);
+		TEST_ASSERT(state.epoch.size() != 0);
+
+		std::vector<JDChangeJournal::Entry> entries;
+		JDChangeJournal::State readState;
+		TEST_ASSERT(journal.read(0, entries, readState));
+		TEST_ASSERT(entries.size() == 3);
+		TEST_ASSERT(readState.epoch == state.epoch);
+		TEST_ASSERT(readState.lastSequence == 3);
+		TEST_ASSERT(readState.lastFileStamp == createStamp(1));
+		TEST_ASSERT(entries[0].objectID == 1 && entries[0].operation == JDChangeJournal::Operation::upsert);
+		TEST_ASSERT(entries[1].objectID == 2 && entries[1].operation == JDChangeJournal::Operation::upsert);
+		TEST_ASSERT(entries[2].objectID == 3 && entries[2].operation == JDChangeJournal::Operation::remove);
+		TEST_ASSERT(entries[1].data["name"].get<std::string>() == "second");
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			TEST_ASSERT(entries[i].sequence == (int64_t)i + 1);
+			TEST_ASSERT(entries[i].fileStamp == createStamp(1));
+		}
+
+		// Only the entries after the known sequence get returned
+		TEST_ASSERT(journal.append({ &obj1 }, {}, createStamp(2), state, firstSequence));
+		TEST_ASSERT(firstSequence == 4);
+		TEST_ASSERT(journal.read(3, entries, readState));
+		TEST_ASSERT(entries.size() == 1);
+		TEST_ASSERT(entries[0].sequence == 4);
+		TEST_ASSERT(entries[0].fileStamp == createStamp(2));
+
+		TEST_ASSERT(journal.readState(readState));
+		TEST_ASSERT(readState.epoch == state.epoch);
+		TEST_ASSERT(readState.firstSequence == 1);
+		TEST_ASSERT(readState.lastSequence == 4);
+		TEST_ASSERT(readState.lastFileStamp == createStamp(2));
+	}
+
+	TEST_FUNCTION(compaction)
+	{
+		TEST_START;
+		size_t maxEntries = JDChangeJournal::getMaxEntries();
+		JDChangeJournal::setMaxEntries(5);
+		JDChangeJournal journal(dbPath + "/compaction.json", nullptr);
+		JDChangeJournal::State state;
+		int64_t firstSequence;
+		std::string epoch;
+
+		JsonObject obj = createEntryData(1, "value");
+		for (unsigned long long i = 1; i <= 11; ++i)
+		{
+			TEST_ASSERT(journal.append({ &obj }, {}, createStamp(i), state, firstSequence));
+			if (i == 1)
+				epoch = state.epoch;
+		}
+		JDChangeJournal::setMaxEntries(maxEntries);
+
+		// Compacting keeps the epoch, a client can still continue from the kept entries
+		TEST_ASSERT(state.epoch == epoch);
+		TEST_ASSERT(state.firstSequence == 7);
+		TEST_ASSERT(state.lastSequence == 11);
+
+		std::vector<JDChangeJournal::Entry> entries;
+		JDChangeJournal::State readState;
+		TEST_ASSERT(journal.read(0, entries, readState));
+		TEST_ASSERT(entries.size() == 5);
+		TEST_ASSERT(entries.front().sequence == 7);
+		TEST_ASSERT(entries.back().fileStamp == createStamp(11));
+	}
+
+	TEST_FUNCTION(epochReset)
+	{
+		TEST_START;
+		std::string path = dbPath + "/epochReset.json";
+		JDChangeJournal journal(path, nullptr);
+		JDChangeJournal::State state;
+		int64_t firstSequence;
+
+		JsonObject obj = createEntryData(1, "value");
+		TEST_ASSERT(journal.append({ &obj }, {}, createStamp(1), state, firstSequence));
+		TEST_ASSERT(journal.append({ &obj }, {}, createStamp(2), state, firstSequence));
+		std::string epoch = state.epoch;
+
+		// A corrupted journal can't be read and gets reset by the next writer
+		TEST_ASSERT(writeFile(path, "corrupted"));
+		std::vector<JDChangeJournal::Entry> entries;
+		JDChangeJournal::State readState;
+		TEST_ASSERT(!journal.read(0, entries, readState));
+
+		TEST_ASSERT(journal.append({ &obj }, {}, createStamp(3), state, firstSequence));
+		TEST_ASSERT(state.epoch.size() != 0);
+		TEST_ASSERT(state.epoch != epoch);
+		TEST_ASSERT(firstSequence == 1);
+		TEST_ASSERT(journal.read(0, entries, readState));
+		TEST_ASSERT(readState.epoch == state.epoch);
+		TEST_ASSERT(entries.size() == 1);
+	}
+
+	TEST_FUNCTION(incrementalLoadOrder)
+	{
+		TEST_START;
+		JDManager writer;
+		JDManager reader;
+		TEST_ASSERT(writer.setup(dbPath, dbName + "_order", "Writer"));
+		TEST_ASSERT(reader.setup(dbPath, dbName + "_order", "Reader"));
+
+		std::vector<std::shared_ptr<Item>> items;
+		for (size_t i = 0; i < 5; ++i)
+			items.push_back(std::make_shared<Item>("item" + std::to_string(i), ""));
+		for (const std::shared_ptr<Item>& item : items)
+			TEST_ASSERT(writer.addObject(item));
+		TEST_ASSERT(writer.saveObjects());
+		TEST_ASSERT(reader.loadObjects(LoadMode::allObjects, nullptr));
+		TEST_ASSERT(reader.getObjectCount() == items.size());
+
+		std::vector<JDObjectID::IDType> changedIDs;
+		QObject::connect(&reader, &JDManager::objectChanged, [&](std::vector<JDObject> objs)
+						 {
+							 for (const JDObject& obj : objs)
+								 changedIDs.push_back(obj->getObjectID()->get());
+						 });
+
+		// Saved in a different order than the IDs, item 3 gets saved twice
+		std::vector<size_t> saveOrder = { 3, 1, 4, 3 };
+		for (size_t i = 0; i < saveOrder.size(); ++i)
+		{
+			items[saveOrder[i]]->name = "changed" + std::to_string(i);
+			TEST_ASSERT(writer.saveObjects({ items[saveOrder[i]] }));
+		}
+		TEST_ASSERT(reader.loadObjects(LoadMode::allObjects | LoadMode::incremental, nullptr));
+		reader.update();
+
+		// Only the latest change of each object is applied, in the order of the journal
+		std::vector<JDObjectID::IDType> expected = { items[1]->getObjectID()->get(),
+													 items[4]->getObjectID()->get(),
+													 items[3]->getObjectID()->get() };
+		TEST_ASSERT(changedIDs == expected);
+		std::shared_ptr<Item> loaded = reader.getObject<Item>(items[3]->getObjectID()->get());
+		TEST_ASSERT(loaded != nullptr);
+		TEST_ASSERT(loaded->name == "changed3");
+
+		Error err;
+		TEST_ASSERT(writer.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(fullLoadFallback)
+	{
+		TEST_START;
+		JDManager writer;
+		JDManager reader;
+		TEST_ASSERT(writer.setup(dbPath, dbName + "_fallback", "Writer"));
+		TEST_ASSERT(reader.setup(dbPath, dbName + "_fallback", "Reader"));
+
+		std::shared_ptr<Item> item = std::make_shared<Item>("journal", "");
+		TEST_ASSERT(writer.addObject(item));
+		TEST_ASSERT(writer.saveObjects());
+		TEST_ASSERT(reader.loadObjects(LoadMode::allObjects, nullptr));
+		JDObjectID::IDType id = item->getObjectID()->get();
+
+		// The database file gets written without a journal entry,
+		// the journal alone would report no change
+		std::string content;
+		TEST_ASSERT(readFile(writer.getDatabaseFilePath(), content));
+		size_t pos = content.find("\"journal\"");
+		TEST_ASSERT(pos != std::string::npos);
+		content.replace(pos, 9, "\"external writer\"");
+		TEST_ASSERT(writeFile(writer.getDatabaseFilePath(), content));
+
+		TEST_ASSERT(reader.loadObjects(LoadMode::allObjects | LoadMode::incremental, nullptr));
+		std::shared_ptr<Item> loaded = reader.getObject<Item>(id);
+		TEST_ASSERT(loaded != nullptr);
+		TEST_ASSERT(loaded->name == "external writer");
+
+		// A reset journal has a new epoch, the reader falls back to a full load
+		TEST_ASSERT(writeFile(writer.getDatabaseChangeJournalFilePath(), "corrupted\n"));
+		item->name = "after reset";
+		TEST_ASSERT(writer.saveObjects());
+		TEST_ASSERT(reader.loadObjects(LoadMode::allObjects | LoadMode::incremental, nullptr));
+		loaded = reader.getObject<Item>(id);
+		TEST_ASSERT(loaded != nullptr);
+		TEST_ASSERT(loaded->name == "after reset");
+
+		Error err;
+		TEST_ASSERT(writer.unlockAllObjs(err));
+	}
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+
+#include "JsonDatabase.h"
+#include "Item.h"
+
+
+using namespace JsonDatabase;
+
+class TST_contentHash : public UnitTest::Test
+{
+	TEST_CLASS(TST_contentHash)
+public:
+	TST_contentHash()
+		: Test("TST_contentHash")
+	{
+		ADD_TEST(TST_contentHash::keyOrder);
+		ADD_TEST(TST_contentHash::nestedDifferences);
+		ADD_TEST(TST_contentHash::localChangesAreCompared);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+	}
+
+private:
+	std::string dbPath = "TestContentHashDB";
+	std::string dbName = "DBName";
+
+	static unsigned long long hashOf(const std::string& json)
+	{
+		JsonDeserializer deserializer;
+		return deserializer.deserializeValue(json).getHash();
+	}
+
+	// Tests
+	TEST_FUNCTION(keyOrder)
+	{
+		TEST_START;
+		// The order of the keys in the file does not matter, also in nested objects
+		TEST_ASSERT(hashOf("{\"a\":1,\"b\":\"text\",\"c\":{\"x\":[1,2],\"y\":true}}") ==
+					hashOf("{\"c\":{\"y\":true,\"x\":[1,2]},\"b\":\"text\",\"a\":1}"));
+		TEST_ASSERT(hashOf("[{\"a\":1.5,\"b\":null}]") == hashOf("[{\"b\":null,\"a\":1.5}]"));
+
+		JsonObject first;
+		first["name"] = JsonValue(std::string("value"));
+		first["count"] = JsonValue(5l);
+		JsonObject second;
+		second["count"] = JsonValue(5l);
+		second["name"] = JsonValue(std::string("value"));
+		TEST_ASSERT(JsonValue::getHash(first) == JsonValue::getHash(second));
+		TEST_ASSERT(JsonValue(first).getHash() == JsonValue(second).getHash());
+	}
+
+	TEST_FUNCTION(nestedDifferences)
+	{
+		TEST_START;
+		// A difference deep inside the data changes the hash
+		TEST_ASSERT(hashOf("{\"a\":{\"b\":{\"c\":[1,2,3]}}}") != hashOf("{\"a\":{\"b\":{\"c\":[1,2,4]}}}"));
+		TEST_ASSERT(hashOf("{\"a\":{\"b\":{\"c\":\"x\"}}}") != hashOf("{\"a\":{\"b\":{\"d\":\"x\"}}}"));
+		TEST_ASSERT(hashOf("[[1,2],[3]]") != hashOf("[[1],[2,3]]"));
+		TEST_ASSERT(hashOf("[[1,2]]") != hashOf("[[2,1]]"));
+		TEST_ASSERT(hashOf("[{\"a\":1},{\"b\":2}]") != hashOf("[{\"b\":2},{\"a\":1}]"));
+		TEST_ASSERT(hashOf("{\"a\":[]}") != hashOf("{\"a\":{}}"));
+		TEST_ASSERT(hashOf("{\"a\":[[]]}") != hashOf("{\"a\":[]}"));
+		TEST_ASSERT(hashOf("{\"a\":{\"b\":1}}") != hashOf("{\"a\":{\"b\":\"1\"}}"));
+		TEST_ASSERT(hashOf("{\"a\":{\"b\":1}}") != hashOf("{\"a\":{\"b\":1.0}}"));
+		TEST_ASSERT(hashOf("{\"ab\":\"c\"}") != hashOf("{\"a\":\"bc\"}"));
+
+		// Equal data gives the same hash, independent of the instance
+		TEST_ASSERT(hashOf("{\"a\":[{\"b\":[1,{\"c\":null}]}]}") == hashOf("{\"a\":[{\"b\":[1,{\"c\":null}]}]}"));
+	}
+
+	TEST_FUNCTION(localChangesAreCompared)
+	{
+		TEST_START;
+		Error err;
+		JDManager writer;
+		JDManager reader;
+		TEST_ASSERT(writer.setup(dbPath, dbName + "_local", "Writer"));
+		TEST_ASSERT(reader.setup(dbPath, dbName + "_local", "Reader"));
+
+		std::shared_ptr<Item> item = std::make_shared<Item>("original", "");
+		std::shared_ptr<Item> other = std::make_shared<Item>("other", "");
+		TEST_ASSERT(writer.addObject(item));
+		TEST_ASSERT(writer.addObject(other));
+		TEST_ASSERT(writer.saveObjects());
+		TEST_ASSERT(reader.loadObjects());
+		std::shared_ptr<Item> loaded = reader.getObject<Item>(item->getObjectID()->get());
+		std::shared_ptr<Item> loadedOther = reader.getObject<Item>(other->getObjectID()->get());
+		TEST_ASSERT(loaded != nullptr);
+		TEST_ASSERT(loadedOther != nullptr);
+		reader.update();
+
+		std::vector<JDObject> changed;
+		QObject::connect(&reader, &JDManager::objectChanged, [&](std::vector<JDObject> objs)
+						 {
+							 changed.insert(changed.end(), objs.begin(), objs.end());
+						 });
+
+		// The database entry is the same as at the last load, but the object has local changes.
+		// The stored hash must not skip the comparison, the local changes get overridden.
+		loaded->name = "local";
+		TEST_ASSERT(loaded->hasChanges());
+		TEST_ASSERT(!reader.isObjectLockedByMe(loaded, err));
+		TEST_ASSERT(reader.loadObjects());
+		reader.update();
+		TEST_ASSERT(loaded->name == "original");
+		TEST_ASSERT(changed.size() == 1);
+		TEST_ASSERT(changed.size() == 1 && changed[0] == loaded);
+
+		// Without local changes the unchanged entries are not reported again
+		changed.clear();
+		TEST_ASSERT(reader.loadObjects());
+		reader.update();
+		TEST_ASSERT(changed.size() == 0);
+		TEST_ASSERT(loadedOther->name == "other");
+
+		TEST_ASSERT(writer.unlockAllObjs(err));
+	}
+};
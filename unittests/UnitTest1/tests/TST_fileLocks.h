@@ -0,0 +1,161 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#include "JsonDatabase.h"
+#include "utilities/filesystem/FileLock.h"
+#include "utilities/filesystem/FileReadWriteLock.h"
+#include "utilities/filesystem/FileRangeLock.h"
+
+
+using namespace JsonDatabase;
+using namespace JsonDatabase::Internal;
+
+class TST_fileLocks : public UnitTest::Test
+{
+	TEST_CLASS(TST_fileLocks)
+public:
+	TST_fileLocks()
+		: Test("TST_fileLocks")
+	{
+		ADD_TEST(TST_fileLocks::readerWaitsBehindWriter);
+		ADD_TEST(TST_fileLocks::writerTicketOrder);
+		ADD_TEST(TST_fileLocks::staleWriterTicket);
+		ADD_TEST(TST_fileLocks::rangeSlotProbe);
+
+		QDir dir(lockPath.c_str());
+		if (dir.exists())
+			dir.removeRecursively();
+		dir.mkpath(".");
+	}
+
+private:
+	std::string lockPath = "TestLocks";
+	std::string lockName = "data";
+
+	// Ticket file of a writer which waits for the lock
+	std::string getTicketName(unsigned long long ticket)
+	{
+		std::string number = std::to_string(ticket);
+		return lockName + "_wq-" + std::string(20 - number.size(), '0') + number;
+	}
+
+	// Tests
+	TEST_FUNCTION(readerWaitsBehindWriter)
+	{
+		TEST_START;
+		Error err;
+		bool lockedByOther;
+		FileReadWriteLock reader1(lockPath, lockName, nullptr);
+		TEST_ASSERT(reader1.lock(FileReadWriteLock::Access::read, 100, lockedByOther, err));
+
+		// The writer waits for reader1 and holds a ticket meanwhile
+		bool writerLocked = false;
+		std::thread writerThread([&]()
+			{
+				Error writerErr;
+				bool writerLockedByOther;
+				FileReadWriteLock writer(lockPath, lockName, nullptr);
+				writerLocked = writer.lock(FileReadWriteLock::Access::write, 3000, writerLockedByOther, writerErr);
+				writer.unlock(writerErr);
+			});
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+		// A new reader must not pass the queued writer
+		FileReadWriteLock reader2(lockPath, lockName, nullptr);
+		TEST_ASSERT(!reader2.lock(FileReadWriteLock::Access::read, 200, lockedByOther, err));
+		TEST_ASSERT(err == Error::fileLockTimeout);
+
+		reader1.unlock(err);
+		writerThread.join();
+		TEST_ASSERT(writerLocked);
+
+		// The queue is empty again
+		TEST_ASSERT(reader2.lock(FileReadWriteLock::Access::read, 200, lockedByOther, err));
+		reader2.unlock(err);
+	}
+
+	TEST_FUNCTION(writerTicketOrder)
+	{
+		TEST_START;
+		Error err;
+		bool lockedByOther;
+
+		// Writer with the first ticket, which did not get the lock yet
+		FileLock firstTicket(lockPath, getTicketName(1), nullptr);
+		TEST_ASSERT(firstTicket.lock(err));
+
+		FileReadWriteLock writer(lockPath, lockName, nullptr);
+		TEST_ASSERT(!writer.lock(FileReadWriteLock::Access::write, 200, lockedByOther, err));
+		TEST_ASSERT(err == Error::fileLockTimeout);
+
+		// The ticket of the writer is gone after the timeout
+		TEST_ASSERT(!FileLock::fileExists(lockPath, getTicketName(2)));
+
+		firstTicket.unlock(err);
+		TEST_ASSERT(writer.lock(FileReadWriteLock::Access::write, 200, lockedByOther, err));
+		writer.unlock(err);
+	}
+
+	TEST_FUNCTION(staleWriterTicket)
+	{
+		TEST_START;
+		Error err;
+		bool lockedByOther;
+
+		// Ticket of a hung writer, it stays locked
+		FileLock hungTicket(lockPath, getTicketName(1), nullptr);
+		TEST_ASSERT(hungTicket.lock(err));
+
+		FileReadWriteLock reader(lockPath, lockName, nullptr);
+		reader.setWriterTicketLease(100);
+		TEST_ASSERT(reader.lock(FileReadWriteLock::Access::read, 1000, lockedByOther, err));
+		reader.unlock(err);
+
+		hungTicket.unlock(err);
+	}
+
+	TEST_FUNCTION(rangeSlotProbe)
+	{
+		TEST_START;
+		Error err;
+		FileRangeLock owner(lockPath, "slots", nullptr);
+		FileRangeLock other(lockPath, "slots", nullptr);
+		TEST_ASSERT(owner.open(err));
+		TEST_ASSERT(other.open(err));
+
+		TEST_ASSERT(!other.isSlotInUse("obj1"));
+		TEST_ASSERT(owner.lockSlot("obj1", err));
+		TEST_ASSERT(other.isSlotInUse("obj1"));
+		TEST_ASSERT(!other.lockSlot("obj1", err));
+
+		// Probing a free slot must not keep another session from locking it
+		std::atomic<bool> stop = false;
+		std::thread prober([&]()
+			{
+				while (!stop)
+					other.isSlotInUse("obj2");
+			});
+		bool allLocked = true;
+		for (int i = 0; i < 1000; ++i)
+		{
+			Error lockErr;
+			allLocked &= owner.lockSlot("obj2", lockErr);
+			owner.unlockSlot("obj2", lockErr);
+		}
+		stop = true;
+		prober.join();
+		TEST_ASSERT(allLocked);
+
+		owner.unlockSlot("obj1", err);
+		TEST_ASSERT(!other.isSlotInUse("obj1"));
+		other.close();
+		owner.close();
+	}
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QDir>
+#include <thread>
+#include <chrono>
+#include <fstream>
+
+#include "JsonDatabase.h"
+#include "utilities/filesystem/FileChangeWatcher.h"
+#include "utilities/filesystem/LockedFileAccessor.h"
+
+
+using namespace JsonDatabase;
+using namespace JsonDatabase::Internal;
+
+class TST_fileWatcher : public UnitTest::Test
+{
+	TEST_CLASS(TST_fileWatcher)
+public:
+	TST_fileWatcher()
+		: Test("TST_fileWatcher")
+	{
+		ADD_TEST(TST_fileWatcher::writeIncrementsGeneration);
+		ADD_TEST(TST_fileWatcher::pollingDetectsGeneration);
+#ifdef __linux__
+		ADD_TEST(TST_fileWatcher::inotifyChangeBeforePause);
+		ADD_TEST(TST_fileWatcher::inotifyOwnWriteIgnored);
+#endif
+
+		QDir dir(watchPath.c_str());
+		if (dir.exists())
+			dir.removeRecursively();
+		dir.mkpath(".");
+	}
+
+private:
+	std::string watchPath = "TestFileWatcher";
+	std::string fileName = watchPath + "/data.json";
+
+	// Longer than the debounce time of the inotify watcher
+	static constexpr std::chrono::milliseconds s_settleTime{ 300 };
+
+	void writeFile(const std::string& content)
+	{
+		std::ofstream file(fileName, std::ios::trunc);
+		file << content;
+	}
+
+	// Tests
+	TEST_FUNCTION(writeIncrementsGeneration)
+	{
+		TEST_START;
+		LockedFileAccessor accessor(watchPath, "generation", ".json", nullptr);
+		TEST_ASSERT(accessor.lock(LockedFileAccessor::AccessMode::write) == Error::none);
+		std::string filePath = accessor.getFullFilePath();
+		unsigned long long generation = 0;
+
+		TEST_ASSERT(accessor.writeFile(QByteArray("aaaa")) == Error::none);
+		TEST_ASSERT(LockedFileAccessor::readGeneration(filePath, generation));
+		TEST_ASSERT(generation == 1);
+
+		TEST_ASSERT(accessor.writeFile(QByteArray("bbbb")) == Error::none);
+		TEST_ASSERT(LockedFileAccessor::readGeneration(filePath, generation));
+		TEST_ASSERT(generation == 2);
+
+		TEST_ASSERT(accessor.markAsChanged() == Error::none);
+		TEST_ASSERT(LockedFileAccessor::readGeneration(filePath, generation));
+		TEST_ASSERT(generation == 3);
+		TEST_ASSERT(accessor.unlock() == Error::none);
+	}
+	TEST_FUNCTION(pollingDetectsGeneration)
+	{
+		TEST_START;
+		bool contentHash = FileChangeWatcher::isPollingContentHashEnabled();
+		FileChangeWatcher::setPollingContentHashEnabled(false);
+
+		LockedFileAccessor accessor(watchPath, "polling", ".json", nullptr);
+		TEST_ASSERT(accessor.lock(LockedFileAccessor::AccessMode::write) == Error::none);
+		std::string filePath = accessor.getFullFilePath();
+		TEST_ASSERT(accessor.writeFile(QByteArray("aaaa")) == Error::none);
+
+		FileChangeWatcher watcher(filePath);
+		TEST_ASSERT(watcher.setup(nullptr));
+		TEST_ASSERT(watcher.startWatching(FileChangeWatcher::Mode::polling));
+		TEST_ASSERT(!watcher.hasFileChanged());
+
+		// Same size and the same modification time, only the generation tells the change
+		std::error_code ec;
+		std::filesystem::file_time_type modificationTime = std::filesystem::last_write_time(filePath, ec);
+		TEST_ASSERT(!ec);
+		TEST_ASSERT(accessor.writeFile(QByteArray("bbbb")) == Error::none);
+		std::filesystem::last_write_time(filePath, modificationTime, ec);
+		TEST_ASSERT(!ec);
+		TEST_ASSERT(std::filesystem::file_size(filePath) == 4);
+
+		TEST_ASSERT(watcher.hasFileChanged());
+		TEST_ASSERT(accessor.unlock() == Error::none);
+		FileChangeWatcher::setPollingContentHashEnabled(contentHash);
+	}
+#ifdef __linux__
+	TEST_FUNCTION(inotifyChangeBeforePause)
+	{
+		TEST_START;
+		writeFile("initial");
+		FileChangeWatcher watcher(fileName);
+		TEST_ASSERT(watcher.setup(nullptr));
+		TEST_ASSERT(watcher.startWatching(FileChangeWatcher::Mode::inotify));
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		// Another writer changes the file right before this instance pauses the watcher
+		writeFile("other writer");
+		watcher.pause();
+		std::this_thread::sleep_for(s_settleTime);
+		TEST_ASSERT(!watcher.hasFileChanged());
+
+		// The change must not get lost while paused
+		watcher.unpause();
+		std::this_thread::sleep_for(s_settleTime);
+		TEST_ASSERT(watcher.hasFileChanged());
+		watcher.stopWatching();
+	}
+	TEST_FUNCTION(inotifyOwnWriteIgnored)
+	{
+		TEST_START;
+		writeFile("initial");
+		FileChangeWatcher watcher(fileName);
+		TEST_ASSERT(watcher.setup(nullptr));
+		TEST_ASSERT(watcher.startWatching(FileChangeWatcher::Mode::inotify));
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		// Writes of this instance happen while the watcher is paused
+		watcher.pause();
+		writeFile("own write");
+		watcher.unpause();
+		std::this_thread::sleep_for(s_settleTime);
+		TEST_ASSERT(!watcher.hasFileChanged());
+
+		// Later writes of other instances are still reported
+		writeFile("other writer");
+		std::this_thread::sleep_for(s_settleTime);
+		TEST_ASSERT(watcher.hasFileChanged());
+		watcher.stopWatching();
+	}
+#endif
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+#include <fstream>
+#include <unordered_set>
+
+#include "JsonDatabase.h"
+#include "manager/JDIDRangeAllocator.h"
+#include "manager/JDManagerFileSystem.h"
+#include "utilities/JDObjectIDDomain.h"
+#include "Person.h"
+
+
+using namespace JsonDatabase;
+using namespace JsonDatabase::Internal;
+
+class TST_idAllocator : public UnitTest::Test
+{
+	TEST_CLASS(TST_idAllocator)
+public:
+	TST_idAllocator()
+		: Test("TST_idAllocator")
+	{
+		ADD_TEST(TST_idAllocator::disjointBlocks);
+		ADD_TEST(TST_idAllocator::corruptedRecord);
+		ADD_TEST(TST_idAllocator::newIDsFromReservedRange);
+		ADD_TEST(TST_idAllocator::disjointSessionIDs);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+		QDir allocatorDir(allocatorPath.c_str());
+		if (allocatorDir.exists())
+			allocatorDir.removeRecursively();
+		allocatorDir.mkpath(".");
+	}
+
+private:
+	std::string dbPath = "TestIDAllocatorDB";
+	std::string dbName = "DBName";
+	std::string dbUser = "User";
+	std::string allocatorPath = "TestIDAllocator";
+
+	// Tests
+	TEST_FUNCTION(disjointBlocks)
+	{
+		TEST_START;
+		JDIDRangeAllocator session1(allocatorPath, nullptr);
+		JDIDRangeAllocator session2(allocatorPath, nullptr);
+
+		JDObjectID::IDType first1, last1, first2, last2;
+		TEST_ASSERT(session1.reserve(100, JDObjectID::defaultID, 1000, first1, last1));
+		TEST_ASSERT(session2.reserve(100, JDObjectID::defaultID, 1000, first2, last2));
+		TEST_ASSERT(last1 - first1 == 99);
+		TEST_ASSERT(last2 - first2 == 99);
+		TEST_ASSERT(last1 < first2 || last2 < first1);
+
+		// The minimum only moves the next block forward
+		JDObjectID::IDType first3, last3;
+		TEST_ASSERT(session1.reserve(10, 5000, 1000, first3, last3));
+		TEST_ASSERT(first3 == 5000);
+		TEST_ASSERT(session2.reserve(10, JDObjectID::defaultID, 1000, first3, last3));
+		TEST_ASSERT(first3 == 5010);
+	}
+
+	TEST_FUNCTION(corruptedRecord)
+	{
+		TEST_START;
+		std::string path = allocatorPath + "_corrupted";
+		QDir dir(path.c_str());
+		dir.mkpath(".");
+		std::string filePath = path + "\\" + JDIDRangeAllocator::s_fileName + JDManagerFileSystem::getJsonFileEnding();
+
+		JDIDRangeAllocator allocator(path, nullptr);
+		JDObjectID::IDType first, last;
+		for (const std::string& content : { std::string(""), std::string("{\"next\":"), std::string("{}") })
+		{
+			{
+				std::ofstream file(filePath, std::ios::trunc);
+				file << content;
+			}
+			// Starting over would hand out the IDs of other sessions again
+			TEST_ASSERT(!allocator.reserve(10, JDObjectID::defaultID, 1000, first, last));
+		}
+		dir.removeRecursively();
+	}
+
+	TEST_FUNCTION(newIDsFromReservedRange)
+	{
+		TEST_START;
+		JDObjectIDDomain domain;
+		domain.addReservedRange(1000, 1009);
+		TEST_ASSERT(domain.getReservedIDCount() == 10);
+
+		// getNewID() uses the reserved range before the local counter
+		JDObjectIDptr id = domain.getNewID();
+		TEST_ASSERT(id->get() == 1000);
+
+		std::vector<JDObjectIDptr> ids;
+		TEST_ASSERT(domain.getReservedIDs(4, ids));
+		TEST_ASSERT(ids.size() == 4);
+		for (size_t i = 0; i < ids.size(); ++i)
+			TEST_ASSERT(ids[i]->get() == 1001 + (JDObjectID::IDType)i);
+
+		// An ID that got used in the meantime is skipped
+		bool success;
+		JDObjectIDptr loaded = domain.getPredefinedID(1005, success);
+		TEST_ASSERT(success);
+
+		// Not enough IDs left, none is handed out and the rest stays reserved
+		TEST_ASSERT(!domain.getReservedIDs(5, ids));
+		TEST_ASSERT(ids.size() == 0);
+		TEST_ASSERT(domain.getReservedIDCount() == 4);
+		TEST_ASSERT(domain.getReservedIDs(4, ids));
+		TEST_ASSERT(ids[0]->get() == 1006);
+		TEST_ASSERT(ids[3]->get() == 1009);
+		TEST_ASSERT(domain.getReservedIDCount() == 0);
+		TEST_ASSERT(!domain.getReservedIDs(1, ids));
+	}
+
+	TEST_FUNCTION(disjointSessionIDs)
+	{
+		TEST_START;
+		JDManager db1;
+		JDManager db2;
+		TEST_ASSERT(db1.setup(dbPath, dbName, dbUser));
+		TEST_ASSERT(db2.setup(dbPath, dbName, dbUser));
+
+		// Both sessions add objects without loading the objects of the other one
+		std::vector<JDObject> persons1 = createPersons();
+		std::vector<JDObject> persons2 = createPersons();
+		TEST_ASSERT(db1.addObject(persons1));
+		TEST_ASSERT(db2.addObject(persons2));
+		TEST_ASSERT(db1.addObject(createPersons()[0]));
+
+		std::unordered_set<JDObjectID::IDType> ids;
+		for (const JDObject& obj : persons1)
+			TEST_ASSERT(ids.insert(obj->getObjectID()->get()).second);
+		for (const JDObject& obj : persons2)
+			TEST_ASSERT(ids.insert(obj->getObjectID()->get()).second);
+
+		Error err;
+		TEST_ASSERT(db1.unlockAllObjs(err));
+		TEST_ASSERT(db2.unlockAllObjs(err));
+	}
+};
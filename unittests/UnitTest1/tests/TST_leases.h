@@ -0,0 +1,167 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+#include <thread>
+#include <chrono>
+
+#include "JsonDatabase.h"
+#include "utilities/JDLeaseManager.h"
+#include "Item.h"
+
+
+using namespace JsonDatabase;
+
+class TST_leases : public UnitTest::Test
+{
+	TEST_CLASS(TST_leases)
+public:
+	TST_leases()
+		: Test("TST_leases")
+	{
+		ADD_TEST(TST_leases::expiredSessionGetsRemoved);
+		ADD_TEST(TST_leases::lostLockRefusesSave);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+	}
+
+private:
+	std::string dbPath = "TestLeaseDB";
+	std::string dbName = "DBName";
+
+	// Short lease timings for the duration of a test
+	class LeaseTimingScope
+	{
+	public:
+		LeaseTimingScope()
+			: m_heartbeatInterval(Utilities::JDLeaseManager::getHeartbeatInterval())
+			, m_leaseTimeout(Utilities::JDLeaseManager::getLeaseTimeout())
+		{
+			Utilities::JDLeaseManager::setHeartbeatInterval(50);
+			Utilities::JDLeaseManager::setLeaseTimeout(300);
+		}
+		~LeaseTimingScope()
+		{
+			Utilities::JDLeaseManager::setHeartbeatInterval(m_heartbeatInterval);
+			Utilities::JDLeaseManager::setLeaseTimeout(m_leaseTimeout);
+		}
+	private:
+		unsigned int m_heartbeatInterval;
+		unsigned int m_leaseTimeout;
+	};
+
+	template<typename Func>
+	static bool waitFor(Func condition, unsigned int timeoutMs = 5000)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while (!condition())
+		{
+			if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeoutMs))
+				return false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		return true;
+	}
+	static bool isRegistered(const JDManager& db, const std::string& sessionID)
+	{
+		for (const Utilities::JDUser& user : db.getUsers())
+			if (user.getSessionID() == sessionID)
+				return true;
+		return false;
+	}
+
+	// Tests
+	TEST_FUNCTION(expiredSessionGetsRemoved)
+	{
+		TEST_START;
+		LeaseTimingScope timing;
+		Error err;
+		JDManager db1;
+		JDManager db2;
+		TEST_ASSERT(db1.setup(dbPath, dbName + "_expiry", "User1"));
+		TEST_ASSERT(db2.setup(dbPath, dbName + "_expiry", "User2"));
+
+		std::shared_ptr<Item> item = std::make_shared<Item>("leased", "");
+		TEST_ASSERT(db2.addObject(item));
+		TEST_ASSERT(db2.saveObjects());
+		TEST_ASSERT(db1.loadObjects());
+		JDObject loaded = db1.getObject(item->getObjectID()->get());
+		TEST_ASSERT(loaded != nullptr);
+		TEST_ASSERT(db1.isObjectLockedByOther(loaded, err));
+
+		std::string sessionID = db2.getUser().getSessionID();
+		TEST_ASSERT(isRegistered(db1, sessionID));
+
+		// db2 hangs, db1 removes its registration and locks once the lease timed out
+		db2.setLeaseRenewalPaused(true);
+		TEST_ASSERT(waitFor([&] { db1.update(); return !isRegistered(db1, sessionID); }));
+		TEST_ASSERT(!db1.isObjectLocked(loaded, err));
+
+		// db2 notices the lost lease, logs on with a new session and restores its lock
+		db2.setLeaseRenewalPaused(false);
+		TEST_ASSERT(waitFor([&] { db2.update(); return db2.getUser().getSessionID() != sessionID; }));
+		TEST_ASSERT(isRegistered(db1, db2.getUser().getSessionID()));
+		TEST_ASSERT(db2.isObjectLockedByMe(item, err));
+		TEST_ASSERT(waitFor([&] { db1.update(); return db1.isObjectLockedByOther(loaded, err); }));
+
+		TEST_ASSERT(db2.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(lostLockRefusesSave)
+	{
+		TEST_START;
+		LeaseTimingScope timing;
+		Error err;
+		JDManager db1;
+		JDManager db2;
+		TEST_ASSERT(db1.setup(dbPath, dbName + "_lostLock", "User1"));
+		TEST_ASSERT(db2.setup(dbPath, dbName + "_lostLock", "User2"));
+
+		std::shared_ptr<Item> kept = std::make_shared<Item>("kept", "");
+		std::shared_ptr<Item> lost = std::make_shared<Item>("lost", "");
+		TEST_ASSERT(db2.addObject(kept));
+		TEST_ASSERT(db2.addObject(lost));
+		TEST_ASSERT(db2.saveObjects());
+		TEST_ASSERT(db2.isObjectLockedByMe(kept, err));
+		TEST_ASSERT(db2.isObjectLockedByMe(lost, err));
+
+		std::vector<JDObject> lostObjects;
+		QObject::connect(&db2, &JDManager::objectLockLost, [&](std::vector<JDObject> objs)
+						 {
+							 lostObjects.insert(lostObjects.end(), objs.begin(), objs.end());
+						 });
+
+		std::string sessionID = db2.getUser().getSessionID();
+		db2.setLeaseRenewalPaused(true);
+		TEST_ASSERT(waitFor([&] { db1.update(); return !isRegistered(db1, sessionID); }));
+
+		// While db2 hangs, db1 takes over one of its objects
+		JDObjectID::IDType lostID = lost->getObjectID()->get();
+		TEST_ASSERT(db1.lockIDRange(lostID, lostID, err));
+
+		kept->name = "changed";
+		lost->name = "changed";
+		db2.setLeaseRenewalPaused(false);
+		TEST_ASSERT(waitFor([&] { db2.update(); return lostObjects.size() > 0; }));
+
+		// Only the object that was locked by db1 in the meantime is lost
+		TEST_ASSERT(lostObjects.size() == 1);
+		TEST_ASSERT(lostObjects[0] == lost);
+		TEST_ASSERT(!db2.isObjectLockedByMe(lost, err));
+		TEST_ASSERT(db2.isObjectLockedByMe(kept, err));
+		TEST_ASSERT(!db2.saveObject(lost));
+		TEST_ASSERT(lost->hasChanges());
+		TEST_ASSERT(db2.saveObject(kept));
+		TEST_ASSERT(!kept->hasChanges());
+
+		TEST_ASSERT(db1.unlockIDRange(lostID, lostID, err));
+		TEST_ASSERT(db2.unlockAllObjs(err));
+	}
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+
+#include "JsonDatabase.h"
+#include "utilities/filesystem/LockedFileAccessor.h"
+#include "Item.h"
+
+
+using namespace JsonDatabase;
+using namespace JsonDatabase::Internal;
+
+class TST_loadObjects : public UnitTest::Test
+{
+	TEST_CLASS(TST_loadObjects)
+public:
+	TST_loadObjects()
+		: Test("TST_loadObjects")
+	{
+		ADD_TEST(TST_loadObjects::parallelMatchesSerial);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+	}
+
+private:
+	std::string dbPath = "TestLoadDB";
+	std::string dbName = "DBName";
+
+	struct LoadResult
+	{
+		std::vector<JDObjectID::IDType> addedIDs;
+		std::vector<std::string> names;
+		size_t objectCount = 0;
+	};
+	bool loadWithThreads(unsigned int threadCount, LoadResult& resultOut)
+	{
+		JDManager reader;
+		if (!reader.setup(dbPath, dbName, "Reader"))
+			return false;
+		reader.setLoadThreadCount(threadCount);
+		QObject::connect(&reader, &JDManager::objectAdded, [&](std::vector<JDObject> objs)
+						 {
+							 for (const JDObject& obj : objs)
+								 resultOut.addedIDs.push_back(obj->getObjectID()->get());
+						 });
+		if (!reader.loadObjects())
+			return false;
+		reader.update();
+
+		resultOut.objectCount = reader.getObjectCount();
+		for (const JDObjectID::IDType& id : resultOut.addedIDs)
+		{
+			std::shared_ptr<Item> item = reader.getObject<Item>(id);
+			resultOut.names.push_back(item ? (std::string)item->name : "");
+		}
+		return true;
+	}
+
+	// Tests
+	TEST_FUNCTION(parallelMatchesSerial)
+	{
+		TEST_START;
+		const size_t count = 250;
+		std::vector<JDObject> items;
+		std::vector<JDObjectID::IDType> expectedIDs;
+		std::vector<std::string> expectedNames;
+		{
+			JDManager writer;
+			TEST_ASSERT(writer.setup(dbPath, dbName, "Writer"));
+			for (size_t i = 0; i < count; ++i)
+				items.push_back(std::make_shared<Item>("item" + std::to_string(i), "description" + std::to_string(i)));
+			TEST_ASSERT(writer.addObject(items));
+			TEST_ASSERT(writer.saveObjects());
+			Error err;
+			TEST_ASSERT(writer.unlockAllObjs(err));
+
+			// The same IDs a second time, in other ranges of the array than their first entries
+			LockedFileAccessor accessor(writer.getDatabasePath(), writer.getDatabaseFileName(), JDManager::getJsonFileEnding(), nullptr);
+			TEST_ASSERT(accessor.lock(LockedFileAccessor::AccessMode::readWrite) == Error::none);
+			JsonArray jsons;
+			TEST_ASSERT(accessor.readJsonFile(jsons) == Error::none);
+			TEST_ASSERT(jsons.size() == count);
+			for (const JsonValue& json : jsons)
+			{
+				const JsonObject& obj = json.get<JsonObject>();
+				expectedIDs.push_back(obj.at(JDObjectInterface::s_tag_objID).get<JDObjectID::IDType>());
+				expectedNames.push_back(obj.at(JDObjectInterface::s_tag_data).get<JsonObject>().at("name").get<std::string>());
+			}
+			for (size_t index : { (size_t)10, count - 10 })
+			{
+				expectedNames[index] = "duplicate";
+				JsonObject duplicate = jsons[index].get<JsonObject>();
+				duplicate[JDObjectInterface::s_tag_data].get<JsonObject>()["name"] = JsonValue(std::string("duplicate"));
+				jsons.push_back(JsonValue(duplicate));
+			}
+			TEST_ASSERT(accessor.writeJsonFile(jsons) == Error::none);
+			TEST_ASSERT(accessor.unlock() == Error::none);
+		}
+
+		LoadResult serial;
+		LoadResult parallel;
+		TEST_ASSERT(loadWithThreads(1, serial));
+		TEST_ASSERT(loadWithThreads(4, parallel));
+
+		// Each ID is loaded once, at the position of its first entry with the data of its last entry
+		TEST_ASSERT(serial.objectCount == count);
+		TEST_ASSERT(parallel.objectCount == count);
+		TEST_ASSERT(serial.addedIDs == expectedIDs);
+		TEST_ASSERT(serial.names == expectedNames);
+
+		// The threads don't change the objects or the order of the signals
+		TEST_ASSERT(parallel.addedIDs == serial.addedIDs);
+		TEST_ASSERT(parallel.names == serial.names);
+	}
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <QDir>
+
+#include "JsonDatabase.h"
+#include "utilities/filesystem/AbstractRegistry.h"
+#include "Person.h"
+
+
+using namespace JsonDatabase;
+
+class TST_locks : public UnitTest::Test
+{
+	TEST_CLASS(TST_locks)
+public:
+	TST_locks()
+		: Test("TST_locks")
+	{
+		ADD_TEST(TST_locks::allOrNothingAlreadyLocked);
+		ADD_TEST(TST_locks::intentionLockConflicts);
+		ADD_TEST(TST_locks::saveUnderClassLock);
+		ADD_TEST(TST_locks::rangeLockFileOptIn);
+
+		// Delete the Database
+		QDir dbDir(dbPath.c_str());
+		if (dbDir.exists())
+		{
+			dbDir.removeRecursively();
+		}
+	}
+
+private:
+	std::string dbPath = "TestLockDB";
+	std::string dbName = "DBName";
+	std::string dbUser = "User";
+
+	// Tests
+	TEST_FUNCTION(allOrNothingAlreadyLocked)
+	{
+		TEST_START;
+		JDManager db;
+		TEST_ASSERT(db.setup(dbPath, dbName, dbUser));
+
+		std::vector<JDObject> persons = createPersons();
+		TEST_ASSERT(db.addObject(persons));
+
+		Error err;
+		TEST_ASSERT(db.lockObject(persons[0], err));
+
+		// persons[0] is already locked, the batch must not lock any other object
+		std::vector<Error> errors;
+		TEST_ASSERT(!db.lockObjects(persons, errors, true));
+		TEST_ASSERT(errors[0] == Error::objectAlreadyLocked);
+		for (size_t i = 1; i < persons.size(); ++i)
+		{
+			TEST_ASSERT(errors[i] == Error::objectLockBatchAborted);
+			TEST_ASSERT(!persons[i]->isLocked());
+		}
+
+		TEST_ASSERT(db.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(intentionLockConflicts)
+	{
+		TEST_START;
+		Error err;
+		JDManager db1;
+		JDManager db2;
+		TEST_ASSERT(db1.setup(dbPath, dbName, dbUser));
+		TEST_ASSERT(db2.setup(dbPath, dbName, dbUser));
+
+		std::vector<JDObject> persons = createPersons();
+		TEST_ASSERT(db1.addObject(persons));
+		TEST_ASSERT(db1.lockAllObjs(err));
+		TEST_ASSERT(db1.saveObjects());
+		TEST_ASSERT(db1.unlockAllObjs(err));
+
+		const std::string className = persons[0]->className();
+		JDObjectID::IDType id = persons[0]->getObjectID()->get();
+
+		// db2 has not loaded any object, the class of the locked ID is unknown to it
+		TEST_ASSERT(db1.lockIDRange(id, id, err));
+		TEST_ASSERT(!db2.lockClass(className, err));
+		TEST_ASSERT(err == Error::objectLockedByOther);
+		TEST_ASSERT(db1.unlockIDRange(id, id, err));
+
+		TEST_ASSERT(db2.lockClass(className, err));
+		TEST_ASSERT(!db1.lockIDRange(id, id, err));
+		TEST_ASSERT(err == Error::objectLockedByOther);
+		TEST_ASSERT(!db1.lockObject(persons[0], err));
+		TEST_ASSERT(err == Error::objectLockedByOther);
+		TEST_ASSERT(db2.unlockClass(className, err));
+
+		// An object lock of another session conflicts with a range that covers it
+		TEST_ASSERT(db2.loadObjects());
+		TEST_ASSERT(db2.lockObject(db2.getObject(id), err));
+		TEST_ASSERT(!db1.lockIDRange(id, id, err));
+		TEST_ASSERT(err == Error::objectLockedByOther);
+		TEST_ASSERT(db2.unlockAllObjs(err));
+	}
+
+	TEST_FUNCTION(saveUnderClassLock)
+	{
+		TEST_START;
+		Error err;
+		JDManager db1;
+		JDManager db2;
+		TEST_ASSERT(db1.setup(dbPath, dbName + "_classLock", dbUser));
+		TEST_ASSERT(db2.setup(dbPath, dbName + "_classLock", dbUser));
+
+		// The new objects are dirty and only covered by the class lock
+		std::vector<JDObject> persons = createPersons();
+		TEST_ASSERT(db1.addObject(persons));
+		TEST_ASSERT(db1.unlockAllObjs(err));
+		const std::string className = persons[0]->className();
+		TEST_ASSERT(db1.lockClass(className, err));
+		TEST_ASSERT(persons[0]->hasChanges());
+
+		TEST_ASSERT(db1.saveObjects());
+		for (const JDObject& person : persons)
+			TEST_ASSERT(!person->hasChanges());
+		TEST_ASSERT(db1.unlockClass(className, err));
+
+		TEST_ASSERT(db2.loadObjects());
+		TEST_ASSERT(db2.getObjectCount() == persons.size());
+	}
+
+	TEST_FUNCTION(rangeLockFileOptIn)
+	{
+		TEST_START;
+		// The lock files stay readable for older versions, unless the range lock file is requested
+		TEST_ASSERT(Utilities::AbstractRegistry::getDefaultLockMode() == Utilities::AbstractRegistry::LockMode::lockFilePerObject);
+		Utilities::AbstractRegistry::setDefaultLockMode(Utilities::AbstractRegistry::LockMode::rangeLockFile);
+		{
+			Error err;
+			JDManager db1;
+			JDManager db2;
+			TEST_ASSERT(db1.setup(dbPath, dbName + "_rangeLockFile", dbUser));
+			TEST_ASSERT(db2.setup(dbPath, dbName + "_rangeLockFile", dbUser));
+
+			std::vector<JDObject> persons = createPersons();
+			TEST_ASSERT(db1.addObject(persons));
+			TEST_ASSERT(db1.saveObjects());
+
+			TEST_ASSERT(db2.loadObjects());
+			TEST_ASSERT(!db2.lockObject(db2.getObject(persons[0]->getObjectID()->get()), err));
+			TEST_ASSERT(err == Error::objectLockedByOther);
+			TEST_ASSERT(db1.unlockAllObjs(err));
+			TEST_ASSERT(db2.lockObject(db2.getObject(persons[0]->getObjectID()->get()), err));
+			TEST_ASSERT(db2.unlockAllObjs(err));
+		}
+		Utilities::AbstractRegistry::setDefaultLockMode(Utilities::AbstractRegistry::LockMode::lockFilePerObject);
+	}
+};
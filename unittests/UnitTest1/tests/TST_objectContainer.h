@@ -0,0 +1,152 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+
+
+#include "JsonDatabase.h"
+#include "object/JDFlatIndex.h"
+#include "object/JDObjectContainer.h"
+#include "utilities/JDIDRangeSet.h"
+#include "utilities/JDObjectIDDomain.h"
+#include "Person.h"
+
+
+class TST_objectContainer : public UnitTest::Test
+{
+	TEST_CLASS(TST_objectContainer)
+public:
+	TST_objectContainer()
+		: Test("TST_objectContainer")
+	{
+		ADD_TEST(TST_objectContainer::flatIndex);
+		ADD_TEST(TST_objectContainer::idRangeSet);
+		ADD_TEST(TST_objectContainer::containerRemove);
+
+	}
+
+private:
+	using JDObjectContainer = JsonDatabase::Internal::JDObjectContainer;
+	using JDObjectManager = JsonDatabase::Internal::JDObjectManager;
+
+	// Tests
+	TEST_FUNCTION(flatIndex)
+	{
+		TEST_START;
+		using JsonDatabase::Internal::JDFlatIndex;
+		JDFlatIndex<long> index;
+
+		for (long i = 0; i < 1000; ++i)
+			TEST_ASSERT(index.insert(i, static_cast<size_t>(i)));
+		TEST_ASSERT(!index.insert(10, 0));
+		TEST_ASSERT(index.size() == 1000);
+
+		// Remove every second key, the remaining ones must still be found
+		for (long i = 0; i < 1000; i += 2)
+			TEST_ASSERT(index.erase(i));
+		for (long i = 0; i < 1000; ++i)
+		{
+			size_t slot = index.find(i);
+			if (i % 2 == 0)
+				TEST_ASSERT(slot == index.npos);
+			else
+				TEST_ASSERT(slot == static_cast<size_t>(i));
+		}
+		TEST_ASSERT(index.update(1, 5));
+		TEST_ASSERT(index.find(1) == 5);
+		TEST_ASSERT(!index.update(0, 5));
+		TEST_ASSERT(index.size() == 500);
+	}
+
+	TEST_FUNCTION(idRangeSet)
+	{
+		TEST_START;
+		using JsonDatabase::Internal::JDIDRangeSet;
+		JDIDRangeSet<long> set;
+
+		// Sequential IDs end up in one range
+		for (long i = 0; i < 1000; ++i)
+			TEST_ASSERT(set.insert(i));
+		TEST_ASSERT(!set.insert(500));
+		TEST_ASSERT(set.size() == 1000);
+		TEST_ASSERT(set.rangeCount() == 1);
+
+		// Erasing in the middle splits the range, inserting it again merges it
+		TEST_ASSERT(set.erase(500));
+		TEST_ASSERT(!set.erase(500));
+		TEST_ASSERT(!set.contains(500));
+		TEST_ASSERT(set.contains(499));
+		TEST_ASSERT(set.contains(501));
+		TEST_ASSERT(set.rangeCount() == 2);
+		TEST_ASSERT(set.insert(500));
+		TEST_ASSERT(set.rangeCount() == 1);
+
+		long max = 0;
+		TEST_ASSERT(set.getMax(max));
+		TEST_ASSERT(max == 999);
+		TEST_ASSERT(set.insert(2000));
+		TEST_ASSERT(set.getMax(max));
+		TEST_ASSERT(max == 2000);
+		TEST_ASSERT(set.rangeCount() == 2);
+		TEST_ASSERT(set.size() == 1001);
+	}
+
+	TEST_FUNCTION(containerRemove)
+	{
+		TEST_START;
+		JDObjectIDDomain domain;
+		std::vector<JDObjectManager*> managers = createManagers(domain, 10);
+		JDObjectContainer container;
+		TEST_ASSERT(container.addObject(managers));
+		TEST_ASSERT(container.isConsistent());
+
+		// Removing from the middle moves the last slot into the gap
+		TEST_ASSERT(container.removeObject(managers[4]));
+		TEST_ASSERT(container.size() == 9);
+		TEST_ASSERT(container.getObjectByID(managers[4]->getID()) == nullptr);
+		TEST_ASSERT(container[4] == managers[9]);
+		TEST_ASSERT(container.getObjectByID(managers[9]->getID()) == managers[9]);
+		TEST_ASSERT(container.exists(managers[9]->getObject()));
+		TEST_ASSERT(!container.removeObject(managers[4]));
+		TEST_ASSERT(container.isConsistent());
+
+		// Removing the last slot does not move anything
+		TEST_ASSERT(container.removeObject(managers[8]));
+		TEST_ASSERT(container.size() == 8);
+		TEST_ASSERT(container[7] == managers[7]);
+		TEST_ASSERT(container.isConsistent());
+
+		// The type bucket follows every removal and is gone with the last object
+		const std::string& className = managers[0]->getObject()->className();
+		const JDObjectContainer::TypeBucket* bucket = container.getClassBucket(className);
+		TEST_ASSERT(bucket != nullptr);
+		TEST_ASSERT(bucket->objects.size() == 8);
+		const size_t order[] = { 0, 9, 5, 1, 7, 2, 6, 3 };
+		for (size_t i : order)
+		{
+			TEST_ASSERT(container.removeObject(managers[i]));
+			TEST_ASSERT(container.isConsistent());
+		}
+		TEST_ASSERT(container.size() == 0);
+		TEST_ASSERT(container.getClassBucket(className) == nullptr);
+		TEST_ASSERT(container.getTypeBucket(typeid(Person)) == nullptr);
+
+		for (JDObjectManager* manager : managers)
+			delete manager;
+	}
+
+	std::vector<JDObjectManager*> createManagers(JDObjectIDDomain& domain, size_t count)
+	{
+		std::vector<JDObjectID::IDType> ids(count);
+		for (size_t i = 0; i < count; ++i)
+			ids[i] = static_cast<JDObjectID::IDType>(i);
+		bool success = false;
+		std::vector<JDObjectIDptr> idPtrs = domain.getPredefinedIDs(ids, success);
+		std::vector<JDObjectManager*> managers(count);
+		for (size_t i = 0; i < count; ++i)
+			managers[i] = new JDObjectManager(nullptr, std::make_shared<Person>(), idPtrs[i], nullptr);
+		return managers;
+	}
+
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "UnitTest.h"
+#include <QObject>
+#include <QCoreapplication>
+#include <chrono>
+
+
+#include "JsonDatabase.h"
+#include "object/JDObjectContainer.h"
+#include "utilities/JDObjectIDDomain.h"
+#include "Person.h"
+
+
+// Not part of the default test run, instantiate it in main.cpp to measure the container.
+class TST_objectContainerBenchmark : public UnitTest::Test
+{
+	TEST_CLASS(TST_objectContainerBenchmark)
+public:
+	TST_objectContainerBenchmark()
+		: Test("TST_objectContainerBenchmark")
+	{
+		ADD_TEST(TST_objectContainerBenchmark::addLookupRemove);
+	}
+
+private:
+	using JDObjectContainer = JsonDatabase::Internal::JDObjectContainer;
+	using JDObjectManager = JsonDatabase::Internal::JDObjectManager;
+
+	static constexpr size_t s_benchmarkCount = 1000000;
+
+	// Tests
+	TEST_FUNCTION(addLookupRemove)
+	{
+		TEST_START;
+		JDObjectIDDomain domain;
+		std::vector<JDObjectID::IDType> ids(s_benchmarkCount);
+		for (size_t i = 0; i < s_benchmarkCount; ++i)
+			ids[i] = static_cast<JDObjectID::IDType>(i);
+		bool idSuccess = false;
+		std::vector<JDObjectIDptr> idPtrs = domain.getPredefinedIDs(ids, idSuccess);
+		TEST_ASSERT(idSuccess);
+		std::vector<JDObjectManager*> managers(s_benchmarkCount);
+		for (size_t i = 0; i < s_benchmarkCount; ++i)
+			managers[i] = new JDObjectManager(nullptr, std::make_shared<Person>(), idPtrs[i], nullptr);
+
+		JDObjectContainer container;
+		auto t0 = std::chrono::high_resolution_clock::now();
+		for (JDObjectManager* manager : managers)
+			container.addObject(manager);
+		auto t1 = std::chrono::high_resolution_clock::now();
+		TEST_MESSAGE("Add            " + std::to_string(s_benchmarkCount) + ": " + getMs(t0, t1));
+		TEST_ASSERT(container.size() == s_benchmarkCount);
+
+		size_t found = 0;
+		t0 = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < s_benchmarkCount; ++i)
+			found += (container.getObjectByID(ids[i]) == managers[i]);
+		t1 = std::chrono::high_resolution_clock::now();
+		TEST_MESSAGE("Lookup by ID   " + std::to_string(s_benchmarkCount) + ": " + getMs(t0, t1));
+		TEST_ASSERT(found == s_benchmarkCount);
+
+		found = 0;
+		t0 = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < s_benchmarkCount; ++i)
+			found += (container.getObjectByPtr(managers[i]->getObject().get()) == managers[i]);
+		t1 = std::chrono::high_resolution_clock::now();
+		TEST_MESSAGE("Lookup by ptr  " + std::to_string(s_benchmarkCount) + ": " + getMs(t0, t1));
+		TEST_ASSERT(found == s_benchmarkCount);
+
+		// Every second object first, so most removals move the last slot into the gap
+		t0 = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < s_benchmarkCount; i += 2)
+			container.removeObject(managers[i]);
+		for (size_t i = 1; i < s_benchmarkCount; i += 2)
+			container.removeObject(managers[i]);
+		t1 = std::chrono::high_resolution_clock::now();
+		TEST_MESSAGE("Remove         " + std::to_string(s_benchmarkCount) + ": " + getMs(t0, t1));
+		TEST_ASSERT(container.size() == 0);
+		TEST_ASSERT(container.isConsistent());
+
+		for (JDObjectManager* manager : managers)
+			delete manager;
+	}
+
+	static std::string getMs(const std::chrono::high_resolution_clock::time_point& start,
+							 const std::chrono::high_resolution_clock::time_point& end)
+	{
+		return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()) + "ms";
+	}
+};